@@ -0,0 +1,157 @@
+#ifndef __SPLC_AST_ASTARENA_HH__
+#define __SPLC_AST_ASTARENA_HH__ 1
+
+#include <Core/splc.hh>
+#include <cstddef>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace splc {
+
+///
+/// \brief Class ASTArena is a bump allocator that owns the storage of all AST
+/// nodes created for a single translation unit.
+///
+/// Nodes (together with their reference-counting control blocks) are carved
+/// out of large chunks, and the chunks are released in one step when the
+/// arena is destroyed. Deallocation of an individual node is a no-op.
+///
+/// All nodes allocated from an arena must be released before the arena
+/// itself is destroyed. `TranslationUnit` guarantees this for the nodes it
+/// owns by declaring its arena before any member that holds AST nodes, and
+/// the arena checks it on destruction. Code that walks the tree should borrow
+/// nodes by reference instead of holding on to them.
+///
+class ASTArena {
+  public:
+    static constexpr size_t defaultChunkSize = 64 * 1024;
+
+    ASTArena(size_t chunkSize_ = defaultChunkSize) noexcept
+        : chunkSize{chunkSize_}
+    {
+    }
+
+    ASTArena(const ASTArena &other) = delete;
+    ASTArena &operator=(const ASTArena &other) = delete;
+
+    ~ASTArena() noexcept;
+
+    /// Allocate `n` bytes aligned to `align`.
+    void *allocate(size_t n, size_t align)
+    {
+        size_t offset = (cur + align - 1) & ~(align - 1);
+        if (chunks.empty() || offset + n > curChunkSize) {
+            newChunk(n + align);
+            offset = (cur + align - 1) & ~(align - 1);
+        }
+        cur = offset + n;
+        bytesAllocated += n;
+        ++numLiveAllocations;
+        return chunks.back() + offset;
+    }
+
+    /// Release storage obtained from `allocate`. The memory itself is only
+    /// reclaimed along with the arena.
+    void deallocate(void *, size_t) noexcept { --numLiveAllocations; }
+
+    size_t getBytesAllocated() const noexcept { return bytesAllocated; }
+
+    /// Number of allocations that have not been released yet.
+    size_t getNumLiveAllocations() const noexcept { return numLiveAllocations; }
+
+    size_t getNumChunks() const noexcept { return chunks.size(); }
+
+    /// Arena used by `makeASTNode` on the current thread, if any.
+    static ASTArena *getActiveArena() noexcept { return activeArena; }
+
+    ///
+    /// \brief Make `arena` the active arena of the current thread for the
+    /// lifetime of this object.
+    ///
+    class ActiveScope {
+      public:
+        ActiveScope(ASTArena *arena) noexcept : prevArena{activeArena}
+        {
+            activeArena = arena;
+        }
+
+        ActiveScope(const ActiveScope &other) = delete;
+        ActiveScope &operator=(const ActiveScope &other) = delete;
+
+        ~ActiveScope() noexcept { activeArena = prevArena; }
+
+      private:
+        ASTArena *prevArena;
+    };
+
+  private:
+    void newChunk(size_t minSize);
+
+    size_t chunkSize;
+    size_t curChunkSize = 0;
+    size_t cur = 0;
+    size_t bytesAllocated = 0;
+    size_t numLiveAllocations = 0;
+    std::vector<char *> chunks;
+
+    static thread_local ASTArena *activeArena;
+};
+
+///
+/// \brief Standard allocator adaptor over `ASTArena`, suitable for
+/// `std::allocate_shared`.
+///
+template <class T>
+class ASTArenaAllocator {
+  public:
+    using value_type = T;
+
+    ASTArenaAllocator(ASTArena *arena_) noexcept : arena{arena_} {}
+
+    template <class U>
+    ASTArenaAllocator(const ASTArenaAllocator<U> &other) noexcept
+        : arena{other.arena}
+    {
+    }
+
+    T *allocate(size_t n)
+    {
+        return static_cast<T *>(arena->allocate(n * sizeof(T), alignof(T)));
+    }
+
+    void deallocate(T *p, size_t n) noexcept
+    {
+        arena->deallocate(p, n * sizeof(T));
+    }
+
+    template <class U>
+    bool operator==(const ASTArenaAllocator<U> &other) const noexcept
+    {
+        return arena == other.arena;
+    }
+
+  private:
+    template <class U>
+    friend class ASTArenaAllocator;
+
+    ASTArena *arena;
+};
+
+///
+/// \brief Create an AST node. The node is placed in the active arena of the
+/// current thread if there is one, and on the heap otherwise.
+///
+template <class T, class... Args>
+Ptr<T> makeASTNode(Args &&...args)
+{
+    if (ASTArena *arena = ASTArena::getActiveArena()) {
+        return std::allocate_shared<T>(ASTArenaAllocator<T>{arena},
+                                       std::forward<Args>(args)...);
+    }
+    return makeSharedPtr<T>(std::forward<Args>(args)...);
+}
+
+} // namespace splc
+
+#endif // __SPLC_AST_ASTARENA_HH__
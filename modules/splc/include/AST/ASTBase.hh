@@ -1,6 +1,7 @@
 #ifndef __SPLC_AST_ASTBASE_HH__
 #define __SPLC_AST_ASTBASE_HH__ 1
 
+#include <AST/ASTArena.hh>
 #include <AST/ASTCommons.hh>
 #include <AST/Value.hh>
 #include <Core/splc.hh>
@@ -95,7 +96,7 @@ class AST : public std::enable_shared_from_this<AST> {
     static PtrAST make(ASTSymType type, const Location &loc,
                        Children &&...children)
     {
-        PtrAST parentNode = makeSharedPtr<AST>(type, loc);
+        PtrAST parentNode = makeASTNode<AST>(type, loc);
         parentNode->addChildren(std::forward<Children>(children)...);
         return parentNode;
     }
@@ -104,8 +105,7 @@ class AST : public std::enable_shared_from_this<AST> {
     static PtrAST make(ASTSymType type, const Location &loc, T &&value,
                        Children &&...children)
     {
-        PtrAST parentNode =
-            makeSharedPtr<AST>(type, loc, std::forward<T>(value));
+        PtrAST parentNode = makeASTNode<AST>(type, loc, std::forward<T>(value));
         parentNode->addChildren(std::forward<Children>(children)...);
         return parentNode;
     }
@@ -114,7 +114,7 @@ class AST : public std::enable_shared_from_this<AST> {
     static PtrAST make(SPLCContext &C, ASTSymType type, const Location &loc,
                        Children &&...children)
     {
-        PtrAST parentNode = makeSharedPtr<AST>(C, type, loc);
+        PtrAST parentNode = makeASTNode<AST>(C, type, loc);
         parentNode->addChildren(std::forward<Children>(children)...);
         return parentNode;
     }
@@ -124,7 +124,7 @@ class AST : public std::enable_shared_from_this<AST> {
                        T &&value, Children &&...children)
     {
         PtrAST parentNode =
-            makeSharedPtr<AST>(C, type, loc, std::forward<T>(value));
+            makeASTNode<AST>(C, type, loc, std::forward<T>(value));
         parentNode->addChildren(std::forward<Children>(children)...);
         return parentNode;
     }
@@ -133,7 +133,7 @@ class AST : public std::enable_shared_from_this<AST> {
     static Ptr<ASTTypeLike> makeDerived(const Location &loc,
                                         Children &&...children)
     {
-        Ptr<ASTTypeLike> parentNode = makeSharedPtr<ASTTypeLike>(loc);
+        Ptr<ASTTypeLike> parentNode = makeASTNode<ASTTypeLike>(loc);
         parentNode->addChildren(std::forward<Children>(children)...);
         return parentNode;
     }
@@ -142,7 +142,7 @@ class AST : public std::enable_shared_from_this<AST> {
     static Ptr<ASTTypeLike> makeDerived(SPLCContext &C, const Location &loc,
                                         Children &&...children)
     {
-        Ptr<ASTTypeLike> parentNode = makeSharedPtr<ASTTypeLike>(C, loc);
+        Ptr<ASTTypeLike> parentNode = makeASTNode<ASTTypeLike>(C, loc);
         parentNode->addChildren(std::forward<Children>(children)...);
         return parentNode;
     }
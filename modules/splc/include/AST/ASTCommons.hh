@@ -108,7 +108,6 @@ enum class SymEntryType {
 std::ostream &operator<<(std::ostream &os, SymEntryType ty) noexcept;
 
 class SymbolEntry;
-using ASTSymbolMap = std::map<ASTIDType, SymbolEntry, std::less<>>;
 
 class SymbolTable;
 
@@ -10,17 +10,25 @@
 
 #include "AST/ASTCommons.hh"
 #include "AST/SymbolEntry.hh"
+#include "AST/SymbolTable.hh"
 
 namespace splc {
 
 /// \brief `ASTContext` describes declarations in a particular scope.
 class ASTContext {
   public:
-    ASTContext(ASTContextDepthType depth_) : depth{depth_} {}
+    ASTContext(ASTContextDepthType depth_,
+               Ptr<SymbolStringPool> symbolPool_ = nullptr)
+        : depth{depth_}, symbolPool{symbolPool_ != nullptr
+                                        ? symbolPool_
+                                        : makeSharedPtr<SymbolStringPool>()}
+    {
+    }
 
     ASTContext(ASTContextDepthType depth_,
-               const std::vector<Ptr<ASTContext>> &parentContexts_)
-        : depth{depth_}
+               const std::vector<Ptr<ASTContext>> &parentContexts_,
+               Ptr<SymbolStringPool> symbolPool_ = nullptr)
+        : ASTContext{depth_, symbolPool_}
     {
         parentContexts.reserve(parentContexts_.size());
         std::transform(
@@ -33,14 +41,25 @@ class ASTContext {
 
     void setDepth(ASTContextDepthType depth_) noexcept { depth = depth_; }
 
-    auto &getSymbolMap() { return symbolMap; }
-
-    const auto &getSymbolMap() const { return symbolMap; }
+    auto &getSymbolPool() const noexcept { return symbolPool; }
 
     auto &getSymbolList() { return symbolList; }
 
     const auto &getSymbolList() const { return symbolList; }
 
+    /// \brief Interned IDs of the symbols, parallel to `getSymbolList()`.
+    const auto &getSymbolIDList() const { return symbolIDList; }
+
+    ///
+    /// \brief Find the entry of an interned identifier in this scope only.
+    /// \return `nullptr` if `id` is not declared in this scope.
+    ///
+    const SymbolEntry *findSymbol(SymbolID id) const noexcept
+    {
+        uint32_t idx = symbolTable.find(id);
+        return idx == SymbolTable::npos ? nullptr : &symbolList[idx].second;
+    }
+
     bool isSymDeclared(SymEntryType symEntTy_,
                        std::string_view name_) const noexcept;
 
@@ -77,8 +96,11 @@ class ASTContext {
 
   protected:
     ASTContextDepthType depth;
-    ASTSymbolMap symbolMap;
-    std::vector<std::pair<ASTIDType, SymbolEntry>> symbolList;
+    Ptr<SymbolStringPool> symbolPool; ///< Shared by all scopes of a unit
+    SymbolTable symbolTable; ///< Interned identifier -> index in symbolList
+    std::vector<std::pair<ASTIDType, SymbolEntry>>
+        symbolList; ///< Symbols in declaration order
+    std::vector<SymbolID> symbolIDList; ///< Interned IDs of symbolList
     std::vector<WeakPtr<ASTContext>> parentContexts;
     std::vector<Ptr<ASTContext>> directChildren;
 
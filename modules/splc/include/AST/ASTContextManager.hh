@@ -31,8 +31,8 @@ class ASTContextManager {
     ///
     Ptr<ASTContext> pushContext() noexcept
     {
-        auto context =
-            makeSharedPtr<ASTContext>(contextStack.size(), contextStack);
+        auto context = makeSharedPtr<ASTContext>(contextStack.size(),
+                                                 contextStack, symbolPool);
         if (!contextStackEmpty())
             contextStack.back()->getDirectChildren().push_back(context);
         contextStack.push_back(context);
@@ -49,6 +49,14 @@ class ASTContextManager {
         return context;
     }
 
+    ///
+    /// \brief Find the innermost visible declaration of `name_`, walking the
+    /// scope chain from the top of the stack. Inner declarations shadow outer
+    /// ones.
+    /// \return `nullptr` if `name_` is not visible.
+    ///
+    const SymbolEntry *lookupSymbol(std::string_view name_) const noexcept;
+
     bool isSymDeclared(SymEntryType symEntTy_,
                        std::string_view name_) const noexcept;
 
@@ -94,8 +102,11 @@ class ASTContextManager {
 
     size_t contextStackSize() const noexcept { return contextStack.size(); }
 
+    auto &getSymbolPool() const noexcept { return symbolPool; }
+
   protected:
     std::vector<Ptr<ASTContext>> contextStack;
+    Ptr<SymbolStringPool> symbolPool = makeSharedPtr<SymbolStringPool>();
 };
 
 } // namespace splc
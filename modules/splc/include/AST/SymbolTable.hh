@@ -0,0 +1,111 @@
+#ifndef __SPLC_AST_SYMBOLTABLE_HH__
+#define __SPLC_AST_SYMBOLTABLE_HH__ 1
+
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "AST/ASTCommons.hh"
+#include "Core/splc.hh"
+
+namespace splc {
+
+/// \brief Interned identifier. IDs are dense and start from 0.
+using SymbolID = uint32_t;
+
+static constexpr SymbolID invalidSymbolID = UINT32_MAX;
+
+///
+/// \brief `SymbolStringPool` interns identifiers of a translation unit, such
+/// that each distinct name is hashed and stored exactly once.
+///
+class SymbolStringPool {
+  public:
+    SymbolStringPool() = default;
+    SymbolStringPool(const SymbolStringPool &other) = delete;
+    SymbolStringPool &operator=(const SymbolStringPool &other) = delete;
+
+    ///
+    /// \brief Intern `name`, returning the existing ID if it has been interned
+    /// before.
+    ///
+    SymbolID intern(std::string_view name);
+
+    ///
+    /// \brief Find the ID of `name` without interning it.
+    /// \return `invalidSymbolID` if `name` has never been interned.
+    ///
+    SymbolID find(std::string_view name) const noexcept;
+
+    const ASTIDType &getName(SymbolID id) const noexcept { return names[id]; }
+
+    size_t size() const noexcept { return names.size(); }
+
+  private:
+    struct Slot {
+        size_t hash;
+        SymbolID id = invalidSymbolID;
+    };
+
+    size_t findSlot(std::string_view name, size_t hash) const noexcept;
+    void grow();
+
+    std::deque<ASTIDType> names; ///< Stable storage for interned names
+    std::vector<Slot> slots;     ///< Open-addressing table, linear probing
+};
+
+///
+/// \brief `SymbolTable` maps interned identifiers to the position of their
+/// entries in a scope. It is an open-addressing hash table with linear probing
+/// and backward-shift deletion.
+///
+class SymbolTable {
+  public:
+    static constexpr uint32_t npos = UINT32_MAX;
+
+    /// \return the index bound to `id`, or `npos` if there is none.
+    uint32_t find(SymbolID id) const noexcept
+    {
+        if (slots.empty() || id == invalidSymbolID)
+            return npos;
+        for (size_t i = hashID(id) & mask();; i = (i + 1) & mask()) {
+            if (slots[i].id == id)
+                return slots[i].index;
+            if (slots[i].id == invalidSymbolID)
+                return npos;
+        }
+    }
+
+    /// Bind `id` to `index`, overwriting any previous binding.
+    void insert(SymbolID id, uint32_t index);
+
+    /// Remove the binding of `id`, if any.
+    void erase(SymbolID id) noexcept;
+
+    size_t size() const noexcept { return numEntries; }
+
+  private:
+    struct Slot {
+        SymbolID id = invalidSymbolID;
+        uint32_t index = npos;
+    };
+
+    static size_t hashID(SymbolID id) noexcept
+    {
+        // Fibonacci hashing spreads the dense IDs over the table.
+        return static_cast<size_t>(id) * 0x9E3779B97F4A7C15ULL >> 32;
+    }
+
+    size_t mask() const noexcept { return slots.size() - 1; }
+
+    void grow();
+
+    std::vector<Slot> slots;
+    size_t numEntries = 0;
+};
+
+} // namespace splc
+
+#endif // __SPLC_AST_SYMBOLTABLE_HH__
@@ -0,0 +1,116 @@
+#ifndef __SPLC_CODEGEN_COMPILECACHE_HH__
+#define __SPLC_CODEGEN_COMPILECACHE_HH__ 1
+
+#include <array>
+#include <filesystem>
+#include <ostream>
+#include <streambuf>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "CodeGen/LLVMWrapper.hh"
+#include "Core/splc.hh"
+
+namespace splc {
+
+///
+/// \brief An output file of a compilation, identified in the cache by `name`
+/// (e.g., "ll", "o").
+///
+struct CompileCacheOutput {
+    std::string name;
+    std::filesystem::path path;
+};
+
+///
+/// \brief `CompileCache` is an on-disk cache of compilation outputs.
+///
+/// An entry is keyed by the hash of the preprocessed token stream of a
+/// translation unit, together with everything else that affects the output,
+/// e.g., the target triple and the options. Entries are stored under
+/// `<dir>/<first 2 hex digits>/<remaining hex digits>/<output name>`, and are
+/// written through temporary files, such that concurrent compilations never
+/// observe a partial entry.
+///
+class CompileCache {
+  public:
+    ///
+    /// \brief Builds the key of a cache entry. Write the preprocessed input
+    /// to `getStream()`, add the remaining fields, then call `finalize()`.
+    ///
+    class KeyBuilder {
+      public:
+        KeyBuilder() : hashBuf{hasher}, os{&hashBuf} {}
+
+        KeyBuilder(const KeyBuilder &other) = delete;
+        KeyBuilder &operator=(const KeyBuilder &other) = delete;
+
+        std::ostream &getStream() noexcept { return os; }
+
+        void addField(std::string_view name, std::string_view value);
+
+        /// \return the key as a hexadecimal string.
+        std::string finalize();
+
+      private:
+        /// Feeds everything written to it into the hasher, in chunks.
+        class HashingStreamBuf : public std::streambuf {
+          public:
+            HashingStreamBuf(llvm::SHA256 &hasher_) : hasher{hasher_}
+            {
+                setp(buf.data(), buf.data() + buf.size());
+            }
+
+            void flushToHasher();
+
+          protected:
+            int_type overflow(int_type ch) override;
+            int sync() override;
+
+          private:
+            llvm::SHA256 &hasher;
+            std::array<char, 4096> buf;
+        };
+
+        llvm::SHA256 hasher;
+        HashingStreamBuf hashBuf;
+        std::ostream os;
+    };
+
+    CompileCache(std::filesystem::path cacheDir_)
+        : cacheDir{std::move(cacheDir_)}
+    {
+    }
+
+    ///
+    /// \brief Get the default cache directory: `$SPLC_CACHE_DIR`,
+    /// `$XDG_CACHE_HOME/splc` or `$HOME/.cache/splc`, in this order.
+    ///
+    static std::filesystem::path getDefaultDirectory();
+
+    ///
+    /// \brief Copy the outputs cached under `key` to their paths.
+    /// \return true on a cache hit, i.e., all outputs have been restored.
+    ///
+    bool retrieve(std::string_view key,
+                  const std::vector<CompileCacheOutput> &outputs) const;
+
+    ///
+    /// \brief Store the outputs under `key`. Nothing is stored unless all
+    /// outputs exist.
+    ///
+    void store(std::string_view key,
+               const std::vector<CompileCacheOutput> &outputs) const;
+
+    auto &getDirectory() const noexcept { return cacheDir; }
+
+  private:
+    std::filesystem::path getEntryDirectory(std::string_view key) const;
+
+    std::filesystem::path cacheDir;
+};
+
+} // namespace splc
+
+#endif // __SPLC_CODEGEN_COMPILECACHE_HH__
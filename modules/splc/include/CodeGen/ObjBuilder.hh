@@ -4,6 +4,7 @@
 #include "AST/DerivedAST.hh"
 #include "CodeGen/ASTDispatch.hh"
 #include "CodeGen/LLVMWrapper.hh"
+#include "CodeGen/TargetService.hh"
 #include "Translation/TranslationUnit.hh"
 #include <atomic>
 
@@ -15,20 +16,47 @@ class ObjBuilderConfig {
     // TODO
 };
 
+/// \brief A variable in scope: its storage and its type in both languages.
+struct ObjNamedValue {
+    llvm::Type *ty = nullptr;
+    llvm::AllocaInst *alloca = nullptr;
+    splc::Type *langTy = nullptr;
+};
+
+/// \brief A memory location designated by an lvalue expression.
+struct ObjLValue {
+    llvm::Value *addr = nullptr;
+    splc::Type *langTy = nullptr;
+    /// For struct members, the outermost struct accessed and the offset of
+    /// the member within it. They form the path of the TBAA access tag.
+    splc::Type *baseTy = nullptr;
+    uint64_t offset = 0;
+};
+
 class ObjParsingContext {
   public:
     ObjParsingContext() = default;
     ObjParsingContext(const ObjParsingContext &other) = delete;
     ObjParsingContext(ObjParsingContext &&other) = default;
 
-    std::map<std::string, std::pair<llvm::Type *, llvm::AllocaInst *>,
-             std::less<>>
-        namedValues;
+    /// Bindings hidden by the declarations of this scope, in the order they
+    /// were hidden. They are restored when the scope is left.
+    std::vector<std::pair<SymbolID, ObjNamedValue>> shadowedValues;
 };
 
 class ObjBuilder {
   public:
-    ObjBuilder() = default;
+    ///
+    /// \brief Create a builder generating code for `targetTriple_`. Modules
+    /// are given the triple and data layout of the target as soon as they are
+    /// created, so that type sizes and optimizations agree with the code that
+    /// is finally emitted.
+    ///
+    explicit ObjBuilder(
+        std::string_view targetTriple_ = llvm::sys::getDefaultTargetTriple())
+        : targetTriple{targetTriple_}
+    {
+    }
     ObjBuilder(const ObjBuilder &other) = delete;
     ObjBuilder(ObjBuilder &&other) = default;
 
@@ -47,6 +75,24 @@ class ObjBuilder {
 
     llvm::Type *getCvtType(splc::Type *ty);
 
+    ///
+    /// \brief Return the TBAA type node of `ty`. Structs list the type nodes
+    /// of their members together with the member offsets, and arrays are
+    /// described by their element type.
+    ///
+    /// Signed and unsigned types of the same width share a type node, and
+    /// `char` is the root that aliases every other type, as in C.
+    ///
+    llvm::MDNode *getTBAATypeNode(splc::Type *ty);
+
+    ///
+    /// \brief Return the TBAA access tag for the location `lv`, or `nullptr`
+    /// for aggregates. Struct members are tagged with the path from the
+    /// outermost struct accessed, so that members of different offsets or
+    /// different structs do not alias.
+    ///
+    llvm::MDNode *getTBAATag(const ObjLValue &lv);
+
     //===----------------------------------------------------------------------===//
     //                               Code Generation
     //===----------------------------------------------------------------------===//
@@ -56,105 +102,194 @@ class ObjBuilder {
 
     llvm::Function *getFunction(std::string_view name);
 
-    void registerGlobalCtxMutableVar(std::string_view name,
+    void registerGlobalCtxMutableVar(SymbolID id, std::string_view name,
                                      const SymbolEntry &ent);
-    void registerCtxMutableVar(std::string_view name, const SymbolEntry &ent);
+    void registerCtxMutableVar(SymbolID id, std::string_view name,
+                               const SymbolEntry &ent);
     // void registerCtxFuncParam(std::string_view name, const SymbolEntry &ent);
     void registerCtxFuncProto(std::string_view name, const SymbolEntry &ent);
     void registerCtxFuncDef(std::string_view name, const SymbolEntry &ent);
     void registerCtx(Ptr<ASTContext> ctx);
 
+    /// Declare the I/O routines `int read()` and `void write(int)`, which
+    /// SPL programs call without a prototype, unless the unit declares them.
+    void declareRuntimeFunctions();
+
     //===----------------------------------------------------------------------===//
     // Helper Functions
 
-    llvm::Value *CGConstant(Ptr<AST> constantRoot);
-    // llvm::Value *CGConstExpr(Ptr<AST> constExprRoot);
-    llvm::Value *CGPrimaryExpr(Ptr<AST> primaryExprRoot);
-    llvm::Value *CGPostfixExpr(Ptr<AST> postfixExprRoot);
-    llvm::Value *CGUnaryExpr(Ptr<AST> unaryExprRoot);
-    llvm::Value *CGSubscriptExpr(Ptr<AST> subscriptExprRoot);
-    llvm::Value *CGDerefExpr(Ptr<AST> derefExprRoot);
-    llvm::Value *CGAddrOfExpr(Ptr<AST> addrOfExprRoot);
-    llvm::Value *CGAccessExpr(Ptr<AST> accessExprRoot);
-    llvm::Value *CGCallExpr(Ptr<AST> callExprRoot);
-    llvm::Value *CGSizeOfExpr(Ptr<AST> sizeOfExprRoot);
-    llvm::Value *CGAssignExpr(Ptr<AST> assignExprRoot);
-
-    llvm::Value *CGBinaryCondExpr(Ptr<AST> binCondExprRoot);
-    llvm::Value *CGBinaryArithExpr(Ptr<AST> binaryExprRoot);
-    llvm::Value *CGTrinaryCondExpr(Ptr<AST> triCondExprRoot);
-
-    llvm::Value *CGImplicitCastExpr(Ptr<AST> impCastExprRoot);
-    llvm::Value *CGExplicitCastExpr(Ptr<AST> expCastExprRoot);
-
-    llvm::Value *CGExprID(Ptr<AST> IDRoot);
-
-    llvm::Value *CGGeneralExprDispCN1(Ptr<AST> exprRoot);
-    llvm::Value *CGGeneralExprDispCN2(Ptr<AST> exprRoot);
-    llvm::Value *CGGeneralExprDispCN3(Ptr<AST> exprRoot);
-    llvm::Value *CGGeneralExprDispCNN(Ptr<AST> exprRoot);
-    llvm::Value *CGGeneralExprDispatch(Ptr<AST> exprRoot);
+    llvm::Value *CGConstant(const Ptr<AST> &constantRoot);
+    // llvm::Value *CGConstExpr(const Ptr<AST> &constExprRoot);
+    llvm::Value *CGPrimaryExpr(const Ptr<AST> &primaryExprRoot);
+    llvm::Value *CGPostfixExpr(const Ptr<AST> &postfixExprRoot);
+    llvm::Value *CGUnaryExpr(const Ptr<AST> &unaryExprRoot);
+    llvm::Value *CGSubscriptExpr(const Ptr<AST> &subscriptExprRoot);
+    llvm::Value *CGDerefExpr(const Ptr<AST> &derefExprRoot);
+    llvm::Value *CGAddrOfExpr(const Ptr<AST> &addrOfExprRoot);
+    llvm::Value *CGAccessExpr(const Ptr<AST> &accessExprRoot);
+    llvm::Value *CGCallExpr(const Ptr<AST> &callExprRoot);
+    llvm::Value *CGSizeOfExpr(const Ptr<AST> &sizeOfExprRoot);
+    llvm::Value *CGAssignExpr(const Ptr<AST> &assignExprRoot);
+
+    llvm::Value *CGBinaryCondExpr(const Ptr<AST> &binCondExprRoot);
+    llvm::Value *CGBinaryArithExpr(const Ptr<AST> &binaryExprRoot);
+    llvm::Value *CGTrinaryCondExpr(const Ptr<AST> &triCondExprRoot);
+
+    llvm::Value *CGImplicitCastExpr(const Ptr<AST> &impCastExprRoot);
+    llvm::Value *CGExplicitCastExpr(const Ptr<AST> &expCastExprRoot);
+
+    llvm::Value *CGExprID(const Ptr<AST> &IDRoot);
+
+    ///
+    /// \brief Compute the address designated by the lvalue `exprRoot`, which
+    /// is one of an ID, a subscript, a dereference or a member access.
+    /// \return `{nullptr, nullptr}` if `exprRoot` is not an lvalue.
+    ///
+    ObjLValue CGLValue(const Ptr<AST> &exprRoot);
+
+    ///
+    /// \brief Evaluate the pointer or array `exprRoot` as a pointer.
+    /// \return the pointer and the type it points to, or `{nullptr,
+    /// nullptr}` if `exprRoot` has neither type.
+    ///
+    ObjLValue CGPointerExpr(const Ptr<AST> &exprRoot);
+
+    /// \brief Load the value at `lv`. Arrays decay to their address instead.
+    llvm::Value *CGLoadLValue(const ObjLValue &lv, std::string_view name = "");
+    void CGStoreLValue(llvm::Value *val, const ObjLValue &lv);
+
+    /// \brief Compute `val + 1` or `val - 1` for `++`/`--` on `lv`.
+    llvm::Value *CGIncOrDec(const ObjLValue &lv, llvm::Value *val, bool isInc);
+
+    ///
+    /// \brief Infer the type of `exprRoot` without generating code.
+    ///
+    /// Only the expressions that may yield pointers, arrays or structs are
+    /// inferred, which suffices to lower subscripts, member accesses, pointer
+    /// arithmetic and `sizeof`.
+    ///
+    /// \return `nullptr` if the type cannot be inferred.
+    ///
+    splc::Type *getExprLangType(const Ptr<AST> &exprRoot);
+
+    /// \return the index of `member` in `ty`, or -1 if there is none.
+    int getStructMemberIndex(splc::Type *ty, std::string_view member);
+
+    llvm::Value *CGGeneralExprDispCN1(const Ptr<AST> &exprRoot);
+    llvm::Value *CGGeneralExprDispCN2(const Ptr<AST> &exprRoot);
+    llvm::Value *CGGeneralExprDispCN3(const Ptr<AST> &exprRoot);
+    llvm::Value *CGGeneralExprDispCNN(const Ptr<AST> &exprRoot);
+    llvm::Value *CGGeneralExprDispatch(const Ptr<AST> &exprRoot);
 
     //===----------------------------------------------------------------------===//
     // Statements
 
-    void CGCompStmt(Ptr<AST> compStmtRoot);
+    void CGCompStmt(const Ptr<AST> &compStmtRoot);
 
-    void CGExprStmt(Ptr<AST> exprStmtRoot);
+    void CGExprStmt(const Ptr<AST> &exprStmtRoot);
 
-    void CGIfStmt(Ptr<AST> ifStmtRoot);
-    void CGSelStmt(Ptr<AST> selStmtRoot);
+    void CGIfStmt(const Ptr<AST> &ifStmtRoot);
+    void CGSelStmt(const Ptr<AST> &selStmtRoot);
 
-    void CGDoWhileStmt(Ptr<AST> doWhileStmtRoot);
-    void CGWhileStmt(Ptr<AST> whileStmtRoot);
-    void CGForStmt(Ptr<AST> forStmtRoot);
-    void CGIterStmt(Ptr<AST> iterStmtRoot);
+    void CGDoWhileStmt(const Ptr<AST> &doWhileStmtRoot);
+    void CGWhileStmt(const Ptr<AST> &whileStmtRoot);
+    void CGForStmt(const Ptr<AST> &forStmtRoot);
+    void CGIterStmt(const Ptr<AST> &iterStmtRoot);
 
-    void CGLabeledStmt(Ptr<AST> labeledStmtRoot);
+    void CGLabeledStmt(const Ptr<AST> &labeledStmtRoot);
 
-    void CGReturnStmt(Ptr<AST> returnStmtRoot);
-    void CGJumpStmt(Ptr<AST> jumpStmtRoot);
+    void CGReturnStmt(const Ptr<AST> &returnStmtRoot);
+    void CGJumpStmt(const Ptr<AST> &jumpStmtRoot);
 
-    void CGStmt(Ptr<AST> stmtRoot);
+    void CGStmt(const Ptr<AST> &stmtRoot);
 
     //===----------------------------------------------------------------------===//
     // Declarations
 
     /// Accept FuncDecltr as protoRoot.
-    llvm::Function *CGFuncProto(Ptr<AST> protoRoot);
+    llvm::Function *CGFuncProto(const Ptr<AST> &protoRoot);
     /// Accept FuncDef as funcRoot.
-    llvm::Function *CGFuncDef(Ptr<AST> funcRoot);
+    llvm::Function *CGFuncDef(const Ptr<AST> &funcRoot);
 
-    llvm::Value *CGInitializer(Ptr<AST> initRoot);
-    void CGInitDecltr(Ptr<AST> initDecltrRoot);
-    void CGInitDecltrList(Ptr<AST> initDecltrListRoot);
-    void CGDirDecl(Ptr<AST> dirDeclRoot);
+    llvm::Value *CGInitializer(const Ptr<AST> &initRoot);
+    void CGInitDecltr(const Ptr<AST> &initDecltrRoot);
+    void CGInitDecltrList(const Ptr<AST> &initDecltrListRoot);
+    void CGDirDecl(const Ptr<AST> &dirDeclRoot);
 
-    void CGDecl(Ptr<AST> declRoot);
+    void CGDecl(const Ptr<AST> &declRoot);
 
-    void CGExternDecl(Ptr<AST> externDeclRoot);
+    void CGExternDecl(const Ptr<AST> &externDeclRoot);
 
-    void CGExternDeclList(Ptr<AST> externDeclListRoot);
-    void CGTransUnit(Ptr<AST> transUnitRoot);
+    void CGExternDeclList(const Ptr<AST> &externDeclListRoot);
+    void CGTransUnit(const Ptr<AST> &transUnitRoot);
 
   public:
     //===----------------------------------------------------------------------===//
     // CG
 
     void generateModule(TranslationUnit &tunit);
-    void optimizeModule();
+
+    ///
+    /// \brief Run the standard LLVM pipeline of `level` over the module.
+    ///
+    /// With `numThreads > 1`, large modules are split into partitions that are
+    /// optimized concurrently, each in a separate `LLVMContext`, and then
+    /// linked back together. Calls across partitions are not inlined.
+    ///
+    void optimizeModule(
+        llvm::OptimizationLevel level = llvm::OptimizationLevel::O2,
+        unsigned numThreads = 1);
+
+    ///
+    /// \brief Run the LTO pipeline of `level` over the module.
+    ///
+    /// With `preLink`, this is the pipeline for a single translation unit
+    /// written as bitcode, which leaves interprocedural optimizations to the
+    /// link step. Otherwise, it is the whole-program pipeline for a module
+    /// made by `linkBitcodeFiles`.
+    ///
+    void optimizeModuleForLTO(llvm::OptimizationLevel level, bool preLink);
+
+    //===----------------------------------------------------------------------===//
+    //                                Linking
+    //===----------------------------------------------------------------------===//
+
+    ///
+    /// \brief Replace the module with the modules in the bitcode files
+    /// `paths`, linked together.
+    ///
+    /// Every symbol defined in the program except `main` is internalized, so
+    /// that the whole-program pipeline may inline or drop it.
+    ///
+    /// \return false if a file cannot be read or the modules cannot be
+    /// linked.
+    ///
+    bool linkBitcodeFiles(const std::vector<std::string> &paths);
 
     //===----------------------------------------------------------------------===//
     //                             IR/Obj Generation
     //===----------------------------------------------------------------------===//
 
     void writeModuleAsLLVMIR(std::ostream &os);
-    void writeModuleAsAsm(
-        std::string_view path,
-        std::string_view targetTriple = llvm::sys::getDefaultTargetTriple());
-    void writeModuleAsObj(
-        std::string_view path,
-        std::string_view targetTriple = llvm::sys::getDefaultTargetTriple());
+
+    /// The following return false if the module has not been generated
+    /// successfully or the file cannot be written.
+    bool writeModuleAsBitcode(std::string_view path);
+    bool writeModuleAsAsm(std::string_view path);
+    bool writeModuleAsObj(std::string_view path);
+
+    ///
+    /// \brief Run the `main` of the module in this process, with `args` as its
+    /// arguments after `programName`.
+    ///
+    /// The module is handed over to an ORC JIT that compiles each function
+    /// lazily on its first call. `read` and `write` are bound to the standard
+    /// input and output of the host.
+    ///
+    /// \return the exit code of `main`, or -1 if it could not be run.
+    ///
+    int runModuleInJIT(std::string_view programName,
+                       const std::vector<std::string> &args);
 
     //===----------------------------------------------------------------------===//
     //                               Member Access
@@ -162,6 +297,11 @@ class ObjBuilder {
 
     llvm::LLVMContext &getLLVMCtx() const noexcept { return *llvmCtx; }
 
+    bool isGenerationSuccess() const noexcept
+    {
+        return llvmModuleGenerationSuccess;
+    }
+
   protected:
   private:
     //===----------------------------------------------------------------------===//
@@ -169,18 +309,19 @@ class ObjBuilder {
     //===----------------------------------------------------------------------===//
 
     void generateModuleImpl(TranslationUnit &tunit);
-    void optimizeModuleImpl();
+    void optimizeModuleImpl(llvm::OptimizationLevel level,
+                            unsigned numThreads);
     void writeModuleLLVMIRImpl(std::ostream &os);
-    void writeModuleAsFile(llvm::CodeGenFileType fileType,
-                           std::string_view path,
-                           std::string_view targetTriple);
+    bool writeModuleAsFile(llvm::CodeGenFileType fileType,
+                           std::string_view path);
+    int runModuleInJITImpl(std::string_view programName,
+                           const std::vector<std::string> &args);
 
     //===----------------------------------------------------------------------===//
     //                          Internal State Management
     //===----------------------------------------------------------------------===//
 
     void initializeModuleAndManagers();
-    void initializeTargetRegistry();
 
     void initializeInternalStates();
 
@@ -189,11 +330,6 @@ class ObjBuilder {
         llvmModuleGenerationSuccess = s;
     }
 
-    bool isGenerationSuccess() const noexcept
-    {
-        return llvmModuleGenerationSuccess;
-    }
-
     //===----------------------------------------------------------------------===//
     // Variable Management
 
@@ -207,20 +343,32 @@ class ObjBuilder {
     size_t varCtxStackSize() const noexcept { return varCtxStack.size(); }
     bool isVarCtxGlobalScope() const noexcept { return varCtxStackSize() == 1; }
 
-    /// Find named value starting from the top of the stack
-    std::pair<llvm::Type *, llvm::AllocaInst *>
-    findNamedValue(std::string_view name) const;
-    void insertNamedValue(std::string_view name, llvm::Type *ty,
-                          llvm::AllocaInst *alloca);
+    ///
+    /// \brief Find the innermost named value visible in the current scope.
+    ///
+    /// Bindings are kept in a table indexed by the interned ID of their
+    /// symbol, such that a lookup does not depend on the depth of the scope.
+    ///
+    ObjNamedValue findNamedValue(SymbolID id) const noexcept
+    {
+        return id < namedValues.size() ? namedValues[id] : ObjNamedValue{};
+    }
+    ObjNamedValue findNamedValue(std::string_view name) const;
+
+    /// \brief Bind `id` in the current scope, hiding its outer binding.
+    void insertNamedValue(SymbolID id, llvm::Type *ty, llvm::AllocaInst *alloca,
+                          splc::Type *langTy);
 
     void registerFuncProto(std::string_view name, llvm::Type *ty,
-                           Ptr<AST> protoRoot);
+                           const Ptr<AST> &protoRoot);
     std::pair<llvm::Type *, Ptr<AST>> findFuncProto(std::string_view name);
 
   private:
+    std::string targetTriple;
+    TargetService::Lease targetMachine; ///< Held while a module is built
+
     UniquePtr<llvm::LLVMContext> llvmCtx;
 
-    bool llvmTargetEnvInitialized = false;
     bool llvmModuleGenerated = false;
     bool llvmModuleGenerationSuccess = false;
 
@@ -229,20 +377,29 @@ class ObjBuilder {
 
     std::map<splc::Type *, llvm::Type *> tyCache;
 
+    /// Struct type -> the context declaring its members, in order
+    std::map<splc::Type *, Ptr<ASTContext>> structMembers;
+
+    llvm::MDNode *tbaaRoot = nullptr;
+    std::map<splc::Type *, llvm::MDNode *> tbaaTypeNodes;
+
     std::vector<ObjParsingContext> varCtxStack;
+    Ptr<SymbolStringPool> symbolPool; ///< Of the unit being generated
+    std::vector<ObjNamedValue> namedValues; ///< Symbol ID -> visible binding
     std::map<std::string, std::pair<llvm::Type *, Ptr<AST>>, std::less<>>
         functionProtos;
 
     UniquePtr<llvm::Module> theModule;
     UniquePtr<llvm::IRBuilder<>> builder;
 
+    /// Run over each function as soon as it is generated, at every
+    /// optimization level. Locals live in allocas, and SROA promotes those of
+    /// scalars and of aggregates accessed at constant offsets to SSA values.
     UniquePtr<llvm::FunctionPassManager> theFPM;
     UniquePtr<llvm::LoopAnalysisManager> theLAM;
     UniquePtr<llvm::FunctionAnalysisManager> theFAM;
     UniquePtr<llvm::CGSCCAnalysisManager> theCGAM;
     UniquePtr<llvm::ModuleAnalysisManager> theMAM;
-    UniquePtr<llvm::PassInstrumentationCallbacks> thePIC;
-    UniquePtr<llvm::StandardInstrumentations> theSI;
 };
 
 } // namespace splc
@@ -0,0 +1,123 @@
+#ifndef __SPLC_CODEGEN_TARGETSERVICE_HH__
+#define __SPLC_CODEGEN_TARGETSERVICE_HH__ 1
+
+#include <map>
+#include <mutex>
+#include <set>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <vector>
+
+#include "CodeGen/LLVMWrapper.hh"
+#include "Core/splc.hh"
+
+namespace splc {
+
+///
+/// \brief Process-wide access to LLVM targets.
+///
+/// Only the backends of the triples actually requested are initialized, each
+/// at most once. Target machines are cached per (triple, CPU, features) and
+/// reused by every `ObjBuilder` of the process. A `TargetMachine` is not safe
+/// to use for concurrent code generation, so each machine is leased to one
+/// user at a time, and a new one is created only if all cached machines of
+/// the same key are in use.
+///
+class TargetService {
+  public:
+    using KeyType = std::tuple<std::string, std::string, std::string>;
+
+    ///
+    /// \brief Exclusive handle of a cached `TargetMachine`, which is returned
+    /// to the service on destruction.
+    ///
+    class Lease {
+      public:
+        Lease() = default;
+        Lease(const Lease &other) = delete;
+        Lease &operator=(const Lease &other) = delete;
+        Lease(Lease &&other) noexcept
+            : service{other.service}, key{std::move(other.key)},
+              machine{std::move(other.machine)}
+        {
+            other.service = nullptr;
+        }
+
+        /// Return the machine held so far, and take over that of `other`.
+        Lease &operator=(Lease &&other) noexcept
+        {
+            if (this != &other) {
+                Lease old{std::move(*this)};
+                service = other.service;
+                key = std::move(other.key);
+                machine = std::move(other.machine);
+                other.service = nullptr;
+            }
+            return *this;
+        }
+
+        ~Lease();
+
+        explicit operator bool() const noexcept { return machine != nullptr; }
+
+        llvm::TargetMachine *get() const noexcept { return machine.get(); }
+
+        llvm::TargetMachine *operator->() const noexcept
+        {
+            return machine.get();
+        }
+
+        llvm::TargetMachine &operator*() const noexcept { return *machine; }
+
+      private:
+        friend class TargetService;
+
+        Lease(TargetService *service_, KeyType key_,
+              UniquePtr<llvm::TargetMachine> machine_) noexcept
+            : service{service_}, key{std::move(key_)},
+              machine{std::move(machine_)}
+        {
+        }
+
+        TargetService *service = nullptr;
+        KeyType key;
+        UniquePtr<llvm::TargetMachine> machine;
+    };
+
+    TargetService(const TargetService &other) = delete;
+    TargetService &operator=(const TargetService &other) = delete;
+
+    static TargetService &getInstance();
+
+    ///
+    /// \brief Initialize the backend of `triple`, if not done yet.
+    /// \return the target, or `nullptr` with `errorMsg` set.
+    ///
+    const llvm::Target *initializeTarget(std::string_view triple,
+                                         std::string &errorMsg);
+
+    ///
+    /// \brief Lease a target machine, creating it on first use.
+    /// \return an empty lease with `errorMsg` set on failure.
+    ///
+    Lease acquireTargetMachine(std::string_view triple,
+                               std::string_view cpu,
+                               std::string_view features,
+                               std::string &errorMsg);
+
+  private:
+    TargetService() = default;
+
+    void release(KeyType key, UniquePtr<llvm::TargetMachine> machine);
+
+    std::mutex serviceMutex;
+    bool targetInfosInitialized = false;
+    std::set<std::string, std::less<>> initializedBackends;
+    std::map<KeyType, std::vector<UniquePtr<llvm::TargetMachine>>>
+        idleMachines;
+};
+
+} // namespace splc
+
+#endif // __SPLC_CODEGEN_TARGETSERVICE_HH__
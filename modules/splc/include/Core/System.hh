@@ -53,5 +53,8 @@ class SemanticError : public std::runtime_error {
 /// prohibit us from using the
 /// Lexer.hh header, so it has been ignored.
 #define SPLC_BUF_SIZE 16384
+/// Total size of the source files that `SourceCache` keeps once they are no
+/// longer in use.
+#define SPLC_SOURCE_CACHE_SIZE (64 * 1024 * 1024)
 
 #endif // __SPLC_CORE_SYSTEM_HH__
@@ -13,6 +13,7 @@ class CommandLineParser {
     enum ArgOption : unsigned {
         NoOption = 0,
         WithOption = 1,
+        StopAtDirArg = 2, ///< The first direct argument after it ends options
     };
 
   public:
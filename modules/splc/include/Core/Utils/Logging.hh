@@ -37,7 +37,8 @@ class ErrorHelper;
 
 extern std::mutex logStreamMutex;
 
-extern std::ostream *logStream;
+/// Destination of all diagnostics emitted by the current thread.
+extern thread_local std::ostream *logStream;
 
 std::ostream &getLogStream();
 
@@ -227,6 +228,28 @@ class ErrorHelper : public Logger {
 
 } // namespace internal
 
+///
+/// \brief Redirect all diagnostics emitted by the current thread to `os`
+///        for the lifetime of this object. Used to keep the diagnostics of
+///        one translation unit together when compiling in parallel.
+///
+class LogStreamRedirect {
+  public:
+    LogStreamRedirect(std::ostream &os) noexcept
+        : prevLogStream{internal::logStream}
+    {
+        internal::logStream = &os;
+    }
+
+    LogStreamRedirect(const LogStreamRedirect &other) = delete;
+    LogStreamRedirect &operator=(const LogStreamRedirect &other) = delete;
+
+    ~LogStreamRedirect() noexcept { internal::logStream = prevLogStream; }
+
+  private:
+    std::ostream *prevLogStream;
+};
+
 } // namespace splc::utils::logging
 
 // TODO: check message system macros
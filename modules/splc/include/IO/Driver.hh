@@ -3,6 +3,7 @@
 
 #include <cstddef>
 #include <istream>
+#include <ostream>
 #include <string>
 #include <string_view>
 #include <vector>
@@ -31,6 +32,12 @@ class Driver {
     ///
     Ptr<TranslationUnit> parse(std::string_view filename);
 
+    ///
+    /// \brief Preprocess a file without parsing it, streaming the expanded
+    /// tokens to `os`.
+    ///
+    void preprocess(std::string_view filename, std::ostream &os);
+
     // // TODO: remove experimental
     // Ptr<TranslationUnit> parse(const std::vector<std::string>
     // &filenameVector);
@@ -1,10 +1,166 @@
 #ifndef __SPLC_IO_PREPROCESSOR_HH__
 #define __SPLC_IO_PREPROCESSOR_HH__ 1
 
-namespace splc {
+#include <deque>
+#include <map>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
 
+#include "Core/splc.hh"
+#include "IO/Parser.hh"
+#include "Translation/TranslationManager.hh"
 
+namespace splc::IO {
 
-} // namespace splc
+class Scanner;
+struct MacroDefinition;
+
+///
+/// \brief A token as seen by the preprocessor: the token kind returned to the
+/// parser together with its semantic value.
+///
+struct PPToken {
+    /// Internal kind that marks the end of a macro expansion in the pending
+    /// token queue. It is never returned to the parser.
+    static constexpr int endOfExpansion = -1;
+
+    int kind;
+    PtrAST node;
+    Location loc;
+
+    /// Macro that ends here, if `kind == endOfExpansion`.
+    const MacroDefinition *macro = nullptr;
+
+    /// Set on identifiers that must not be expanded again, because they name
+    /// a macro that was being expanded when the identifier was produced.
+    bool noExpand = false;
+
+    bool isIdentifier() const noexcept { return kind == Parser::token::ID; }
+
+    std::string_view getIdentifier() const noexcept
+    {
+        return node->getConstVal<ASTIDType>();
+    }
+};
+
+///
+/// \brief A macro whose replacement list has been tokenized at `#define`.
+///
+struct MacroDefinition {
+    std::string name;
+    Location defLoc;
+    bool isFunctionLike = false;
+    std::vector<std::string> params;
+    std::vector<PPToken> body;
+
+    /// \return the index of `name_` in the parameter list, or -1.
+    int findParam(std::string_view name_) const noexcept;
+};
+
+///
+/// \brief `Preprocessor` sits between the parser and the raw scanner and
+/// performs macro expansion at the token level.
+///
+/// Replacement lists are lexed once, when the macro is defined. Expanding a
+/// macro splices fresh copies of those tokens into the token stream, so no
+/// text is ever re-lexed. As in C, arguments are fully expanded before they
+/// are substituted, and the result is rescanned for further macros, while the
+/// macros being expanded are suppressed to prevent recursion.
+///
+class Preprocessor {
+  public:
+    using value_type = Parser::value_type;
+
+    Preprocessor(Scanner &scanner_, TranslationManager &transMgr_)
+        : scanner{scanner_}, transMgr{transMgr_},
+          tyCtx{transMgr_.getContext()}
+    {
+    }
+
+    Preprocessor(const Preprocessor &other) = delete;
+    Preprocessor &operator=(const Preprocessor &other) = delete;
+
+    ///
+    /// \brief Get the next fully expanded token for the parser.
+    ///
+    int lex(value_type *yylval, Location *yyloc);
+
+    ///
+    /// \brief Write the fully expanded token stream of the input to `os`,
+    /// with line markers of the form `# <line> "<file>"` whenever the source
+    /// position cannot be kept by emitting newlines. Tokens are written as
+    /// soon as they are produced, so memory usage does not depend on the
+    /// size of the input.
+    ///
+    void writePreprocessedTokens(std::ostream &os);
+
+    ///
+    /// \brief Define a macro, tokenizing `body_` immediately.
+    /// \param bodyLoc_ Location of the first character of `body_`.
+    /// \return false if the macro has already been defined.
+    ///
+    bool defineMacro(const Location *defLoc_, std::string_view name_,
+                     bool isFunctionLike_, std::vector<std::string> params_,
+                     std::string_view body_, const Location &bodyLoc_);
+
+    const MacroDefinition *findMacro(std::string_view name_) const noexcept;
+
+    ///
+    /// \brief This is the only macro table of the unit: `#define` checks it
+    /// for redefinitions, and include guards are looked up here.
+    ///
+    bool isMacroDefined(std::string_view name_) const noexcept
+    {
+        return findMacro(name_) != nullptr;
+    }
+
+    ///
+    /// \brief Location maintained by the raw scanner. It is distinct from the
+    /// location of the tokens returned by `lex`, which for expanded tokens is
+    /// the location of the macro invocation.
+    ///
+    Location &getRawLocation() noexcept { return rawLoc; }
+
+  private:
+    PPToken lexRaw();
+
+    /// Get the next unexpanded token, from the pending queue if possible.
+    PPToken nextToken();
+
+    ///
+    /// \brief Expand the macro named by `tok`, pushing the result to the front
+    /// of the pending queue.
+    /// \return false if `tok` is not to be expanded.
+    ///
+    bool tryExpand(const PPToken &tok);
+
+    bool collectArguments(const MacroDefinition &macro, const Location &useLoc,
+                          std::vector<std::vector<PPToken>> &args);
+
+    /// Replace `arg` with its full expansion, which must lie within `arg`.
+    void expandArgument(std::vector<PPToken> &arg);
+
+    /// Create a fresh copy of `proto` located at `loc`.
+    PPToken instantiate(const PPToken &proto, const Location &loc);
+
+    bool isActive(const MacroDefinition *macro) const noexcept;
+
+    Scanner &scanner;
+    TranslationManager &transMgr;
+    SPLCContext &tyCtx;
+
+    Location rawLoc;
+
+    std::map<std::string, MacroDefinition, std::less<>> macros;
+
+    std::deque<PPToken> pending;
+
+    /// Macros whose expansion is still in the pending queue.
+    std::vector<const MacroDefinition *> activeMacros;
+};
+
+} // namespace splc::IO
 
 #endif // __SPLC_IO_PREPROCESSOR_HH__
@@ -3,6 +3,7 @@
 
 #include "IO/IOBase.hh"
 #include "IO/Parser.hh"
+#include "IO/Preprocessor.hh"
 #include "Translation/TranslationContext.hh"
 #include "Translation/TranslationManager.hh"
 
@@ -11,7 +12,8 @@ namespace splc::IO {
 class Scanner : public SplcFlexLexer {
   public:
     Scanner(TranslationManager &transMgr_, std::istream *in = nullptr)
-        : SplcFlexLexer{in}, transMgr{transMgr_}, tyCtx{transMgr_.getContext()}
+        : SplcFlexLexer{in}, transMgr{transMgr_},
+          tyCtx{transMgr_.getContext()}, preprocessor{*this, transMgr_}
     {
     }
 
@@ -23,14 +25,26 @@ class Scanner : public SplcFlexLexer {
     ///
     /// \brief The main procedure called by `splc::IO::Parser` to get tokens.
     ///
-    /// `YY_DECL` is defined to be this function in Lexer.ll.
-    /// Method body created by flex in lexer.cc.
+    /// Tokens are taken from the preprocessor, which expands macros on top of
+    /// `lexRaw()`.
     ///
     /// \param lval Pointer to the semantic value of this token.
     /// \param location The location of this token.
     virtual int yylex(splc::IO::Parser::value_type *const yylval,
                       splc::IO::Parser::location_type *yyloc);
 
+    ///
+    /// \brief Get the next token without macro expansion. Identifiers are
+    /// always returned as `ID`.
+    ///
+    /// `YY_DECL` is defined to be this function in Lexer.ll.
+    /// Method body created by flex in lexer.cc.
+    ///
+    int lexRaw(splc::IO::Parser::value_type *const yylval,
+               splc::IO::Parser::location_type *yyloc);
+
+    Preprocessor &getPreprocessor() noexcept { return preprocessor; }
+
     ///
     /// \brief The main procedure for `yyFlexLexer` to switch to a different
     ///        input stream.
@@ -40,25 +54,13 @@ class Scanner : public SplcFlexLexer {
     bool setInitialContext(Ptr<TranslationContext> initialContext);
 
     /// \brief Push file context and switch to the included file.
+    /// \return false if the file is not entered, either on error or because
+    /// it is protected against multiple inclusion.
     bool pushFileContext(const Location *intrLoc_, std::string_view fileName_);
 
-    /// \brief Push macro context and switch to macro substitution.
-    bool pushMacroVarContext(const Location *intrLoc_,
-                             std::string_view macroVarName_);
-
     bool isContextPresent(TranslationContextBufferType type_,
                           std::string_view contextName_) const noexcept;
 
-    bool
-    isMacroVarContextPresent(std::string_view macroVarName_) const noexcept;
-
-    bool registerMacroVarContext(const Location *regLocation,
-                                 std::string_view macroVarName_,
-                                 std::string_view content_);
-
-    bool unregisterMacroVarContext(const Location *unRegLoc,
-                                   std::string_view macroVarName_);
-
     /// Generally, do not use this because of performance penalty
     void stepLoc(splc::utils::Location &loc, std::string_view yytext);
 
@@ -81,12 +83,23 @@ class Scanner : public SplcFlexLexer {
     std::string tmpStr;
     Location tmpLoc;
 
+    bool macroFunctionLike = false;
+    std::vector<std::string> macroParams;
+    Location macroBodyLoc;
+
+    /// Only split the input into tokens, e.g., the replacement list of a
+    /// macro. Directives are rejected and the end of input is final.
+    bool tokenizeOnly = false;
+
+    Preprocessor preprocessor;
+
     /// Theoretically, this stores the same pointer as the input in
     /// `yylex()`.
 
   public:
     friend class Driver;
     friend class Parser;
+    friend class Preprocessor;
 };
 
 } // namespace splc::IO
@@ -5,19 +5,26 @@
 #include <Basic/Type.hh>
 #include <Core/splc.hh>
 
+#include <cstdint>
+#include <deque>
 #include <ranges>
+#include <unordered_map>
 
 namespace splc::SIR {
 
-class IRVar;
-class IRStmt;
+class IROperand;
+class IRStmtRef;
 class IRFunction;
-class IRSB; // IR Super Block
+class IRSB; // IR Basic Block, see SIR/IRCFG.hh
 
 using IRIDType = ASTIDType;
 using StrRef = std::string_view;
-using PtrIRVar = Ptr<IRVar>;
-using PtrIRStmt = Ptr<IRStmt>;
+
+/// Index of a statement into the statement arrays of its function
+using IRStmtID = uint32_t;
+
+/// Index of a name interned by a function
+using IRNameID = uint32_t;
 
 template <class T>
 using IRVec = std::vector<T>;
@@ -31,14 +38,7 @@ using IRPair = std::pair<T, U>;
 template <class T>
 using IRSet = std::set<T>;
 
-enum class IRVarType {
-    Label,
-    Function,
-    Variable,
-    Constant,
-};
-
-enum class IRType {
+enum class IRType : uint8_t {
     SetLabel,
     FuncDecl,
     Assign,
@@ -58,9 +58,10 @@ enum class IRType {
     InvokeFunc,
     Read,
     Write,
+    Phi, ///< Only present while the function is in SSA form
 };
 
-enum class IRBranchType {
+enum class IRBranchType : uint8_t {
     None,
     LT,
     LE,
@@ -78,140 +79,296 @@ enum class IRLogicalOpType {
     XOR,
 };
 
-class IRVar {
+///
+/// \brief A variable, constant, label or function referenced by a statement.
+///
+/// The kind is packed into the top bits of a 32-bit word, and the rest is an
+/// index into the table of that kind held by the `IRFunction`.
+///
+class IROperand {
   public:
-    IRVar(IRIDType name_, IRVarType varType_ = IRVarType::Label,
-          Type *type_ = nullptr, ASTValueType val_ = {}, bool isConst__ = false,
-          bool isUsed__ = false)
-        : name{name_}, irVarType{varType_}, valType{type_}, val{val_},
-          isConstant{isConst__}, isUsed_{isUsed__}
+    enum class Kind : uint32_t {
+        None,
+        Variable,
+        Constant,
+        Label,
+        Function,
+    };
+
+    static constexpr unsigned indexBits = 29;
+    static constexpr uint32_t maxIndex = (uint32_t{1} << indexBits) - 1;
+
+    constexpr IROperand() noexcept = default;
+
+    constexpr IROperand(Kind kind, uint32_t index) noexcept
+        : bits{(static_cast<uint32_t>(kind) << indexBits) | index}
     {
     }
 
-    static PtrIRVar createLabel(IRIDType name);
+    constexpr Kind getKind() const noexcept
+    {
+        return static_cast<Kind>(bits >> indexBits);
+    }
+
+    constexpr uint32_t getIndex() const noexcept { return bits & maxIndex; }
+
+    constexpr uint32_t getBits() const noexcept { return bits; }
+
+    // clang-format off
+
+    constexpr bool isNone() const noexcept { return bits == 0; }
+
+    constexpr bool isVariable() const noexcept { return getKind() == Kind::Variable; }
+
+    constexpr bool isConstant() const noexcept { return getKind() == Kind::Constant; }
+
+    constexpr bool isLabel() const noexcept { return getKind() == Kind::Label; }
+
+    constexpr bool isFunction() const noexcept { return getKind() == Kind::Function; }
+
+    // clang-format on
+
+    constexpr explicit operator bool() const noexcept { return !isNone(); }
+
+    constexpr auto operator<=>(const IROperand &other) const noexcept = default;
+
+  private:
+    uint32_t bits = 0;
+};
+
+///
+/// \brief Entry of the variable and label tables of a function.
+///
+/// The name is the interned `prefix` followed by `number`, unless the latter
+/// is `noNumber`. Names of temporaries are thus only built when printed.
+///
+struct IRSymbol {
+    static constexpr uint32_t noNumber = ~uint32_t{0};
+
+    IRNameID prefix;
+    uint32_t number = noNumber;
+    Type *type = nullptr; ///< Only set for variables
+};
+
+/// Incoming value of a phi function, and the block it flows from
+using IRPhiArg = IRPair<IROperand, IRSB *>;
+
+///
+/// \brief A function in SIR.
+///
+/// Names, variables, labels and constants live in tables owned by the
+/// function, and statements refer to them through `IROperand`. Statements are
+/// stored as parallel arrays indexed by `IRStmtID`, and `body` lists them in
+/// program order. A statement dropped from `body` keeps its slot until
+/// `compact()` is called.
+///
+/// Functions share no mutable state, so distinct functions may be transformed
+/// concurrently.
+///
+class IRFunction {
+  public:
+    IRFunction(IRIDType name_, Type *retTy_) : name{name_}, retTy{retTy_} {}
+
+    IRFunction(const IRFunction &other) = delete;
+    IRFunction &operator=(const IRFunction &other) = delete;
+
+    static Ptr<IRFunction> create(IRIDType name_, Type *retTy_);
 
-    static PtrIRVar createFunction(IRIDType name, Type *type);
+    //===------------------------------------------------------------------===//
+    //                       Operand Tables
 
-    static PtrIRVar createVariable(IRIDType name, Type *type);
+    IRNameID internName(StrRef str);
 
-    static PtrIRVar createConstant(Type *type, ASTValueType val);
+    StrRef getNameString(IRNameID id) const noexcept { return names[id]; }
 
-    constexpr bool hasValue() const noexcept { return val.index() != 0; }
+    size_t getNumNames() const noexcept { return names.size(); }
 
-    template <IsValidASTValue T>
-    auto getValue() noexcept
+    IROperand createVariable(StrRef varName, Type *type)
     {
-        return std::get<T>(val);
+        return createVariable(internName(varName), IRSymbol::noNumber, type);
     }
 
-    template <IsValidASTValue T>
-    auto getValue() const noexcept
+    /// \brief Create a variable named `prefix` followed by `number`.
+    IROperand createVariable(IRNameID prefix, uint32_t number, Type *type);
+
+    IROperand createLabel(StrRef labelName)
     {
-        return std::get<T>(val);
+        return createLabel(internName(labelName), IRSymbol::noNumber);
     }
 
-    template <class Visitor>
-    auto visitValue(Visitor &&vis) const noexcept
+    /// \brief Create a label named `prefix` followed by `number`.
+    IROperand createLabel(IRNameID prefix, uint32_t number);
+
+    /// \return the interned constant `value`.
+    IROperand getConstant(ASTSIntType value);
+
+    /// \return a reference to the function named `funcName`.
+    IROperand getFunctionRef(StrRef funcName)
     {
-        return std::visit(vis, val);
+        return IROperand{IROperand::Kind::Function, internName(funcName)};
     }
 
-    template <IsValidASTValue T>
-    void emplaceValue(T &&val_) noexcept
+    ASTSIntType getConstantValue(IROperand op) const noexcept
     {
-        val.emplace<T>(std::forward<T>(val_));
+        return constants[op.getIndex()];
     }
 
-    template <IsValidASTValue T>
-    constexpr bool holdsValueType() const noexcept
+    StrRef getFunctionName(IROperand op) const noexcept
     {
-        return std::holds_alternative<T>(val);
+        return names[op.getIndex()];
     }
 
-    void setConst() { isConstant = true; }
+    const IRSymbol &getVariable(IROperand op) const noexcept
+    {
+        return vars[op.getIndex()];
+    }
 
-    bool isConst() const
+    const IRSymbol &getLabel(IROperand op) const noexcept
     {
-        return isConstant || irVarType == IRVarType::Constant;
+        return labels[op.getIndex()];
     }
 
-    void setUsed() { isUsed_ = true; }
+    size_t getNumVariables() const noexcept { return vars.size(); }
 
-    bool isUsed() const { return isUsed_; }
+    size_t getNumLabels() const noexcept { return labels.size(); }
 
-    std::string getName() const noexcept;
+    size_t getNumConstants() const noexcept { return constants.size(); }
 
-    // ASSUMPTION: NO SEMANTIC ERROR
-    // ASSUMPTION: NO RVALUE ASSIGNMENT, THUS CONST PROPAGATION
-    IRIDType name;
-    IRVarType irVarType;
-    Type *valType;
-    ASTValueType val;
-    bool isConstant;
-    mutable bool isUsed_ = false;
-};
+    ///
+    /// \brief Drop all variables but the first `size` ones. The dropped
+    /// variables must no longer be referenced.
+    ///
+    void truncateVariables(size_t size) { vars.resize(size); }
 
-// TODO: modify everything
-class IRStmt {
-  public:
-    IRStmt() = delete;
+    void writeOperand(std::ostream &os, IROperand op) const;
 
-    IRStmt(IRType irType_, PtrIRVar op1_, PtrIRVar op2_ = nullptr,
-           PtrIRVar op3_ = nullptr,
-           IRBranchType branchType_ = IRBranchType::None)
-        : irType{irType_}, op1{op1_}, op2{op2_}, op3{op3_},
-          branchType{branchType_}
-    {
-    }
+    std::string getOperandName(IROperand op) const;
 
-    // IRStmt(IRType irType_, Ptr<IRFunction> func, PtrIRVar lhs_)
-    //     : irType{irType_}, target{func.get()}, op1{lhs_}
-    // {
-    // }
+    //===------------------------------------------------------------------===//
+    //                         Statements
 
-    static PtrIRStmt createLabelStmt(PtrIRVar op);
+    IRStmtID createStmt(IRType irType, IROperand op1 = {}, IROperand op2 = {},
+                        IROperand op3 = {},
+                        IRBranchType branchType = IRBranchType::None);
 
-    static PtrIRStmt createFuncDeclStmt(PtrIRVar op);
+    // clang-format off
+
+    IRStmtID createLabelStmt(IROperand label) { return createStmt(IRType::SetLabel, label); }
 
-    static PtrIRStmt createAssignStmt(PtrIRVar lhs, PtrIRVar rhs);
+    IRStmtID createAssignStmt(IROperand lhs, IROperand rhs) { return createStmt(IRType::Assign, lhs, rhs); }
 
-    static PtrIRStmt createArithmeticStmt(IRType irType, PtrIRVar op1,
-                                          PtrIRVar op2, PtrIRVar op3);
+    IRStmtID createArithmeticStmt(IRType irType, IROperand op1, IROperand op2, IROperand op3) { return createStmt(irType, op1, op2, op3); }
 
-    static PtrIRStmt createAddrOfStmt(PtrIRVar op1, PtrIRVar op2);
+    IRStmtID createAddrOfStmt(IROperand op1, IROperand op2) { return createStmt(IRType::AddrOf, op1, op2); }
 
-    static PtrIRStmt createDerefStmt(PtrIRVar op1, PtrIRVar op2);
+    IRStmtID createDerefStmt(IROperand op1, IROperand op2) { return createStmt(IRType::Deref, op1, op2); }
 
-    static PtrIRStmt createCopyToAddrStmt(PtrIRVar op1, PtrIRVar op2);
+    IRStmtID createCopyToAddrStmt(IROperand op1, IROperand op2) { return createStmt(IRType::CopyToAddr, op1, op2); }
 
-    static PtrIRStmt createGotoStmt(PtrIRVar op);
+    IRStmtID createGotoStmt(IROperand label) { return createStmt(IRType::Goto, label); }
 
-    static PtrIRStmt createBranchIfStmt(IRBranchType branchType, PtrIRVar lhs,
-                                        PtrIRVar rhs, PtrIRVar label);
+    IRStmtID createBranchIfStmt(IRBranchType branchType, IROperand lhs, IROperand rhs, IROperand label) { return createStmt(IRType::BranchIf, lhs, rhs, label, branchType); }
 
-    static PtrIRStmt createReturnStmt(PtrIRVar op);
+    IRStmtID createReturnStmt(IROperand op) { return createStmt(IRType::Return, op); }
 
-    static PtrIRStmt createAllocStmt(PtrIRVar op1, PtrIRVar op2);
+    IRStmtID createAllocStmt(IROperand op1, IROperand op2) { return createStmt(IRType::Alloc, op1, op2); }
 
-    static PtrIRStmt createPopCallArgStmt(PtrIRVar op);
+    IRStmtID createPopCallArgStmt(IROperand op) { return createStmt(IRType::PopCallArg, op); }
 
-    static PtrIRStmt createPushCallArgStmt(PtrIRVar op);
+    IRStmtID createPushCallArgStmt(IROperand op) { return createStmt(IRType::PushCallArg, op); }
 
-    static PtrIRStmt createInvokeFuncStmt(PtrIRVar lhs, PtrIRVar func);
+    IRStmtID createInvokeFuncStmt(IROperand lhs, IROperand func) { return createStmt(IRType::InvokeFunc, lhs, func); }
 
-    static PtrIRStmt createReadStmt(PtrIRVar op);
+    IRStmtID createReadStmt(IROperand op) { return createStmt(IRType::Read, op); }
 
-    static PtrIRStmt createWriteStmt(PtrIRVar op);
+    IRStmtID createWriteStmt(IROperand op) { return createStmt(IRType::Write, op); }
 
-    IRType getIRType() const noexcept { return irType; }
+    IRStmtID createPhiStmt(IROperand lhs) { return createStmt(IRType::Phi, lhs); }
 
-    static void assignmentToArithmetic(IRStmt *stmtAssign,
-                                   IRStmt *stmtArith) noexcept;
+    // clang-format on
+
+    IRStmtRef getStmt(IRStmtID id) noexcept;
+
+    size_t getNumStmts() const noexcept { return stmtTypes.size(); }
+
+    /// \return the incoming values of the phi function `id`.
+    IRVec<IRPhiArg> &getPhiArgs(IRStmtID id) { return phiArgs[id]; }
+
+    const IRVec<IRPhiArg> &getPhiArgs(IRStmtID id) const
+    {
+        static const IRVec<IRPhiArg> empty;
+        auto it = phiArgs.find(id);
+        return it == phiArgs.end() ? empty : it->second;
+    }
 
-    static void concatAssign(IRStmt *stmtTail, IRStmt *stmtHead) noexcept;
+    void clearPhiArgs() noexcept { phiArgs.clear(); }
 
-    static void arithmeticToConstAssign(IRStmt *stmtArith, IRVar *cVar1,
-                                        IRVar *cVar2) noexcept;
+    ///
+    /// \brief Release the slots of statements no longer in `body`, and
+    /// renumber the others in program order. Any `IRStmtID` held elsewhere,
+    /// e.g., by a CFG, is invalidated.
+    ///
+    void compact();
+
+    friend std::ostream &operator<<(std::ostream &os,
+                                    const IRFunction &func) noexcept;
+
+    IRIDType name;
+    Type *retTy;
+    IRVec<IROperand> paramList;
+    IRVec<IRStmtID> body;
+
+    // Statement arrays, indexed by IRStmtID
+    IRVec<IRType> stmtTypes;
+    IRVec<IRBranchType> stmtBranchTypes;
+    IRVec<IROperand> stmtOp1s; ///< Stores: Name, Label,
+                               ///< Param, Arg, lvalue of all OP
+    IRVec<IROperand> stmtOp2s; ///< Stores: RHS of assign, 1st OP of Expr
+    IRVec<IROperand> stmtOp3s; ///< Stores: 2nd OP of Expr, Label of IF
+
+  private:
+    std::deque<std::string> names; ///< Stable storage for the keys of nameMap
+    std::unordered_map<StrRef, IRNameID> nameMap;
+    IRVec<IRSymbol> vars;
+    IRVec<IRSymbol> labels;
+    IRVec<ASTSIntType> constants;
+    std::unordered_map<ASTSIntType, uint32_t> constantMap;
+    std::unordered_map<IRStmtID, IRVec<IRPhiArg>> phiArgs;
+};
+
+///
+/// \brief A statement of an `IRFunction`, viewed through its index into the
+/// statement arrays. It is as cheap to pass around as a pointer.
+///
+class IRStmtRef {
+  public:
+    IRStmtRef(IRFunction &func_, IRStmtID id_) noexcept : func{&func_}, id{id_}
+    {
+    }
+
+    IRStmtID getID() const noexcept { return id; }
+
+    IRFunction &getFunction() const noexcept { return *func; }
+
+    IRType getIRType() const noexcept { return func->stmtTypes[id]; }
+
+    IRBranchType getBranchType() const noexcept
+    {
+        return func->stmtBranchTypes[id];
+    }
+
+    void setBranchType(IRBranchType branchType) const noexcept
+    {
+        func->stmtBranchTypes[id] = branchType;
+    }
+
+    IROperand &op1() const noexcept { return func->stmtOp1s[id]; }
+
+    IROperand &op2() const noexcept { return func->stmtOp2s[id]; }
+
+    IROperand &op3() const noexcept { return func->stmtOp3s[id]; }
+
+    IRVec<IRPhiArg> &getPhiArgs() const { return func->getPhiArgs(id); }
 
     // clang-format off
 
@@ -257,54 +414,105 @@ class IRStmt {
 
     bool isWrite() const noexcept { return getIRType() == IRType::Write; }
 
+    bool isPhi() const noexcept { return getIRType() == IRType::Phi; }
+
     // clang-format on
 
-    friend std::ostream &operator<<(std::ostream &os,
-                                    const IRStmt &stmt) noexcept;
-
-    IRType irType;
-    IRBranchType branchType = IRBranchType::None;
-    PtrIRVar op1 = nullptr; ///< Stores: Name, Label,
-                            ///< Param, Arg, lvalue of all OP
-    PtrIRVar op2 = nullptr; ///< Stores: RHS of assign, 1st OP of Expr
-    PtrIRVar op3 = nullptr; ///< Stores:
-    // IRFunction *target = nullptr;
-
-    IRStmt *prev = nullptr;
-    IRStmt *next = nullptr;
-};
+    ///
+    /// \brief Get the operand holding the variable defined by this statement.
+    /// \return `nullptr` if no variable is defined. `Alloc` is not considered
+    /// as a definition, as it reserves memory instead of producing a value.
+    ///
+    IROperand *getDefOperand() const noexcept;
 
-class IRSB : public IRStmt {};
+    /// \return the label operand of `Goto` and `BranchIf`, or `nullptr`.
+    IROperand *getJumpTarget() const noexcept
+    {
+        if (isGoto())
+            return &op1();
+        if (isBranchIf())
+            return &op3();
+        return nullptr;
+    }
 
-class IRFunction {
-  public:
-    IRFunction(IRIDType name_, Type *retTy_) : name{name_}, retTy{retTy_} {}
+    ///
+    /// \brief Call `fn` with each operand whose value is read, including the
+    /// address operand of `CopyToAddr` and the incoming values of `Phi`.
+    ///
+    template <class Fn>
+    void forEachUseOperand(Fn &&fn) const
+    {
+        switch (getIRType()) {
+        case IRType::Assign:
+        case IRType::AddrOf:
+        case IRType::Deref:
+        case IRType::Alloc: {
+            fn(op2());
+            break;
+        }
+        case IRType::Plus:
+        case IRType::Minus:
+        case IRType::Mul:
+        case IRType::Div: {
+            fn(op2());
+            fn(op3());
+            break;
+        }
+        case IRType::BranchIf:
+        case IRType::CopyToAddr: {
+            fn(op1());
+            fn(op2());
+            break;
+        }
+        case IRType::Return:
+        case IRType::PushCallArg:
+        case IRType::Write: {
+            fn(op1());
+            break;
+        }
+        case IRType::Phi: {
+            for (auto &arg : getPhiArgs())
+                fn(arg.first);
+            break;
+        }
+        default:
+            break;
+        }
+    }
 
-    static Ptr<IRFunction> create(IRIDType name_, Type *retTy_);
+    ///
+    /// \brief Return true if this statement must be kept even if the variable
+    /// it defines is never used.
+    ///
+    bool hasSideEffects() const noexcept
+    {
+        return !(isAssign() || isArithmetic() || isAddrOf() || isDeref() ||
+                 isPhi());
+    }
 
     friend std::ostream &operator<<(std::ostream &os,
-                                    const IRFunction &func) noexcept;
+                                    const IRStmtRef &stmt) noexcept;
 
-    IRIDType name;
-    Type *retTy;
-    IRVec<PtrIRVar> varList;
-    IRMap<IRIDType, PtrIRVar> varMap;
-    IRVec<PtrIRVar> paramList;
-    IRVec<PtrIRStmt> body;
+  private:
+    IRFunction *func;
+    IRStmtID id;
 };
 
+inline IRStmtRef IRFunction::getStmt(IRStmtID id) noexcept
+{
+    return IRStmtRef{*this, id};
+}
+
 class IRProgram {
   public:
-    IRProgram(IRMap<IRIDType, Ptr<IRFunction>> funcMap_,
-              IRMap<IRIDType, PtrIRVar> funcVarMap_) noexcept
-        : funcMap{funcMap_}, funcVarMap{funcVarMap_}
+    IRProgram(IRMap<IRIDType, Ptr<IRFunction>> funcMap_) noexcept
+        : funcMap{std::move(funcMap_)}
     {
     }
 
-    static Ptr<IRProgram> make(IRMap<IRIDType, Ptr<IRFunction>> funcMap_,
-                               IRMap<IRIDType, PtrIRVar> funcVarMap_)
+    static Ptr<IRProgram> make(IRMap<IRIDType, Ptr<IRFunction>> funcMap_)
     {
-        return makeSharedPtr<IRProgram>(funcMap_, funcVarMap_);
+        return makeSharedPtr<IRProgram>(std::move(funcMap_));
     }
 
     static void writeAllIRStmt(std::ostream &os,
@@ -321,12 +529,19 @@ class IRProgram {
     }
 
     IRMap<IRIDType, Ptr<IRFunction>> funcMap;
-    IRMap<IRIDType, PtrIRVar> funcVarMap;
 };
 
-std::ostream &operator<<(std::ostream &os, const IRStmt &stmt) noexcept;
+std::ostream &operator<<(std::ostream &os, const IRStmtRef &stmt) noexcept;
 
 std::ostream &operator<<(std::ostream &os, const IRFunction &func) noexcept;
 } // namespace splc::SIR
 
+template <>
+struct std::hash<splc::SIR::IROperand> {
+    size_t operator()(const splc::SIR::IROperand &op) const noexcept
+    {
+        return std::hash<uint32_t>{}(op.getBits());
+    }
+};
+
 #endif // __SPLC_SIR_IR_HH__
@@ -19,44 +19,49 @@ class IRBuilder {
   public:
     IRBuilder(SPLCContext &C) noexcept : tyCtx(C) {}
 
-    PtrIRVar getTmpLabel();
-    PtrIRVar getTmpVar();
+    IROperand getTmpLabel();
+    IROperand getTmpVar();
+
+    /// \brief Intern an AST constant into the table of the current function.
+    IROperand getConstant(const ASTValueType &val);
 
     // ------------------------ register ------------------------
 
     // register declaration
 
-    void recRegisterDeclVar(IRVec<PtrIRStmt> &stmtList, PtrAST declRoot);
+    void recRegisterDeclVar(IRVec<IRStmtID> &stmtList, const PtrAST &declRoot);
 
     // register expr
 
-    PtrIRVar recRegisterExprs(IRVec<PtrIRStmt> &stmtList, PtrAST exprRoot);
-    PtrIRVar recRegisterCallExpr(IRVec<PtrIRStmt> &stmtList, PtrAST exprRoot);
-    void recRegisterCondExpr(IRVec<PtrIRStmt> &stmtList, PtrAST exprRoot,
-                             PtrIRVar lbt, PtrIRVar lbf);
+    IROperand recRegisterExprs(IRVec<IRStmtID> &stmtList,
+                               const PtrAST &exprRoot);
+    IROperand recRegisterCallExpr(IRVec<IRStmtID> &stmtList,
+                                  const PtrAST &exprRoot);
+    void recRegisterCondExpr(IRVec<IRStmtID> &stmtList, const PtrAST &exprRoot,
+                             IROperand lbt, IROperand lbf);
 
     // register stmt
 
-    void recRegisterIterStmt(IRVec<PtrIRStmt> &stmtList, PtrAST stmtRoot);
-    void recRegisterSelStmt(IRVec<PtrIRStmt> &stmtList, PtrAST stmtRoot);
-    void recRegisterJumpStmt(IRVec<PtrIRStmt> &stmtList, PtrAST stmtRoot);
+    void recRegisterIterStmt(IRVec<IRStmtID> &stmtList, const PtrAST &stmtRoot);
+    void recRegisterSelStmt(IRVec<IRStmtID> &stmtList, const PtrAST &stmtRoot);
+    void recRegisterJumpStmt(IRVec<IRStmtID> &stmtList, const PtrAST &stmtRoot);
 
-    void recRegisterStmts(IRVec<PtrIRStmt> &stmtList, PtrAST stmtRoot);
+    void recRegisterStmts(IRVec<IRStmtID> &stmtList, const PtrAST &stmtRoot);
 
     // register function
 
-    void registerFunction(PtrAST funcRoot);
+    void registerFunction(const PtrAST &funcRoot);
 
     // ----------------------------------------------------------
 
-    void recParseAST(PtrAST parseRoot);
+    void recParseAST(const PtrAST &parseRoot);
 
-    Ptr<IRProgram> makeProgram(PtrAST parseRoot)
+    Ptr<IRProgram> makeProgram(const PtrAST &parseRoot)
     {
         recParseAST(parseRoot);
-        auto prorgam = IRProgram::make(funcMap, funcVarMap);
+        auto prorgam = IRProgram::make(std::move(funcMap));
         funcMap.clear();
-        funcVarMap.clear();
+        varMap.clear();
         currentFunc.reset();
         return prorgam;
     }
@@ -65,14 +70,16 @@ class IRBuilder {
     SPLCContext &tyCtx;
 
     IRMap<IRIDType, Ptr<IRFunction>> funcMap;
-    IRMap<IRIDType, PtrIRVar> funcVarMap;
 
     Ptr<IRFunction> currentFunc;
+    IRMap<IRIDType, IROperand> varMap; ///< Variables of currentFunc
+    IRNameID tmpVarPrefix = 0;
+    IRNameID tmpLabelPrefix = 0;
 };
 
 class IRBuilderHelper {
   public:
-    static IRVec<IRIDType> recfindFuncParam(PtrAST funcRoot)
+    static IRVec<IRIDType> recfindFuncParam(const PtrAST &funcRoot)
     {
         IRVec<IRIDType> vec;
         _recfindFuncParam(vec, funcRoot);
@@ -80,7 +87,7 @@ class IRBuilderHelper {
     }
 
   protected:
-    static void _recfindFuncParam(IRVec<IRIDType> &vec, PtrAST funcRoot)
+    static void _recfindFuncParam(IRVec<IRIDType> &vec, const PtrAST &funcRoot)
     {
         ASTSymType type = funcRoot->getSymType();
         if (type == ASTSymType::FuncDef && funcRoot->getChildrenNum() == 3) {
@@ -102,12 +109,6 @@ class IRBuilderHelper {
     }
 };
 
-inline void linkStmt(PtrIRStmt prev, PtrIRStmt next)
-{
-    prev->next = next.get();
-    next->prev = prev.get();
-}
-
 } // namespace splc::SIR
 
 #endif // __SPLC_SIR_IRBUILDER_HH__
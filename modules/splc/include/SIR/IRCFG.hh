@@ -0,0 +1,259 @@
+#ifndef __SPLC_SIR_IRCFG_HH__
+#define __SPLC_SIR_IRCFG_HH__ 1
+
+#include <optional>
+#include <ostream>
+#include <unordered_set>
+
+#include "SIR/IR.hh"
+
+namespace splc::SIR {
+
+class IRCFG;
+
+///
+/// \brief A basic block of SIR statements.
+///
+/// A block begins at the entry of the function or at a `SetLabel`, which is
+/// kept as the first statement of the block, and ends after the first `Goto`,
+/// `BranchIf` or `Return`, or right before the next label. A block that does
+/// not end with `Goto` or `Return` falls through to the block following it in
+/// the layout of the CFG.
+///
+class IRSB {
+  public:
+    IRSB(IRFunction &func_, size_t id_) : func{&func_}, id{id_} {}
+
+    /// \return the statement at position `pos` of the block.
+    IRStmtRef getStmt(size_t pos) const noexcept
+    {
+        return func->getStmt(stmts[pos]);
+    }
+
+    /// \return the label of the block, or an empty operand if it has none.
+    IROperand getLabel() const noexcept;
+
+    /// \return the trailing `Goto`, `BranchIf` or `Return`, if any.
+    std::optional<IRStmtRef> getTerminator() const noexcept;
+
+    /// \return the index of the first statement that is not a label.
+    size_t getFirstNonLabel() const noexcept
+    {
+        return !stmts.empty() && getStmt(0).isSetLabel() ? 1 : 0;
+    }
+
+    bool hasFallThrough() const noexcept
+    {
+        auto term = getTerminator();
+        return !term || term->isBranchIf();
+    }
+
+    IRFunction *func;
+    size_t id; ///< Index in the layout of the CFG
+    IRVec<IRStmtID> stmts;
+    IRVec<IRSB *> preds;
+    IRVec<IRSB *> succs; ///< For `BranchIf`, the branch target comes first
+};
+
+///
+/// \brief Dominator tree of a CFG, computed with the iterative algorithm of
+/// Cooper, Harvey and Kennedy over the reverse postorder of the blocks.
+///
+/// Blocks unreachable from the entry are not part of the tree: they have no
+/// immediate dominator and are neither dominated by nor dominate any block.
+///
+class IRDomTree {
+  public:
+    void recalculate(const IRCFG &cfg);
+
+    IRSB *getIDom(const IRSB *bb) const noexcept { return idoms[bb->id]; }
+
+    const IRVec<IRSB *> &getChildren(const IRSB *bb) const noexcept
+    {
+        return children[bb->id];
+    }
+
+    /// \return the dominance frontier of `bb`.
+    const IRVec<IRSB *> &getFrontier(const IRSB *bb) const noexcept
+    {
+        return frontiers[bb->id];
+    }
+
+    bool isReachable(const IRSB *bb) const noexcept
+    {
+        return rpoIndex[bb->id] != unvisited;
+    }
+
+    /// \return true if `a` dominates `b`. Every reachable block dominates
+    /// itself.
+    bool dominates(const IRSB *a, const IRSB *b) const noexcept
+    {
+        if (!isReachable(a) || !isReachable(b))
+            return false;
+        return dfsIn[a->id] <= dfsIn[b->id] && dfsOut[b->id] <= dfsOut[a->id];
+    }
+
+    /// \return all reachable blocks, in reverse postorder.
+    const IRVec<IRSB *> &getReversePostOrder() const noexcept { return rpo; }
+
+  private:
+    static constexpr size_t unvisited = static_cast<size_t>(-1);
+
+    IRSB *intersect(IRSB *a, IRSB *b) const noexcept;
+
+    IRVec<IRSB *> rpo;
+    IRVec<size_t> rpoIndex;
+    IRVec<IRSB *> idoms;
+    IRVec<IRVec<IRSB *>> children;
+    IRVec<IRVec<IRSB *>> frontiers;
+    IRVec<size_t> dfsIn;
+    IRVec<size_t> dfsOut;
+};
+
+///
+/// \brief Control-flow graph of an `IRFunction`.
+///
+/// The CFG owns the body of the function while it is alive: passes edit the
+/// blocks through the update methods below, which keep the edges in sync
+/// locally, then call `writeBack()` to store the result in the body of the
+/// function. New statements are created in the statement arrays of the
+/// function before being inserted. The dominator tree is recomputed lazily,
+/// only if the edges have changed since it was last requested.
+///
+/// The entry block never has predecessors. If the body starts with a label
+/// that is jumped to, an empty entry block is placed in front of it.
+///
+class IRCFG {
+  public:
+    IRCFG(Ptr<IRFunction> func_)
+        : func{func_}, labelPrefix{func->internName(func->name + "_bb_")}
+    {
+        rebuild();
+    }
+
+    IRCFG(const IRCFG &other) = delete;
+    IRCFG &operator=(const IRCFG &other) = delete;
+
+    static Ptr<IRCFG> create(Ptr<IRFunction> func)
+    {
+        return makeSharedPtr<IRCFG>(func);
+    }
+
+    /// \brief Rebuild the graph from the body of the function.
+    void rebuild();
+
+    /// \brief Store the statements of all blocks, in layout order, as the body
+    /// of the function.
+    void writeBack() const;
+
+    auto getFunction() const noexcept { return func; }
+
+    IRSB *getEntry() const noexcept { return blocks.front().get(); }
+
+    const IRVec<UniquePtr<IRSB>> &getBlocks() const noexcept { return blocks; }
+
+    size_t size() const noexcept { return blocks.size(); }
+
+    /// \return the block labeled `label`.
+    IRSB *findBlock(IROperand label) const;
+
+    /// \return the block placed right after `bb` in the layout, if any.
+    IRSB *getLayoutSuccessor(const IRSB *bb) const noexcept
+    {
+        return bb->id + 1 < blocks.size() ? blocks[bb->id + 1].get() : nullptr;
+    }
+
+    const IRDomTree &getDomTree();
+
+    //===------------------------------------------------------------------===//
+    //                        Incremental updates
+
+    /// \brief Insert `stmt` before position `pos` of `bb`. Labels cannot be
+    /// inserted.
+    void insertStmt(IRSB *bb, size_t pos, IRStmtID stmt);
+
+    void eraseStmt(IRSB *bb, size_t pos);
+
+    void replaceStmt(IRSB *bb, size_t pos, IRStmtID stmt);
+
+    ///
+    /// \brief Recompute the successors of `bb` from its terminator, updating
+    /// the predecessor lists of the blocks involved. This must be called
+    /// whenever the terminator of `bb` is modified in place.
+    ///
+    void updateEdges(IRSB *bb);
+
+    ///
+    /// \brief Place an empty block on the edge `from -> to`.
+    /// \return the new block, which falls through or jumps to `to`.
+    ///
+    IRSB *splitEdge(IRSB *from, IRSB *to);
+
+    /// \return the label of `bb`, creating one if necessary.
+    IROperand getOrCreateLabel(IRSB *bb);
+
+    ///
+    /// \brief Remove the blocks unreachable from the entry, unlinking them
+    /// from their successors.
+    /// \return the number of blocks removed.
+    ///
+    size_t removeUnreachableBlocks();
+
+    friend std::ostream &operator<<(std::ostream &os, const IRCFG &cfg);
+
+  private:
+    IRSB *insertBlock(size_t pos);
+
+    /// \return a position where a new block can be placed without becoming
+    /// the fall-through successor of an existing block.
+    size_t findDetachedPosition() const noexcept;
+
+    void renumberBlocks(size_t from) noexcept;
+
+    void computeSuccessors(const IRSB *bb, IRVec<IRSB *> &succs) const;
+
+    Ptr<IRFunction> func;
+    IRVec<UniquePtr<IRSB>> blocks;
+    IRVec<IRSB *> labelMap; ///< Indexed by the label table of the function
+    IRNameID labelPrefix;
+
+    IRDomTree domTree;
+    bool domTreeValid = false;
+};
+
+std::ostream &operator<<(std::ostream &os, const IRCFG &cfg);
+
+///
+/// \brief A natural loop: the header and the blocks that reach one of its
+/// back edges without going through the header.
+///
+struct IRLoop {
+    bool contains(const IRSB *bb) const noexcept
+    {
+        return blockSet.contains(bb);
+    }
+
+    IRSB *header;
+    IRVec<IRSB *> blocks;  ///< In layout order, including the header
+    IRVec<IRSB *> latches; ///< Sources of the back edges
+    std::unordered_set<const IRSB *> blockSet;
+};
+
+///
+/// \brief Natural loops of a CFG. Back edges to the same header belong to
+/// the same loop.
+///
+class IRLoopInfo {
+  public:
+    void recalculate(IRCFG &cfg);
+
+    /// \return the loops, each placed before the loops enclosing it.
+    const IRVec<IRLoop> &getLoops() const noexcept { return loops; }
+
+  private:
+    IRVec<IRLoop> loops;
+};
+
+} // namespace splc::SIR
+
+#endif // __SPLC_SIR_IRCFG_HH__
@@ -0,0 +1,84 @@
+#ifndef __SPLC_SIR_IRINLINER_HH__
+#define __SPLC_SIR_IRINLINER_HH__ 1
+
+#include "SIR/IR.hh"
+
+namespace splc::SIR {
+
+///
+/// \brief Inlines the calls to small functions of an `IRProgram`.
+///
+/// Functions are visited bottom-up in the call graph, so that callees have
+/// already been inlined into and optimized when their own callers are
+/// considered. Functions that are part of a recursive cycle are never
+/// inlined.
+///
+/// The body of the callee is cloned at the call site with its variables and
+/// labels renamed. Each `ARG` of the call becomes an assignment to the clone of
+/// its parameter, and each `RETURN` an assignment to the result followed by a
+/// jump past the body. Constant propagation is run again on the functions
+/// that have received inlined code, and the functions whose calls have all
+/// been inlined are removed.
+///
+class IRInliner {
+  public:
+    ///
+    /// \brief Parameters of the cost model.
+    ///
+    /// The cost of inlining a call is the size of the callee, minus the
+    /// statements of the calling sequence that disappear and the bonuses.
+    /// Calls whose cost is at most `threshold` are inlined, as long as the
+    /// caller does not grow past `maxFunctionSize` statements.
+    ///
+    struct Params {
+        long threshold = 12;
+        long constantArgBonus = 4; ///< Per constant argument
+        long singleCallBonus = 24; ///< If this is the only call to the callee
+        size_t maxFunctionSize = 2000;
+    };
+
+    explicit IRInliner(IRProgram &program_) : IRInliner{program_, Params{}} {}
+
+    IRInliner(IRProgram &program_, Params params_)
+        : program{program_}, params{params_}
+    {
+    }
+
+    void run();
+
+    /// \return the number of calls inlined by `run()`.
+    size_t getNumInlined() const noexcept { return numInlined; }
+
+  private:
+    struct CallSite;
+
+    /// \return the functions, callees before callers, and mark the recursive
+    /// ones.
+    IRVec<Ptr<IRFunction>> sortBottomUp();
+
+    /// \brief Count the calls to each function in the program.
+    void countCalls();
+
+    /// \return true if any call has been inlined into `caller`.
+    bool inlineCallsIn(IRFunction &caller);
+
+    bool shouldInline(IRFunction &caller, IRFunction &callee,
+                      const CallSite &site, size_t callerSize);
+
+    ///
+    /// \brief Append to `newBody` the body of `callee` for the call `site`
+    /// in `caller`, rewriting the arguments already in `newBody`.
+    ///
+    void inlineCall(IRFunction &caller, IRFunction &callee,
+                    const CallSite &site, IRVec<IRStmtID> &newBody);
+
+    IRProgram &program;
+    Params params;
+    IRMap<IRIDType, size_t> callCounts;
+    IRMap<IRIDType, bool> recursive;
+    size_t numInlined = 0;
+};
+
+} // namespace splc::SIR
+
+#endif // __SPLC_SIR_IRINLINER_HH__
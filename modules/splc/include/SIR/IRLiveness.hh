@@ -0,0 +1,95 @@
+#ifndef __SPLC_SIR_IRLIVENESS_HH__
+#define __SPLC_SIR_IRLIVENESS_HH__ 1
+
+#include <cstdint>
+
+#include "SIR/IRCFG.hh"
+
+namespace splc::SIR {
+
+///
+/// \brief Fixed-size set of small integers, stored as 64-bit words.
+///
+class IRBitVector {
+  public:
+    IRBitVector(size_t size_ = 0) : words((size_ + 63) / 64, 0) {}
+
+    bool test(size_t i) const noexcept
+    {
+        return (words[i / 64] >> (i % 64)) & 1;
+    }
+
+    void set(size_t i) noexcept { words[i / 64] |= uint64_t{1} << (i % 64); }
+
+    void reset(size_t i) noexcept
+    {
+        words[i / 64] &= ~(uint64_t{1} << (i % 64));
+    }
+
+    /// \return true if any bit has been added.
+    bool unionWith(const IRBitVector &other) noexcept
+    {
+        bool changed = false;
+        for (size_t i = 0; i < words.size(); ++i) {
+            uint64_t res = words[i] | other.words[i];
+            changed |= res != words[i];
+            words[i] = res;
+        }
+        return changed;
+    }
+
+    bool operator==(const IRBitVector &other) const noexcept = default;
+
+    IRVec<uint64_t> words;
+};
+
+///
+/// \brief Live variables at the boundaries of the blocks of a CFG.
+///
+/// Only variables kept in registers are tracked, with the bit index of a
+/// variable being its index into the variable table of the function.
+/// Variables whose address is taken or which are declared with `DEC` live in
+/// memory and are considered live everywhere.
+///
+class IRLiveness {
+  public:
+    static constexpr size_t npos = static_cast<size_t>(-1);
+
+    IRLiveness(const IRCFG &cfg_) : cfg{cfg_} {}
+
+    /// \brief Solve the dataflow equations for the current state of the CFG.
+    void recalculate();
+
+    /// \return the bit index of `var`, or `npos` if it is not tracked.
+    size_t getIndex(IROperand var) const noexcept
+    {
+        if (!var.isVariable() || var.getIndex() >= inMemory.size() ||
+            inMemory[var.getIndex()])
+            return npos;
+        return var.getIndex();
+    }
+
+    size_t getNumVars() const noexcept { return inMemory.size(); }
+
+    const IRBitVector &getLiveIn(const IRSB *bb) const noexcept
+    {
+        return liveIn[bb->id];
+    }
+
+    const IRBitVector &getLiveOut(const IRSB *bb) const noexcept
+    {
+        return liveOut[bb->id];
+    }
+
+  private:
+    void findInMemoryVariables();
+
+    const IRCFG &cfg;
+    IRVec<bool> inMemory;
+    IRVec<IRBitVector> liveIn;
+    IRVec<IRBitVector> liveOut;
+};
+
+} // namespace splc::SIR
+
+#endif // __SPLC_SIR_IRLIVENESS_HH__
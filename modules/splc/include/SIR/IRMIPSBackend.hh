@@ -0,0 +1,47 @@
+#ifndef __SPLC_SIR_IRMIPSBACKEND_HH__
+#define __SPLC_SIR_IRMIPSBACKEND_HH__ 1
+
+#include <ostream>
+
+#include "SIR/IR.hh"
+
+namespace splc::SIR {
+
+///
+/// \brief Translates SIR into MIPS32 assembly that runs on SPIM and MARS.
+///
+/// Each function is divided into basic blocks and its variables are given
+/// live intervals over the layout of the blocks, from the liveness analysis.
+/// Registers are then assigned with the linear scan algorithm of Poletto and
+/// Sarkar: `$t0-$t7` for intervals not crossing a call, `$s0-$s7` for all
+/// intervals, spilling the interval that ends last when none is free.
+/// Spilled intervals that do not overlap share a stack slot.
+///
+/// Calling convention:
+///  - `ARG` pushes a word on the stack; the callee reads its `n`-th `PARAM`
+///    at `4n($fp)` and the caller pops the arguments after `jal`.
+///  - The result is returned in `$v0`.
+///  - `$fp` holds the stack pointer of the caller. Below it are `$ra`, the
+///    previous `$fp`, the `$s` registers used by the function, the spill slots
+///    and the variables that live in memory.
+///  - `$t8`, `$t9`, `$v0` and `$a0` are scratch registers.
+///
+/// `READ` and `WRITE` are expanded into system calls.
+///
+class IRMIPSBackend {
+  public:
+    /// \brief Write `program` as an assembly file, starting with a stub that
+    /// calls `main` and exits.
+    static void writeProgram(std::ostream &os, Ptr<IRProgram> program);
+
+    /// \brief Write the code of `func`. Calls are resolved against `program`.
+    static void writeFunction(std::ostream &os, const IRProgram &program,
+                              Ptr<IRFunction> func);
+
+    /// \return the assembly label of the function `name`.
+    static std::string getFunctionLabel(StrRef name);
+};
+
+} // namespace splc::SIR
+
+#endif // __SPLC_SIR_IRMIPSBACKEND_HH__
@@ -3,120 +3,56 @@
 
 #include "SIR/IRBase.hh"
 #include "SIR/IRBuilder.hh"
+#include "SIR/IRCFG.hh"
+#include "SIR/IRLiveness.hh"
+#include "SIR/IRSSA.hh"
 
 namespace splc::SIR {
 
-class DepNode {
-  public:
-    enum class Type {
-        Unspecified,
-        Input,
-        Mid,
-        Output,
-    };
-
-    enum class Color {
-        Marked,
-        Unmarked,
-    };
-
-  public:
-    DepNode(IRVar *var_, IRStmt *stmt_, Type type_)
-        : type{type_}, color{Color::Unmarked}, var{var_}, stmt{stmt_}
-    {
-    }
-
-    static Ptr<DepNode> make(IRVar *var, IRStmt *stmt, Type type) noexcept
-    {
-        return makeSharedPtr<DepNode>(var, stmt, type);
-    }
-
-    static Ptr<DepNode> make(Ptr<IRVar> var, Ptr<IRStmt> stmt,
-                             Type type) noexcept
-    {
-        return makeSharedPtr<DepNode>(var.get(), stmt.get(), type);
-    }
-
-    static void connect(Ptr<DepNode> parent, Ptr<DepNode> child) noexcept
-    {
-        parent->children.insert(child.get());
-        child->parents.insert(parent.get());
-    }
-
-    static void disconnect(Ptr<DepNode> parent, Ptr<DepNode> child) noexcept
-    {
-        parent->children.erase(child.get());
-        child->parents.erase(parent.get());
-    }
-
-    void setType(Type type_) noexcept { type = type_; }
-
-    auto getType() const noexcept { return type; }
-
-    void setColor(Color color_) noexcept { color = color_; }
-
-    auto getColor() const noexcept { return color; }
-
-    auto isUnmarked() const noexcept { return color == Color::Unmarked; }
-
-    auto isMarked() const noexcept { return color == Color::Marked; }
-
-    void setUnmarked() noexcept { color = Color::Unmarked; }
-
-    void setMarked() noexcept { color = Color::Marked; }
-
-    auto getVar() const noexcept { return var; }
-
-    void setVar(IRVar *var_) noexcept { var = var_; }
-
-    auto getStmt() const noexcept { return stmt; }
-
-    void setStmt(IRStmt *stmt_) noexcept { stmt = stmt_; }
-
-    auto getParents() noexcept { return parents; }
-
-    auto getParents() const noexcept { return parents; }
-
-    auto getChildren() noexcept { return children; }
-
-    auto getChildren() const noexcept { return children; }
-
-    Type type;
-    Color color;
-    IRVar *var;
-    IRStmt *stmt;
-    IRSet<DepNode *> parents;
-    IRSet<DepNode *> children;
-};
-
-using DepNodeList = IRVec<Ptr<DepNode>>;
-using DepNodeMap = std::map<IRVar *, Ptr<DepNode>>;
-using DepKey = std::tuple<DepNodeList, DepNodeMap, DepNodeList, DepNodeList>;
-
 class IROptimizer {
   public:
-  protected:
-    static void examineStmt(DepKey &key, Ptr<IRFunction> func,
-                            Ptr<IRStmt> &stmt);
-
-    static void examineStmt(DepKey &key, Ptr<IRFunction> func,
-                            decltype(func->body.begin()) it);
-
-    static DepKey buildDependency(Ptr<IRFunction> func);
-
-    static void searchBranchIf(DepKey &key, Ptr<IRFunction> func,
-                               decltype(func->body.begin()) it);
-
-  public:
+    ///
+    /// \brief Remove the statements defining variables that are dead, based on
+    /// a global liveness analysis. Calls, reads and stores are always kept.
+    ///
     static void removeUnusedStmts(Ptr<IRFunction> func);
 
+    ///
+    /// \brief Propagate constants with SCCP on the SSA form of `func`. Branches
+    /// on constants are folded and the blocks never executed are removed.
+    ///
     static void constantPropagate(Ptr<IRFunction> func);
 
+    ///
+    /// \brief Number the values computed in each block of `func`, replacing
+    /// recomputed expressions and loads with copies and simplifying
+    /// arithmetic algebraically. The temporaries made redundant are left to
+    /// `removeUnusedStmts`.
+    ///
     static void optimizeArithmetic(Ptr<IRFunction> func);
 
+    ///
+    /// \brief Hoist the loop-invariant arithmetic and addresses of `func`
+    /// into loop preheaders, and strength-reduce the multiplications of
+    /// induction variables into additions.
+    ///
+    static void optimizeLoops(Ptr<IRFunction> func);
+
+    ///
+    /// \brief Clean up the control flow of `func`: jumps to jumps and runs of
+    /// labels are threaded to their final target, jumps to the next
+    /// statement are removed, a conditional jump over an unconditional one is
+    /// inverted, and unreferenced labels and unreachable statements are
+    /// deleted.
+    ///
+    static void simplifyJumps(Ptr<IRFunction> func);
+
+    /// \brief Run the default pipeline of `IRPassManager` on `func`.
     static void optimizeFunction(Ptr<IRFunction> func);
 
-    static void optimizeProgram(Ptr<IRProgram> func);
+    /// \brief Run the default pipeline on all functions of `prog`, using up
+    /// to `numThreads` threads.
+    static void optimizeProgram(Ptr<IRProgram> prog, unsigned numThreads = 1);
 };
 
 } // namespace splc::SIR
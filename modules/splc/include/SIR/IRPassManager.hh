@@ -0,0 +1,117 @@
+#ifndef __SPLC_SIR_IRPASSMANAGER_HH__
+#define __SPLC_SIR_IRPASSMANAGER_HH__ 1
+
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <ostream>
+
+#include "SIR/IR.hh"
+
+namespace splc::SIR {
+
+///
+/// \brief Runs a pipeline of function passes over the functions of an
+/// `IRProgram`.
+///
+/// Passes are registered in pipeline order under a unique name, and can be
+/// disabled by name without being removed. Functions are optimized
+/// concurrently, each by a single worker, which is safe as functions share no
+/// mutable state. With fixpoint iteration on, the pipeline is repeated on a
+/// function until one round leaves its body unchanged.
+///
+/// Program passes, such as the inliner, work across functions. They run once,
+/// in pipeline order and on the calling thread, before the function passes.
+///
+/// Statistics are aggregated over all functions: the time spent in each pass
+/// and the number of statements it added or removed.
+///
+class IRPassManager {
+  public:
+    using PassFn = std::function<void(Ptr<IRFunction>)>;
+    using ProgramPassFn = std::function<void(IRProgram &)>;
+
+    struct PassStats {
+        size_t numRuns = 0;
+        std::chrono::nanoseconds time{0};
+        long long stmtDelta = 0; ///< Statements after minus before
+    };
+
+    IRPassManager() = default;
+
+    /// \brief Append `fn` to the pipeline under `name`.
+    IRPassManager &addPass(IRIDType name, PassFn fn);
+
+    /// \brief Append the program pass `fn` to the pipeline under `name`.
+    IRPassManager &addProgramPass(IRIDType name, ProgramPassFn fn);
+
+    bool hasPass(StrRef name) const noexcept;
+
+    /// \brief Enable or disable the pass `name`.
+    /// \return false if there is no such pass.
+    bool setEnabled(StrRef name, bool enabled);
+
+    bool isEnabled(StrRef name) const noexcept;
+
+    ///
+    /// \brief Repeat the pipeline on each function until it reaches a
+    /// fixpoint, but at most `maxIterations_` times.
+    ///
+    void setFixpoint(bool fixpoint_, size_t maxIterations_ = 8) noexcept
+    {
+        fixpoint = fixpoint_;
+        maxIterations = maxIterations_;
+    }
+
+    void setNumThreads(unsigned numThreads_) noexcept
+    {
+        numThreads = std::max(numThreads_, 1U);
+    }
+
+    /// \brief Run the pipeline on all functions of `program`.
+    void run(IRProgram &program);
+
+    ///
+    /// \brief Run the function passes of the pipeline on `func` alone, on the
+    /// calling thread.
+    ///
+    void run(Ptr<IRFunction> func);
+
+    /// \return the statistics of the pass at position `i` of the pipeline.
+    const PassStats &getStats(size_t i) const noexcept { return stats[i]; }
+
+    void clearStats() noexcept;
+
+    /// \brief Print a table with the statistics of each pass.
+    void printStats(std::ostream &os) const;
+
+    ///
+    /// \brief Create a pass manager with the standard SIR pipeline:
+    /// `inline`, `constprop`, `lvn`, `loops`, `dce` and `simplify-jumps`.
+    ///
+    static IRPassManager createDefault();
+
+  private:
+    struct Pass {
+        IRIDType name;
+        PassFn fn;
+        ProgramPassFn programFn; ///< Set for program passes only
+        bool enabled = true;
+    };
+
+    /// \brief Run the pipeline on `func`, adding statistics to `localStats`.
+    void runOnFunction(const Ptr<IRFunction> &func,
+                       IRVec<PassStats> &localStats) const;
+
+    void mergeStats(const IRVec<PassStats> &localStats) noexcept;
+
+    IRVec<Pass> passes;
+    IRVec<PassStats> stats;
+    bool fixpoint = false;
+    size_t maxIterations = 8;
+    unsigned numThreads = 1;
+};
+
+} // namespace splc::SIR
+
+#endif // __SPLC_SIR_IRPASSMANAGER_HH__
@@ -0,0 +1,59 @@
+#ifndef __SPLC_SIR_IRSSA_HH__
+#define __SPLC_SIR_IRSSA_HH__ 1
+
+#include "SIR/IRCFG.hh"
+
+namespace splc::SIR {
+
+///
+/// \brief Converts the function of a CFG into SSA form and back.
+///
+/// Phi functions are placed on the iterated dominance frontier of the
+/// definitions of each variable that is live across blocks (semi-pruned SSA),
+/// then every definition is given a fresh version by a walk over the
+/// dominator tree. Variables whose address is taken or which are declared
+/// with `DEC` stay in memory and are never renamed. A use that no definition
+/// reaches keeps the original variable.
+///
+/// The SSA form built here is conventional: the versions of a variable never
+/// interfere, so `destruct()` drops the phi functions and maps each version
+/// back to its variable without inserting copies. Versions are appended to
+/// the variable table of the function, and dropped from it again by
+/// `destruct()`. Passes running in between
+/// may fold and delete statements, but must not propagate copies or move
+/// definitions across each other.
+///
+class IRSSA {
+  public:
+    IRSSA(IRCFG &cfg_) : cfg{cfg_} {}
+
+    IRSSA(const IRSSA &other) = delete;
+    IRSSA &operator=(const IRSSA &other) = delete;
+
+    /// \brief Convert to SSA form. Unreachable blocks are removed first.
+    void construct();
+
+    /// \brief Leave SSA form.
+    void destruct();
+
+    bool isVersion(IROperand var) const noexcept
+    {
+        return var.isVariable() && var.getIndex() >= numOrigVars &&
+               var.getIndex() - numOrigVars < origins.size();
+    }
+
+    /// \return the variable `var` is a version of, or `var` itself.
+    IROperand getOrigin(IROperand var) const noexcept
+    {
+        return isVersion(var) ? origins[var.getIndex() - numOrigVars] : var;
+    }
+
+  private:
+    IRCFG &cfg;
+    size_t numOrigVars = 0;
+    IRVec<IROperand> origins; ///< Origin of each version, by index
+};
+
+} // namespace splc::SIR
+
+#endif // __SPLC_SIR_IRSSA_HH__
@@ -0,0 +1,64 @@
+#ifndef __SPLC_SIR_IRSERIALIZER_HH__
+#define __SPLC_SIR_IRSERIALIZER_HH__ 1
+
+#include <ostream>
+
+#include "SIR/IR.hh"
+
+namespace splc::SIR {
+
+///
+/// \brief Reads and writes `IRProgram` in a compact binary format.
+///
+/// All integers are unsigned LEB128 varints, and constants are zigzag-encoded
+/// first. A file is laid out as:
+///
+///     "SIRB" version
+///     numStrings { length bytes }       string table, shared by all functions
+///     numFunctions { size function }    sections of `size` bytes
+///
+/// and each function section as:
+///
+///     name
+///     numNames { string }               names, in `IRNameID` order
+///     numVariables { prefix number }    `number` is 0 for `noNumber`, else
+///     numLabels { prefix number }       the number plus one
+///     numConstants { constant }
+///     numParams { operand }
+///     numStmts { stmt }
+///
+/// where a string is an index into the string table, and an operand is its
+/// table index shifted left by 3 bits, or-ed with its kind. A statement is a
+/// byte holding its `IRType` and the number of operands in bits 5-6, then the
+/// `IRBranchType` byte of a `BranchIf`, then the operands. Trailing empty
+/// operands are omitted.
+///
+/// Statements are written in program order, such that a function read back is
+/// compact. Types are not part of the format and are read back as `nullptr`,
+/// and functions in SSA form cannot be written.
+///
+class IRSerializer {
+  public:
+    static constexpr char magic[4] = {'S', 'I', 'R', 'B'};
+    static constexpr unsigned formatVersion = 1;
+
+    static void writeProgram(std::ostream &os, const IRProgram &program);
+
+    ///
+    /// \brief Rebuild a program from the binary SIR in `data`, without copying
+    /// the input.
+    /// \return `nullptr` if `data` is not well-formed.
+    ///
+    static Ptr<IRProgram> readProgram(StrRef data);
+
+    ///
+    /// \brief Read the binary SIR file `fileName`, memory-mapped where the
+    /// platform supports it.
+    /// \return `nullptr` if the file cannot be read or is not well-formed.
+    ///
+    static Ptr<IRProgram> readFile(StrRef fileName);
+};
+
+} // namespace splc::SIR
+
+#endif // __SPLC_SIR_IRSERIALIZER_HH__
@@ -0,0 +1,78 @@
+#ifndef __SPLC_TRANSLATION_SOURCEBUFFER_HH__
+#define __SPLC_TRANSLATION_SOURCEBUFFER_HH__ 1
+
+#include <istream>
+#include <streambuf>
+#include <string>
+#include <string_view>
+
+#include "Core/splc.hh"
+
+namespace splc {
+
+///
+/// \brief `SourceBuffer` holds the entire content of a source file in memory.
+/// The file is memory-mapped where the platform supports it, and read once
+/// into a single buffer otherwise. Mapped pages are loaded on demand and, being
+/// backed by the file, can be reclaimed by the system once they are read.
+///
+class SourceBuffer {
+  public:
+    SourceBuffer(const SourceBuffer &other) = delete;
+    SourceBuffer &operator=(const SourceBuffer &other) = delete;
+
+    ~SourceBuffer() noexcept;
+
+    ///
+    /// \brief Open `fileName_` as a source buffer.
+    /// \return `nullptr` if the file cannot be opened.
+    ///
+    static Ptr<SourceBuffer> openFile(std::string_view fileName_);
+
+    std::string_view getContent() const noexcept { return {data, size}; }
+
+    const std::string &getName() const noexcept { return name; }
+
+    bool isMapped() const noexcept { return mapped; }
+
+  private:
+    SourceBuffer(std::string_view name_) : name{name_} {}
+
+    std::string name;
+    const char *data = nullptr;
+    size_t size = 0;
+    bool mapped = false;      ///< True if `data` is a memory mapping
+    std::string ownedContent; ///< Storage if the file is not mapped
+};
+
+///
+/// \brief Read-only stream buffer over existing memory. Reads are served
+/// directly from the underlying memory, without any intermediate copy.
+///
+class MemoryStreamBuf : public std::streambuf {
+  public:
+    MemoryStreamBuf(std::string_view view)
+    {
+        char *p = const_cast<char *>(view.data());
+        setg(p, p, p + view.size());
+    }
+};
+
+///
+/// \brief Input stream over existing memory, e.g., a `SourceBuffer`. The
+/// memory must outlive the stream.
+///
+class MemoryInputStream : public std::istream {
+  public:
+    MemoryInputStream(std::string_view view) : std::istream{nullptr}, buf{view}
+    {
+        rdbuf(&buf);
+    }
+
+  private:
+    MemoryStreamBuf buf;
+};
+
+} // namespace splc
+
+#endif // __SPLC_TRANSLATION_SOURCEBUFFER_HH__
@@ -0,0 +1,74 @@
+#ifndef __SPLC_TRANSLATION_SOURCECACHE_HH__
+#define __SPLC_TRANSLATION_SOURCECACHE_HH__ 1
+
+#include <map>
+#include <mutex>
+#include <string>
+#include <string_view>
+
+#include "Core/splc.hh"
+#include "Translation/SourceBuffer.hh"
+
+namespace splc {
+
+///
+/// \brief A source file kept in memory by `SourceCache`, together with the
+/// multiple-inclusion protection detected in it.
+///
+struct SourceCacheEntry {
+    std::string canonicalPath;
+    Ptr<const SourceBuffer> buffer;
+
+    /// Name of the macro X if the file is wrapped entirely in
+    /// `#ifndef X / #define X ... #endif`, empty otherwise.
+    std::string guardMacro;
+
+    /// True if the file starts with `#pragma once`.
+    bool pragmaOnce = false;
+};
+
+///
+/// \brief Process-wide cache of source files keyed by canonical path. Files
+/// are loaded and analyzed for include guards once, no matter how many
+/// translation units include them. Once the cache holds more than
+/// `SPLC_SOURCE_CACHE_SIZE` bytes, files no longer in use are dropped. The
+/// cache is safe to use from multiple threads.
+///
+class SourceCache {
+  public:
+    SourceCache(const SourceCache &other) = delete;
+    SourceCache &operator=(const SourceCache &other) = delete;
+
+    static SourceCache &getInstance();
+
+    ///
+    /// \brief Get the cached entry of `fileName_`, loading it on first use.
+    /// \return `nullptr` if the file cannot be opened.
+    ///
+    Ptr<const SourceCacheEntry> get(std::string_view fileName_);
+
+    ///
+    /// \brief Detect the include guard and `#pragma once` of `content`.
+    ///
+    static void detectMultipleInclusionGuard(std::string_view content,
+                                             SourceCacheEntry &entry);
+
+  private:
+    SourceCache() = default;
+
+    ///
+    /// \brief Drop the entries referenced by nobody but the cache, except
+    /// `keep_`, until the cache fits in `SPLC_SOURCE_CACHE_SIZE`. Must be
+    /// called with `cacheMutex` held.
+    ///
+    void evictUnused(const SourceCacheEntry *keep_);
+
+    std::mutex cacheMutex;
+    std::map<std::string, Ptr<const SourceCacheEntry>, std::less<>> entries;
+    size_t cachedSize = 0; ///< Total size of the cached files
+
+};
+
+} // namespace splc
+
+#endif // __SPLC_TRANSLATION_SOURCECACHE_HH__
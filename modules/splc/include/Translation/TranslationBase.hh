@@ -24,10 +24,6 @@ using TranslationContextNameArgType = std::string_view;
 using TranslationContextIDType = utils::Location::ContextIDType;
 using TranslationContextKeyType = ContextKeyType;
 
-using MacroVarIDType = TranslationContextNameType;
-using MacroVarEntry = std::pair<Location, Ptr<TranslationContext>>;
-using MacroVarConstEntry = std::pair<Location, Ptr<const TranslationContext>>;
-using MacroVarMap = std::map<MacroVarIDType, MacroVarEntry, std::less<>>;
 using MacroContentType = std::string;
 
 } // namespace splc
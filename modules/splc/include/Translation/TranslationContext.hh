@@ -11,6 +11,7 @@
 
 #include "Core/splc.hh"
 
+#include "Translation/SourceBuffer.hh"
 #include "Translation/TranslationBase.hh"
 
 namespace splc {
@@ -48,8 +49,36 @@ class TranslationContext : std::enable_shared_from_this<TranslationContext> {
     {
     }
 
+    ///
+    /// \brief Create a file context that reads from `sourceBuffer_` in place.
+    ///
+    TranslationContext(const TranslationContextIDType contextID_,
+                       TranslationContextBufferType type_,
+                       std::string_view name_,
+                       WeakPtr<const TranslationContext> parent,
+                       const Location *intrLocation_,
+                       Ptr<const SourceBuffer> sourceBuffer_)
+        : contextID{contextID_}, bufferType{type_}, name{name_}, parent{parent},
+          intrLocation(intrLocation_ ? *intrLocation_ : Location{}), content{},
+          inputStream{makeSharedPtr<MemoryInputStream>(
+              sourceBuffer_->getContent())},
+          sourceBuffer{sourceBuffer_}
+    {
+    }
+
     virtual ~TranslationContext() = default;
 
+    ///
+    /// \brief Get the text of this context. For files, the view points
+    /// directly into the (memory-mapped) source buffer.
+    ///
+    std::string_view getBuffer() const noexcept
+    {
+        if (sourceBuffer)
+            return sourceBuffer->getContent();
+        return content;
+    }
+
     TranslationContextKeyType getKey() const
     {
         using utils::logging::TraceType;
@@ -81,6 +110,7 @@ class TranslationContext : std::enable_shared_from_this<TranslationContext> {
     mutable Location intrLocation; ///< Interrupt Location
     const MacroContentType content;
     Ptr<std::istream> inputStream;
+    Ptr<const SourceBuffer> sourceBuffer; ///< Content of file contexts
 
     friend class TranslationContextManager;
 };
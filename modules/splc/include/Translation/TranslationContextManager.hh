@@ -2,8 +2,10 @@
 #define __SPLC_TRANSLATION_TRANSLATIONCONTEXTMANAGER_HH__ 1
 
 #include <fstream>
+#include <functional>
 #include <iostream>
 #include <map>
+#include <set>
 #include <stack>
 #include <string>
 #include <string_view>
@@ -40,19 +42,17 @@ class TranslationContextManager {
 
     ///
     /// \brief Push a new file into context manager. If no such file exist,
-    /// throw `Semantic Error`.
+    /// throw `Semantic Error`. File contents are shared through `SourceCache`.
     /// \param intrLocation interrupt location
+    /// \param isMacroDefined Tells whether the include guard of the file has
+    /// been defined. Include guards are not checked if it is empty.
+    /// \return `nullptr` if the file has already been included and is
+    /// protected by an include guard or `#pragma once`.
     ///
-    Ptr<TranslationContext> pushContext(const Location *intrLocation,
-                                        std::string_view fileName_);
-
-    ///
-    /// \brief Push a macro substitution into context manager, switching to
-    /// macro substitution. If no such macro exist, throw `Semantic Error`.
-    /// \param intrLocation interrupt location
-    ///
-    Ptr<TranslationContext> pushMacroVarContext(const Location *intrLocation,
-                                                std::string_view macroVarName_);
+    Ptr<TranslationContext>
+    pushContext(const Location *intrLocation, std::string_view fileName_,
+                const std::function<bool(std::string_view)> &isMacroDefined =
+                    {});
 
     ///
     /// \brief Pop the topmost context.
@@ -61,33 +61,6 @@ class TranslationContextManager {
     ///
     Ptr<TranslationContext> popContext();
 
-    bool isTransMacroVarPresent(std::string_view macroVarName_) const noexcept;
-
-    ///
-    /// \brief Get macro var context from the context manager. If no such macro
-    ///        exist, throw `Semantic Error`.
-    ///
-    MacroVarConstEntry getMacroVarContext(std::string_view macroVarName_) const;
-
-    ///
-    /// \brief Register a macro variable definition.
-    ///
-    Ptr<TranslationContext>
-    registerMacroVarContext(const Location *regLocation,
-                            std::string_view macroVarName_,
-                            std::string_view content_);
-
-    ///
-    /// \brief Unregister a macro variable definition.
-    ///
-    Ptr<TranslationContext>
-    unregisterMacroVarContext(const Location *unRegLoc,
-                              std::string_view macroVarName_);
-
-    MacroVarMap &getMacroMap() noexcept { return macroVarMap; }
-
-    const MacroVarMap &getMacroMap() const noexcept { return macroVarMap; }
-
     bool isContextExistInStack(TranslationContextBufferType type_,
                                std::string_view contextName_) const noexcept;
 
@@ -147,7 +120,8 @@ class TranslationContextManager {
     std::vector<Ptr<TranslationContext>>
         contextStack; ///< Store contexts for checking repeated inclusions
 
-    MacroVarMap macroVarMap; ///< Store macro variables that might be used.
+    std::set<std::string, std::less<>>
+        onceIncludedFiles; ///< Canonical paths of `#pragma once` files seen
 
   public:
     friend class TranslationUnit;
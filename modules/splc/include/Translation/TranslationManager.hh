@@ -2,6 +2,7 @@
 #define __SPLC_TRANSLATION_TRANSLATIONMANAGER_HH__ 1
 
 #include <cstddef>
+#include <functional>
 #include <string>
 #include <string_view>
 #include <vector>
@@ -119,21 +120,11 @@ class TranslationManager {
     ///                accepts `nullptr` for representing non-existing
     ///                locations. Internally, a copy is maintained, so that the
     ///                original location will not be affected.
+    /// \return `nullptr` if the file is skipped by its include guard.
     ///
-    Ptr<TranslationContext> pushTransFileContext(const Location *intrLoc_,
-                                                 std::string_view fileName_);
-
-    ///
-    /// \brief Push a new translation context into the stack.
-    /// \param intrLoc The location where context switch occurred. Note that
-    /// this location
-    ///                accepts `nullptr` for representing non-existing
-    ///                locations. Internally, a copy is maintained, so that the
-    ///                original location will not be affected.
-    ///
-    Ptr<TranslationContext>
-    pushTransMacroVarContext(const Location *intrLoc_,
-                             std::string_view macroVarName_);
+    Ptr<TranslationContext> pushTransFileContext(
+        const Location *intrLoc_, std::string_view fileName_,
+        const std::function<bool(std::string_view)> &isMacroDefined = {});
 
     Ptr<TranslationContext> popTransContext() noexcept
     {
@@ -145,26 +136,6 @@ class TranslationManager {
     bool isContextExistInStack(TranslationContextBufferType type_,
                                std::string_view contextName_) const noexcept;
 
-    bool isTransMacroVarPresent(std::string_view macroVarName_) const noexcept
-    {
-        return tunit->transCtxMgr.isTransMacroVarPresent(macroVarName_);
-    }
-
-    /// \brief Get macro var context from the context manager.
-    MacroVarConstEntry
-    getTransMacroVarContext(std::string_view macroVarName_) const;
-
-    /// \brief Register a macro variable definition.
-    Ptr<TranslationContext>
-    registerTransMacroVarContext(const Location *regLocation,
-                                 std::string_view macroVarName_,
-                                 std::string_view content_);
-
-    /// \brief Unregister a macro variable definition.
-    Ptr<TranslationContext>
-    unregisterTransMacroVarContext(const Location *unRegLoc,
-                                   std::string_view macroVarName_);
-
     void setRootNode(PtrAST root) { tunit->setRootNode(root); }
 
     PtrAST getRootNode() { return tunit->getRootNode(); }
@@ -1,6 +1,7 @@
 #ifndef __SPLC_TRANSLATION_TRANSLATIONUNIT_HH__
 #define __SPLC_TRANSLATION_TRANSLATIONUNIT_HH__ 1
 
+#include "AST/ASTArena.hh"
 #include "AST/ASTCommons.hh"
 #include "AST/ASTContextManager.hh"
 #include "Basic/SPLCContext.hh"
@@ -26,8 +27,8 @@ concept AllApplicableOnTranslationUnit =
 class TranslationUnit {
   public:
     TranslationUnit(SPLCContext &C)
-        : context{C}, astCtxMgr{}, transCtxMgr{}, rootNode{}, warningCount{0},
-          errorCount{0}
+        : context{C}, astArena{}, astCtxMgr{}, transCtxMgr{}, rootNode{},
+          warningCount{0}, errorCount{0}
     {
     }
 
@@ -37,6 +38,10 @@ class TranslationUnit {
 
     const auto &getContext() const { return context; }
 
+    auto &getASTArena() { return astArena; }
+
+    const auto &getASTArena() const { return astArena; }
+
     auto &getASTContextManager() { return astCtxMgr; }
 
     const auto &getASTContextManager() const { return astCtxMgr; }
@@ -54,6 +59,10 @@ class TranslationUnit {
   protected:
     SPLCContext &context; ///< Maintains all internal type contexts.
 
+    ASTArena astArena; ///< Storage of all AST nodes of this unit. Declared
+                       ///< before any member holding nodes, so that it is
+                       ///< destroyed last.
+
     ASTContextManager astCtxMgr; ///< Manages AST contexts, i.e., scopes
                                  ///< and variable definitions.
 
@@ -0,0 +1,29 @@
+#include "AST/ASTArena.hh"
+#include "Core/Utils/Logging.hh"
+#include <algorithm>
+#include <new>
+
+namespace splc {
+
+thread_local ASTArena *ASTArena::activeArena = nullptr;
+
+ASTArena::~ASTArena() noexcept
+{
+    // A node still alive here would point into freed memory.
+    splc_assert(numLiveAllocations == 0)
+        << numLiveAllocations << " AST nodes outlive their arena";
+    for (char *chunk : chunks) {
+        ::operator delete(chunk);
+    }
+    chunks.clear();
+}
+
+void ASTArena::newChunk(size_t minSize)
+{
+    size_t sz = std::max(chunkSize, minSize);
+    chunks.push_back(static_cast<char *>(::operator new(sz)));
+    curChunkSize = sz;
+    cur = 0;
+}
+
+} // namespace splc
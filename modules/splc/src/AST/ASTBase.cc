@@ -35,7 +35,7 @@ bool AST::isGeneralExpr() const noexcept
 PtrAST AST::copy(const std::function<bool(Ptr<const AST>)> &predicate,
                  const bool copyContext) const
 {
-    PtrAST ret = makeSharedPtr<AST>();
+    PtrAST ret = makeASTNode<AST>();
     ret->context = this->context;
     ret->symType = this->symType;
     ret->parent = this->parent;
@@ -5,27 +5,24 @@ namespace splc {
 bool ASTContext::isSymDeclared(SymEntryType symEntTy_,
                                std::string_view name_) const noexcept
 {
-    auto it = symbolMap.find(name_);
-    return (it != symbolMap.end() && it->second.symEntTy == symEntTy_);
+    auto ent = findSymbol(symbolPool->find(name_));
+    return ent != nullptr && ent->symEntTy == symEntTy_;
 }
 
 bool ASTContext::isSymDefined(SymEntryType symEntTy_,
                               std::string_view name_) const noexcept
 {
-    auto it = symbolMap.find(name_);
-    if (it == symbolMap.end())
-        return false;
-    else
-        return it->second.defined && it->second.symEntTy == symEntTy_;
+    auto ent = findSymbol(symbolPool->find(name_));
+    return ent != nullptr && ent->defined && ent->symEntTy == symEntTy_;
 }
 
 SymbolEntry ASTContext::getSymbol(SymEntryType symEntTy_,
                                   std::string_view name_)
 {
-    auto it = symbolMap.find(name_);
-    if (it == symbolMap.end() || it->second.symEntTy != symEntTy_)
+    auto ent = findSymbol(symbolPool->find(name_));
+    if (ent == nullptr || ent->symEntTy != symEntTy_)
         throw SemanticError(nullptr, "trying to get a non-existing symbol");
-    return it->second;
+    return *ent;
 }
 
 SymbolEntry ASTContext::registerSymbol(SymEntryType symEntTy_,
@@ -33,32 +30,41 @@ SymbolEntry ASTContext::registerSymbol(SymEntryType symEntTy_,
                                        bool defined_, const Location *location_,
                                        PtrAST body_)
 {
-    auto it = symbolMap.find(name_);
-    if (it != symbolMap.end()) {
-        if (it->second.symEntTy != symEntTy_ || it->second.defined) {
-            throw SemanticError{&it->second.location,
+    SymbolID id = symbolPool->intern(name_);
+    auto symEntry = SymbolEntry::createSymbolEntry(symEntTy_, type_, defined_,
+                                                   location_, body_);
+
+    uint32_t idx = symbolTable.find(id);
+    if (idx != SymbolTable::npos) {
+        auto &prevEntry = symbolList[idx].second;
+        if (prevEntry.symEntTy != symEntTy_ || prevEntry.defined) {
+            throw SemanticError{&prevEntry.location,
                                 "redefining same identifier in the same scope"};
         }
-        symbolMap.erase(it);
-        std::erase_if(symbolList,
-                      [&](const auto &sym) { return sym.first == name_; });
+        // Redeclaration: replace the entry in place.
+        prevEntry = symEntry;
+        return symEntry;
     }
 
-    auto symEntry = SymbolEntry::createSymbolEntry(symEntTy_, type_, defined_,
-                                                   location_, body_);
-    auto p = std::make_pair(ASTIDType{name_}, symEntry);
-    symbolMap.insert(p);
-    symbolList.push_back(p);
+    symbolTable.insert(id, static_cast<uint32_t>(symbolList.size()));
+    symbolList.emplace_back(symbolPool->getName(id), symEntry);
+    symbolIDList.push_back(id);
     return symEntry;
 }
 
 void ASTContext::unregisterSymbol(SymEntryType entTy, std::string_view name_)
 {
-    auto it = symbolMap.find(name_);
-    if (it != symbolMap.end()) {
-        symbolMap.erase(it);
-        std::erase_if(symbolList,
-                      [&](const auto &sym) { return sym.first == name_; });
+    SymbolID id = symbolPool->find(name_);
+    uint32_t idx = symbolTable.find(id);
+    if (idx == SymbolTable::npos)
+        return;
+
+    symbolTable.erase(id);
+    symbolList.erase(symbolList.begin() + idx);
+    symbolIDList.erase(symbolIDList.begin() + idx);
+    // Keep the declaration order, rebinding the entries that were moved.
+    for (uint32_t i = idx; i < symbolIDList.size(); ++i) {
+        symbolTable.insert(symbolIDList[i], i);
     }
 }
 
@@ -77,7 +83,7 @@ std::ostream &operator<<(std::ostream &os, const ASTContext &ctx) noexcept
     printLeadingSpace(os, ctx.depth)
         << CS::BrightMagenta << "ASTContextTable [" << ctx.depth << "]"
         << CS::Reset << " at " << CS::Yellow << &ctx << CS::Reset << ", size "
-        << CS::Blue << ctx.getSymbolMap().size() << CS::Reset << "\n";
+        << CS::Blue << ctx.getSize() << CS::Reset << "\n";
 
     for (auto &ent : ctx.getSymbolList()) {
         printLeadingSpace(os, ctx.depth + 1)
@@ -97,7 +103,7 @@ std::ostream &printASTCtxSummary(std::ostream &os,
 
     os << CS::BrightMagenta << "ASTCtx [" << ctx.depth << "]" << CS::Reset
        << " at " << CS::Yellow << &ctx << CS::Reset << ", size " << CS::Blue
-       << ctx.getSymbolMap().size() << CS::Reset;
+       << ctx.getSize() << CS::Reset;
     return os;
 }
 
@@ -1,25 +1,47 @@
 #include "AST/ASTContextManager.hh"
 #include "AST/ASTCommons.hh"
 #include "Core/Utils/LocationWrapper.hh"
+#include <ranges>
 
 namespace splc {
 
+const SymbolEntry *
+ASTContextManager::lookupSymbol(std::string_view name_) const noexcept
+{
+    // A name that has never been interned cannot be declared anywhere. This
+    // is the common case for identifiers checked by the lexer.
+    SymbolID id = symbolPool->find(name_);
+    if (id == invalidSymbolID)
+        return nullptr;
+
+    for (auto &ctx : std::views::reverse(contextStack)) {
+        if (auto ent = ctx->findSymbol(id))
+            return ent;
+    }
+    return nullptr;
+}
+
 bool ASTContextManager::isSymDeclared(SymEntryType symEntTy_,
                                       std::string_view name_) const noexcept
 {
-    return contextStack.back()->isSymDeclared(symEntTy_, name_);
+    auto ent = lookupSymbol(name_);
+    return ent != nullptr && ent->symEntTy == symEntTy_;
 }
 
 bool ASTContextManager::isSymDefined(SymEntryType symEntTy_,
                                      std::string_view name_) const noexcept
 {
-    return contextStack.back()->isSymDefined(symEntTy_, name_);
+    auto ent = lookupSymbol(name_);
+    return ent != nullptr && ent->defined && ent->symEntTy == symEntTy_;
 }
 
 SymbolEntry ASTContextManager::getSymbol(SymEntryType symEntTy_,
                                          std::string_view name_)
 {
-    return contextStack.back()->getSymbol(symEntTy_, name_);
+    auto ent = lookupSymbol(name_);
+    if (ent == nullptr || ent->symEntTy != symEntTy_)
+        throw SemanticError(nullptr, "trying to get a non-existing symbol");
+    return *ent;
 }
 
 SymbolEntry ASTContextManager::registerSymbol(SymEntryType summary_,
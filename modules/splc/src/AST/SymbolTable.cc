@@ -0,0 +1,119 @@
+#include "AST/SymbolTable.hh"
+
+#include <functional>
+
+namespace splc {
+
+//===----------------------------------------------------------------------===//
+//                        SymbolStringPool Implementation
+//===----------------------------------------------------------------------===//
+
+SymbolID SymbolStringPool::intern(std::string_view name)
+{
+    if ((names.size() + 1) * 2 > slots.size())
+        grow();
+
+    size_t hash = std::hash<std::string_view>{}(name);
+    size_t i = findSlot(name, hash);
+    if (slots[i].id != invalidSymbolID)
+        return slots[i].id;
+
+    SymbolID id = static_cast<SymbolID>(names.size());
+    names.emplace_back(name);
+    slots[i] = {hash, id};
+    return id;
+}
+
+SymbolID SymbolStringPool::find(std::string_view name) const noexcept
+{
+    if (slots.empty())
+        return invalidSymbolID;
+    return slots[findSlot(name, std::hash<std::string_view>{}(name))].id;
+}
+
+size_t SymbolStringPool::findSlot(std::string_view name,
+                                  size_t hash) const noexcept
+{
+    size_t mask = slots.size() - 1;
+    for (size_t i = hash & mask;; i = (i + 1) & mask) {
+        const Slot &slot = slots[i];
+        if (slot.id == invalidSymbolID ||
+            (slot.hash == hash && names[slot.id] == name))
+            return i;
+    }
+}
+
+void SymbolStringPool::grow()
+{
+    std::vector<Slot> oldSlots = std::move(slots);
+    slots.assign(oldSlots.empty() ? 64 : oldSlots.size() * 2, Slot{});
+
+    size_t mask = slots.size() - 1;
+    for (const Slot &slot : oldSlots) {
+        if (slot.id == invalidSymbolID)
+            continue;
+        size_t i = slot.hash & mask;
+        while (slots[i].id != invalidSymbolID)
+            i = (i + 1) & mask;
+        slots[i] = slot;
+    }
+}
+
+//===----------------------------------------------------------------------===//
+//                          SymbolTable Implementation
+//===----------------------------------------------------------------------===//
+
+void SymbolTable::insert(SymbolID id, uint32_t index)
+{
+    if ((numEntries + 1) * 2 > slots.size())
+        grow();
+
+    size_t i = hashID(id) & mask();
+    while (slots[i].id != invalidSymbolID && slots[i].id != id)
+        i = (i + 1) & mask();
+
+    if (slots[i].id == invalidSymbolID)
+        ++numEntries;
+    slots[i] = {id, index};
+}
+
+void SymbolTable::erase(SymbolID id) noexcept
+{
+    if (slots.empty())
+        return;
+
+    size_t i = hashID(id) & mask();
+    while (slots[i].id != id) {
+        if (slots[i].id == invalidSymbolID)
+            return;
+        i = (i + 1) & mask();
+    }
+
+    // Backward-shift deletion: move later entries of the same probe sequence
+    // into the hole, so that no tombstones are needed.
+    size_t hole = i;
+    for (size_t j = (i + 1) & mask(); slots[j].id != invalidSymbolID;
+         j = (j + 1) & mask()) {
+        size_t home = hashID(slots[j].id) & mask();
+        if (((j - home) & mask()) >= ((j - hole) & mask())) {
+            slots[hole] = slots[j];
+            hole = j;
+        }
+    }
+    slots[hole] = Slot{};
+    --numEntries;
+}
+
+void SymbolTable::grow()
+{
+    std::vector<Slot> oldSlots = std::move(slots);
+    slots.assign(oldSlots.empty() ? 8 : oldSlots.size() * 2, Slot{});
+    numEntries = 0;
+
+    for (const Slot &slot : oldSlots) {
+        if (slot.id != invalidSymbolID)
+            insert(slot.id, slot.index);
+    }
+}
+
+} // namespace splc
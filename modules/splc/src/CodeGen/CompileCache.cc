@@ -0,0 +1,143 @@
+#include "CodeGen/CompileCache.hh"
+#include "Core/Utils/Logging.hh"
+
+#include <cstdlib>
+#include <functional>
+#include <system_error>
+#include <thread>
+#include <unistd.h>
+
+namespace splc {
+
+namespace fs = std::filesystem;
+
+//===----------------------------------------------------------------------===//
+//                           KeyBuilder Implementation
+//===----------------------------------------------------------------------===//
+
+void CompileCache::KeyBuilder::HashingStreamBuf::flushToHasher()
+{
+    auto n = static_cast<size_t>(pptr() - pbase());
+    if (n != 0)
+        hasher.update(llvm::StringRef{pbase(), n});
+    setp(buf.data(), buf.data() + buf.size());
+}
+
+CompileCache::KeyBuilder::HashingStreamBuf::int_type
+CompileCache::KeyBuilder::HashingStreamBuf::overflow(int_type ch)
+{
+    flushToHasher();
+    if (!traits_type::eq_int_type(ch, traits_type::eof())) {
+        *pptr() = traits_type::to_char_type(ch);
+        pbump(1);
+    }
+    return traits_type::not_eof(ch);
+}
+
+int CompileCache::KeyBuilder::HashingStreamBuf::sync()
+{
+    flushToHasher();
+    return 0;
+}
+
+void CompileCache::KeyBuilder::addField(std::string_view name,
+                                        std::string_view value)
+{
+    // Length-prefix every field, so that no two different sets of fields
+    // produce the same byte sequence.
+    os << '\0' << name.size() << ':' << name << value.size() << ':' << value;
+}
+
+std::string CompileCache::KeyBuilder::finalize()
+{
+    os.flush();
+    hashBuf.flushToHasher();
+    std::array<uint8_t, 32> digest = hasher.final();
+    return llvm::toHex(digest, /*LowerCase=*/true);
+}
+
+//===----------------------------------------------------------------------===//
+//                          CompileCache Implementation
+//===----------------------------------------------------------------------===//
+
+fs::path CompileCache::getDefaultDirectory()
+{
+    if (const char *dir = std::getenv("SPLC_CACHE_DIR"); dir && *dir)
+        return fs::path{dir};
+    if (const char *dir = std::getenv("XDG_CACHE_HOME"); dir && *dir)
+        return fs::path{dir} / "splc";
+    if (const char *dir = std::getenv("HOME"); dir && *dir)
+        return fs::path{dir} / ".cache" / "splc";
+    return fs::temp_directory_path() / "splc-cache";
+}
+
+fs::path CompileCache::getEntryDirectory(std::string_view key) const
+{
+    return cacheDir / key.substr(0, 2) / key.substr(2);
+}
+
+bool CompileCache::retrieve(
+    std::string_view key, const std::vector<CompileCacheOutput> &outputs) const
+{
+    fs::path entryDir = getEntryDirectory(key);
+    std::error_code ec;
+    for (auto &output : outputs) {
+        if (!fs::is_regular_file(entryDir / output.name, ec))
+            return false;
+    }
+
+    for (auto &output : outputs) {
+        fs::copy_file(entryDir / output.name, output.path,
+                      fs::copy_options::overwrite_existing, ec);
+        if (ec) {
+            SPLC_LOG_WARN(nullptr, false)
+                << "cannot restore " << output.path.string()
+                << " from compile cache: " << ec.message();
+            return false;
+        }
+    }
+    return true;
+}
+
+void CompileCache::store(std::string_view key,
+                         const std::vector<CompileCacheOutput> &outputs) const
+{
+    std::error_code ec;
+    for (auto &output : outputs) {
+        if (!fs::is_regular_file(output.path, ec))
+            return;
+    }
+
+    fs::path entryDir = getEntryDirectory(key);
+    fs::create_directories(entryDir, ec);
+    if (ec) {
+        SPLC_LOG_WARN(nullptr, false)
+            << "cannot create compile cache entry " << entryDir.string()
+            << ": " << ec.message();
+        return;
+    }
+
+    // Copy to a name unique to this thread, then rename, which atomically
+    // replaces any entry written concurrently with the same content.
+    std::string suffix =
+        ".tmp" + std::to_string(::getpid()) + "." +
+        std::to_string(std::hash<std::thread::id>{}(std::this_thread::get_id()));
+    for (auto &output : outputs) {
+        fs::path target = entryDir / output.name;
+        fs::path tmp = target;
+        tmp += suffix;
+        fs::copy_file(output.path, tmp, fs::copy_options::overwrite_existing,
+                      ec);
+        if (!ec)
+            fs::rename(tmp, target, ec);
+        if (ec) {
+            SPLC_LOG_WARN(nullptr, false)
+                << "cannot store " << output.path.string()
+                << " in compile cache: " << ec.message();
+            fs::remove(tmp, ec);
+            return;
+        }
+    }
+}
+
+} // namespace splc
@@ -1,8 +1,82 @@
 #include "CodeGen/ObjBuilder.hh"
+#include "CodeGen/TargetService.hh"
+#include <cstdio>
 #include <ranges>
+#include <thread>
 
 namespace splc {
 
+namespace {
+
+/// Modules with fewer defined functions per thread are optimized serially.
+constexpr size_t minFunctionsPerPartition = 16;
+
+/// CPU and features of the target machines requested by `ObjBuilder`.
+constexpr std::string_view targetCPU = "generic";
+constexpr std::string_view targetFeatures = "";
+
+/// Run the pipeline returned by `buildPipeline(PB)` over `M`, with the cost
+/// models of `TM`.
+template <class Fn>
+void runPipeline(llvm::Module &M, llvm::TargetMachine *TM, Fn &&buildPipeline)
+{
+    llvm::LoopAnalysisManager LAM;
+    llvm::FunctionAnalysisManager FAM;
+    llvm::CGSCCAnalysisManager CGAM;
+    llvm::ModuleAnalysisManager MAM;
+
+    llvm::PassBuilder PB{TM};
+    PB.registerModuleAnalyses(MAM);
+    PB.registerCGSCCAnalyses(CGAM);
+    PB.registerFunctionAnalyses(FAM);
+    PB.registerLoopAnalyses(LAM);
+    PB.crossRegisterProxies(LAM, FAM, CGAM, MAM);
+
+    llvm::ModulePassManager MPM = buildPipeline(PB);
+    MPM.run(M, MAM);
+}
+
+/// Build the default pipeline of `level` and run it over `M`.
+void runDefaultPipeline(llvm::Module &M, llvm::TargetMachine *TM,
+                        llvm::OptimizationLevel level)
+{
+    runPipeline(M, TM, [&](llvm::PassBuilder &PB) {
+        return level == llvm::OptimizationLevel::O0
+                   ? PB.buildO0DefaultPipeline(level)
+                   : PB.buildPerModuleDefaultPipeline(level);
+    });
+}
+
+void writeBitcode(const llvm::Module &M, llvm::SmallVectorImpl<char> &buf)
+{
+    buf.clear();
+    llvm::raw_svector_ostream os{buf};
+    llvm::WriteBitcodeToFile(M, os);
+}
+
+llvm::Expected<std::unique_ptr<llvm::Module>>
+readBitcode(const llvm::SmallVectorImpl<char> &buf, llvm::LLVMContext &C)
+{
+    return llvm::parseBitcodeFile(
+        llvm::MemoryBufferRef{llvm::StringRef{buf.data(), buf.size()},
+                              "splc partition"},
+        C);
+}
+
+/// `int read()` of SPL programs run in the JIT.
+int32_t hostRead()
+{
+    int32_t value = 0;
+    if (std::scanf("%d", &value) != 1)
+        return 0;
+    return value;
+}
+
+/// `void write(int)` of SPL programs run in the JIT.
+void hostWrite(int32_t value) { std::printf("%d\n", value); }
+
+} // namespace
+
 //===----------------------------------------------------------------------===//
 //                          LLVMIRBuilder Implementation
 //===----------------------------------------------------------------------===//
@@ -32,6 +106,9 @@ llvm::Type *ObjBuilder::getPrimitiveType(splc::Type *ty)
         return cachedTy = llvm::Type::getDoubleTy(getLLVMCtx());
     case TypeID::Int1:
         return cachedTy = llvm::Type::getInt1Ty(getLLVMCtx());
+    case TypeID::UInt8:
+    case TypeID::SInt8:
+        return cachedTy = llvm::Type::getInt8Ty(getLLVMCtx());
     case TypeID::UInt16:
     case TypeID::SInt16:
         return cachedTy = llvm::Type::getInt16Ty(getLLVMCtx());
@@ -143,6 +220,71 @@ llvm::Type *ObjBuilder::getCvtType(splc::Type *ty)
     }
 }
 
+llvm::MDNode *ObjBuilder::getTBAATypeNode(splc::Type *ty)
+{
+    while (ty->isArrayTy())
+        ty = ty->getArrayElementType();
+
+    auto &node = tbaaTypeNodes[ty];
+    if (node != nullptr)
+        return node;
+
+    llvm::MDBuilder mdb{getLLVMCtx()};
+    if (tbaaRoot == nullptr)
+        tbaaRoot = mdb.createTBAARoot("splc TBAA");
+    llvm::MDNode *charNode =
+        mdb.createTBAAScalarTypeNode("omnipotent char", tbaaRoot);
+
+    switch (ty->getTypeID()) {
+    case Type::TypeID::Pointer:
+        return node = mdb.createTBAAScalarTypeNode("any pointer", charNode);
+    case Type::TypeID::Float:
+        return node = mdb.createTBAAScalarTypeNode("float", charNode);
+    case Type::TypeID::Double:
+        return node = mdb.createTBAAScalarTypeNode("double", charNode);
+    case Type::TypeID::UInt16:
+    case Type::TypeID::SInt16:
+        return node = mdb.createTBAAScalarTypeNode("short", charNode);
+    case Type::TypeID::UInt32:
+    case Type::TypeID::SInt32:
+        return node = mdb.createTBAAScalarTypeNode("int", charNode);
+    case Type::TypeID::UInt64:
+    case Type::TypeID::SInt64:
+        return node = mdb.createTBAAScalarTypeNode("long long", charNode);
+    case Type::TypeID::Struct: {
+        auto *langStructTy = dynamic_cast<splc::StructType *>(ty);
+        const llvm::StructLayout *layout =
+            theModule->getDataLayout().getStructLayout(
+                getStructType(langStructTy));
+
+        std::vector<std::pair<llvm::MDNode *, uint64_t>> fields;
+        for (unsigned i = 0; i < ty->getStructNumElements(); ++i) {
+            fields.emplace_back(getTBAATypeNode(ty->getStructElementType(i)),
+                                layout->getElementOffset(i));
+        }
+        std::string name{"struct"};
+        if (langStructTy->hasName())
+            name.append(" ").append(langStructTy->getName());
+        return node = mdb.createTBAAStructTypeNode(name, fields);
+    }
+    default:
+        return node = charNode;
+    }
+}
+
+llvm::MDNode *ObjBuilder::getTBAATag(const ObjLValue &lv)
+{
+    if (lv.langTy->isAggregateType() || lv.langTy->isFunctionTy())
+        return nullptr;
+
+    llvm::MDBuilder mdb{getLLVMCtx()};
+    llvm::MDNode *accessNode = getTBAATypeNode(lv.langTy);
+    if (lv.baseTy == nullptr)
+        return mdb.createTBAAStructTagNode(accessNode, accessNode, 0);
+    return mdb.createTBAAStructTagNode(getTBAATypeNode(lv.baseTy), accessNode,
+                                       lv.offset);
+}
+
 //===----------------------------------------------------------------------===//
 //                               Code Generation
 //===----------------------------------------------------------------------===//
@@ -169,7 +311,8 @@ llvm::Function *ObjBuilder::getFunction(std::string_view name)
     return nullptr;
 }
 
-void ObjBuilder::registerGlobalCtxMutableVar(std::string_view name,
+void ObjBuilder::registerGlobalCtxMutableVar(SymbolID id,
+                                             std::string_view name,
                                              const SymbolEntry &ent)
 {
     splc_ilog_error(&ent.location, false)
@@ -181,10 +324,10 @@ void ObjBuilder::registerGlobalCtxMutableVar(std::string_view name,
 
     llvm::AllocaInst *alloca =
         createEntryBlockAlloc(theFunction, ty, nullptr, name);
-    insertNamedValue(name, ty, alloca);
+    insertNamedValue(id, ty, alloca, ent.type);
 }
 
-void ObjBuilder::registerCtxMutableVar(std::string_view name,
+void ObjBuilder::registerCtxMutableVar(SymbolID id, std::string_view name,
                                        const SymbolEntry &ent)
 {
     llvm::Type *ty = getCvtType(ent.type);
@@ -192,7 +335,7 @@ void ObjBuilder::registerCtxMutableVar(std::string_view name,
 
     llvm::AllocaInst *alloca =
         createEntryBlockAlloc(theFunction, ty, nullptr, name);
-    insertNamedValue(name, ty, alloca);
+    insertNamedValue(id, ty, alloca, ent.type);
 }
 
 // void ObjBuilder::registerCtxFuncParam(std::string_view name,
@@ -270,11 +413,28 @@ void ObjBuilder::registerCtxFuncDef(std::string_view name,
     registerFuncProto(name, FT, ent.body);
 }
 
+void ObjBuilder::declareRuntimeFunctions()
+{
+    llvm::Type *intTy = builder->getInt32Ty();
+    if (!theModule->getFunction("read")) {
+        llvm::Function::Create(llvm::FunctionType::get(intTy, false),
+                               llvm::Function::ExternalLinkage, "read",
+                               theModule.get());
+    }
+    if (!theModule->getFunction("write")) {
+        llvm::Function::Create(
+            llvm::FunctionType::get(builder->getVoidTy(), {intTy}, false),
+            llvm::Function::ExternalLinkage, "write", theModule.get());
+    }
+}
+
 void ObjBuilder::registerCtx(Ptr<ASTContext> ctx)
 {
-    for (const auto &symListEnt : ctx->getSymbolList()) {
-        const auto &symName = symListEnt.first;
-        const auto &sym = symListEnt.second;
+    auto &symList = ctx->getSymbolList();
+    auto &symIDList = ctx->getSymbolIDList();
+    for (size_t i = 0; i < symList.size(); ++i) {
+        const auto &symName = symList[i].first;
+        const auto &sym = symList[i].second;
 
         switch (sym.symEntTy) {
         case SymEntryType::Unspecified:
@@ -292,7 +452,8 @@ void ObjBuilder::registerCtx(Ptr<ASTContext> ctx)
             break;
         }
         case SymEntryType::StructDecl: {
-            // TODO(future)
+            if (sym.body != nullptr && sym.body->getASTContext() != nullptr)
+                structMembers[sym.type] = sym.body->getASTContext();
             break;
         }
         case SymEntryType::UnionDecl: {
@@ -309,9 +470,9 @@ void ObjBuilder::registerCtx(Ptr<ASTContext> ctx)
         }
         case SymEntryType::Variable: {
             if (isVarCtxGlobalScope())
-                registerGlobalCtxMutableVar(symName, sym);
+                registerGlobalCtxMutableVar(symIDList[i], symName, sym);
             else
-                registerCtxMutableVar(symName, sym);
+                registerCtxMutableVar(symIDList[i], symName, sym);
             break;
         }
         case SymEntryType::Paramater:
@@ -324,7 +485,7 @@ void ObjBuilder::registerCtx(Ptr<ASTContext> ctx)
 //===----------------------------------------------------------------------===//
 // Expressions
 
-llvm::Value *ObjBuilder::CGConstant(Ptr<AST> constantRoot)
+llvm::Value *ObjBuilder::CGConstant(const Ptr<AST> &constantRoot)
 {
     splc_dbgassert(constantRoot->isConstant());
 
@@ -362,12 +523,12 @@ llvm::Value *ObjBuilder::CGConstant(Ptr<AST> constantRoot)
     }
 }
 
-// llvm::Value *ObjBuilder::CGConstExpr(Ptr<AST> constExprRoot)
+// llvm::Value *ObjBuilder::CGConstExpr(const Ptr<AST> &constExprRoot)
 // {
 //     // TODO!
 // }
 
-llvm::Value *ObjBuilder::CGPrimaryExpr(Ptr<AST> primaryExprRoot)
+llvm::Value *ObjBuilder::CGPrimaryExpr(const Ptr<AST> &primaryExprRoot)
 {
     splc_dbgassert(primaryExprRoot->isGeneralExpr());
     auto &child = primaryExprRoot->getChildren()[0];
@@ -399,113 +560,50 @@ llvm::Value *ObjBuilder::CGPrimaryExpr(Ptr<AST> primaryExprRoot)
     }
 }
 
-llvm::Value *ObjBuilder::CGPostfixExpr(Ptr<AST> postfixExprRoot)
+llvm::Value *ObjBuilder::CGPostfixExpr(const Ptr<AST> &postfixExprRoot)
 {
-    // splc_ilog_error(&postfixExprRoot->getLocation(), false)
-    //     << "not supported in ObjBuilder";
-    // return nullptr;
-    // TODO(near_future) check for offset, allowing other postfix expressions
-
     splc_dbgassert(postfixExprRoot->getChildrenNum() == 2);
     auto &children = postfixExprRoot->getChildren();
     auto &opExpr = children[0];
     auto &op = children[1];
-    llvm::Value *retVal = CGGeneralExprDispatch(opExpr);
-
-    auto &IDNode = opExpr->getChildren()[0];
-    splc_dbgassert(IDNode->isID());
-    auto [ty, memloc] = findNamedValue(IDNode->getRootID());
-    splc_dbgassert(memloc != nullptr);
-    llvm::Value *newVal = nullptr;
-
-    switch (op->getSymType()) {
-    case ASTSymType::OpDPlus: {
-        if (retVal->getType()->isIntegerTy()) {
-            newVal = builder->CreateAdd(
-                retVal,
-                llvm::ConstantInt::get(
-                    getLLVMCtx(),
-                    llvm::APInt(retVal->getType()->getPrimitiveSizeInBits(),
-                                1)));
-        }
-        else if (retVal->getType()->isFloatingPointTy()) {
-            newVal = builder->CreateFAdd(
-                retVal,
-                llvm::ConstantFP::get(getLLVMCtx(), llvm::APFloat(1.0)));
-        }
-        break;
-    }
-
-    case ASTSymType::OpDMinus: {
-        if (retVal->getType()->isIntegerTy()) {
-            newVal = builder->CreateSub(
-                retVal,
-                llvm::ConstantInt::get(
-                    getLLVMCtx(),
-                    llvm::APInt(retVal->getType()->getPrimitiveSizeInBits(),
-                                1)));
-        }
-        else if (retVal->getType()->isFloatingPointTy()) {
-            newVal = builder->CreateFSub(
-                retVal,
-                llvm::ConstantFP::get(getLLVMCtx(), llvm::APFloat(1.0)));
-        }
-        break;
-    }
 
-    default: {
-        splc_ilog_error(&op->getLocation(), false)
-            << "unsupported op type: " << op->getSymType();
+    ObjLValue lv = CGLValue(opExpr);
+    if (lv.addr == nullptr)
         return nullptr;
-    }
 
-    } // switch (op->getSymType())
+    llvm::Value *retVal = CGLoadLValue(lv);
+    llvm::Value *newVal =
+        CGIncOrDec(lv, retVal, op->getSymType() == ASTSymType::OpDPlus);
+    if (newVal == nullptr)
+        return nullptr;
 
-    splc_dbgassert(newVal != nullptr);
-    builder->CreateStore(newVal, memloc);
+    CGStoreLValue(newVal, lv);
     return retVal;
 }
 
-llvm::Value *ObjBuilder::CGUnaryExpr(Ptr<AST> unaryExprRoot)
+llvm::Value *ObjBuilder::CGUnaryExpr(const Ptr<AST> &unaryExprRoot)
 {
     splc_dbgassert(unaryExprRoot->getChildrenNum() == 2);
     auto &children = unaryExprRoot->getChildren();
     auto &op = children[0];
     auto &opExpr = children[1];
-    llvm::Value *exprRes = CGGeneralExprDispatch(opExpr);
-
-    // TODO(future): support sizeof
     splc_dbgassert(opExpr->isGeneralExpr());
 
-    switch (op->getSymType()) {
+    if (op->isSymTypeOneOf(ASTSymType::OpDPlus, ASTSymType::OpDMinus)) {
+        ObjLValue lv = CGLValue(opExpr);
+        if (lv.addr == nullptr)
+            return nullptr;
 
-    case ASTSymType::OpDPlus: {
-        if (exprRes->getType()->isIntegerTy()) {
-            return builder->CreateAdd(
-                exprRes, llvm::ConstantInt::get(
-                             getLLVMCtx(), llvm::APInt(ASTSIntTypeNumBits, 1)));
-        }
-        else if (exprRes->getType()->isFloatingPointTy()) {
-            return builder->CreateFAdd(
-                exprRes,
-                llvm::ConstantFP::get(getLLVMCtx(), llvm::APFloat(1.0)));
-        }
-        break;
+        llvm::Value *newVal = CGIncOrDec(
+            lv, CGLoadLValue(lv), op->getSymType() == ASTSymType::OpDPlus);
+        if (newVal != nullptr)
+            CGStoreLValue(newVal, lv);
+        return newVal;
     }
 
-    case ASTSymType::OpDMinus: {
-        if (exprRes->getType()->isIntegerTy()) {
-            return builder->CreateSub(
-                exprRes, llvm::ConstantInt::get(
-                             getLLVMCtx(), llvm::APInt(ASTSIntTypeNumBits, 1)));
-        }
-        else if (exprRes->getType()->isFloatingPointTy()) {
-            return builder->CreateFSub(
-                exprRes,
-                llvm::ConstantFP::get(getLLVMCtx(), llvm::APFloat(1.0)));
-        }
-        break;
-    }
+    llvm::Value *exprRes = CGGeneralExprDispatch(opExpr);
+
+    switch (op->getSymType()) {
 
     case ASTSymType::OpPlus: {
         return exprRes;
@@ -557,47 +655,51 @@ llvm::Value *ObjBuilder::CGUnaryExpr(Ptr<AST> unaryExprRoot)
     return nullptr;
 }
 
-llvm::Value *ObjBuilder::CGSubscriptExpr(Ptr<AST> subscriptExprRoot)
+llvm::Value *ObjBuilder::CGSubscriptExpr(const Ptr<AST> &subscriptExprRoot)
 {
-    // TODO(future): support
-    splc_ilog_error(&subscriptExprRoot->getLocation(), false)
-        << "subscription is not supported yet";
-    return nullptr;
+    return CGLoadLValue(CGLValue(subscriptExprRoot), "elem");
 }
 
-llvm::Value *ObjBuilder::CGDerefExpr(Ptr<AST> derefExprRoot)
+llvm::Value *ObjBuilder::CGDerefExpr(const Ptr<AST> &derefExprRoot)
 {
-    // TODO(future): support
-    splc_ilog_error(&derefExprRoot->getLocation(), false)
-        << "deref is not supported";
-    return nullptr;
+    return CGLoadLValue(CGLValue(derefExprRoot), "deref");
 }
 
-llvm::Value *ObjBuilder::CGAddrOfExpr(Ptr<AST> addrOfExprRoot)
+llvm::Value *ObjBuilder::CGAddrOfExpr(const Ptr<AST> &addrOfExprRoot)
 {
-    // TODO(future): support
-    splc_ilog_error(&addrOfExprRoot->getLocation(), false)
-        << "addr-of is not supported";
-    return nullptr;
+    splc_dbgassert(addrOfExprRoot->getChildrenNum() == 2);
+    return CGLValue(addrOfExprRoot->getChildren()[1]).addr;
 }
 
-llvm::Value *ObjBuilder::CGAccessExpr(Ptr<AST> accessExprRoot)
+llvm::Value *ObjBuilder::CGAccessExpr(const Ptr<AST> &accessExprRoot)
 {
-    // TODO(near_future): support
-    splc_ilog_error(&accessExprRoot->getLocation(), false)
-        << "member access is not supported yet";
-    return nullptr;
+    return CGLoadLValue(CGLValue(accessExprRoot), "member");
 }
 
-llvm::Value *ObjBuilder::CGSizeOfExpr(Ptr<AST> sizeOfExprRoot)
+llvm::Value *ObjBuilder::CGSizeOfExpr(const Ptr<AST> &sizeOfExprRoot)
 {
-    // TODO(future): support
-    splc_ilog_error(&sizeOfExprRoot->getLocation(), false)
-        << "size-of is not supported";
-    return nullptr;
+    splc_dbgassert(sizeOfExprRoot->getChildrenNum() == 2);
+    auto &operand = sizeOfExprRoot->getChildren()[1];
+
+    // The operand is not evaluated.
+    splc::Type *ty = nullptr;
+    if (operand->isTypeName())
+        ty = operand->getChildren()[0]->computeAndSetLangType();
+    else
+        ty = getExprLangType(operand);
+
+    if (ty == nullptr || ty->isVoidTy() || ty->isFunctionTy()) {
+        splc_ilog_error(&sizeOfExprRoot->getLocation(), false)
+            << "cannot determine the size of the operand";
+        return nullptr;
+    }
+
+    const llvm::DataLayout &DL = theModule->getDataLayout();
+    return builder->getInt32(
+        static_cast<uint32_t>(DL.getTypeAllocSize(getCvtType(ty))));
 }
 
-llvm::Value *ObjBuilder::CGCallExpr(Ptr<AST> callExprRoot)
+llvm::Value *ObjBuilder::CGCallExpr(const Ptr<AST> &callExprRoot)
 {
     splc_dbgassert(callExprRoot->isCallExpr());
 
@@ -648,7 +750,7 @@ llvm::Value *ObjBuilder::CGCallExpr(Ptr<AST> callExprRoot)
     }
 }
 
-llvm::Value *ObjBuilder::CGAssignExpr(Ptr<AST> assignExprRoot)
+llvm::Value *ObjBuilder::CGAssignExpr(const Ptr<AST> &assignExprRoot)
 {
     splc_dbgassert(assignExprRoot->getChildrenNum() == 3);
 
@@ -656,7 +758,13 @@ llvm::Value *ObjBuilder::CGAssignExpr(Ptr<AST> assignExprRoot)
     auto &lhsNode = children[0];
     auto &rhsNode = children[2];
 
-    llvm::Value *lhsVal = CGGeneralExprDispatch(lhsNode);
+    ObjLValue lv = CGLValue(lhsNode);
+    if (lv.addr == nullptr)
+        return nullptr;
+
+    // Only compound assignments read the old value.
+    bool isCompound = !children[1]->isOpAssign();
+    llvm::Value *lhsVal = isCompound ? CGLoadLValue(lv) : nullptr;
     llvm::Value *rhsVal = CGGeneralExprDispatch(rhsNode);
     llvm::Value *val2BeAssigned = rhsVal;
 
@@ -787,18 +895,14 @@ llvm::Value *ObjBuilder::CGAssignExpr(Ptr<AST> assignExprRoot)
     }
     }
 
-    auto &IDNode = lhsNode->getChildren()[0];
-    splc_dbgassert(IDNode->isID());
-    auto [ty, memloc] = findNamedValue(IDNode->getRootID());
-    // llvm::AllocaInst *memloc = llvm::findAllocaForValue(lhsVal);
-    // TODO(near_future) check for offset, allowing array specification
-    splc_dbgassert(memloc != nullptr);
-    builder->CreateStore(val2BeAssigned, memloc);
+    if (val2BeAssigned == nullptr)
+        return nullptr;
 
-    return builder->CreateLoad(ty, memloc);
+    CGStoreLValue(val2BeAssigned, lv);
+    return val2BeAssigned;
 }
 
-llvm::Value *ObjBuilder::CGBinaryCondExpr(Ptr<AST> binCondExprRoot)
+llvm::Value *ObjBuilder::CGBinaryCondExpr(const Ptr<AST> &binCondExprRoot)
 {
     splc_dbgassert(binCondExprRoot->getChildrenNum() == 3);
     auto &children = binCondExprRoot->getChildren();
@@ -887,7 +991,7 @@ llvm::Value *ObjBuilder::CGBinaryCondExpr(Ptr<AST> binCondExprRoot)
     return nullptr;
 }
 
-llvm::Value *ObjBuilder::CGBinaryArithExpr(Ptr<AST> binaryExprRoot)
+llvm::Value *ObjBuilder::CGBinaryArithExpr(const Ptr<AST> &binaryExprRoot)
 {
     splc_dbgassert(binaryExprRoot->getChildrenNum() == 3);
     auto &children = binaryExprRoot->getChildren();
@@ -895,6 +999,58 @@ llvm::Value *ObjBuilder::CGBinaryArithExpr(Ptr<AST> binaryExprRoot)
 
     llvm::Value *lhsVal = CGGeneralExprDispatch(children[0]);
     llvm::Value *rhsVal = CGGeneralExprDispatch(children[2]);
+    if (lhsVal == nullptr || rhsVal == nullptr)
+        return nullptr;
+
+    // Pointer arithmetic is scaled by the size of the pointee.
+    bool lhsIsPtr = lhsVal->getType()->isPointerTy();
+    bool rhsIsPtr = rhsVal->getType()->isPointerTy();
+    if ((lhsIsPtr || rhsIsPtr) &&
+        (opType == ASTSymType::OpPlus || opType == ASTSymType::OpMinus)) {
+        Ptr<AST> ptrNode = children[0];
+        if (!lhsIsPtr) {
+            // `int + ptr` is `ptr + int`, while `int - ptr` is meaningless.
+            if (opType == ASTSymType::OpMinus) {
+                splc_ilog_error(&binaryExprRoot->getLocation(), false)
+                    << "cannot subtract a pointer from an integer";
+                return nullptr;
+            }
+            std::swap(lhsVal, rhsVal);
+            ptrNode = children[2];
+        }
+
+        splc::Type *ptrTy = getExprLangType(ptrNode);
+        if (ptrTy != nullptr && ptrTy->isArrayTy())
+            ptrTy = ptrTy->getArrayElementType()->getPointerTo();
+        if (ptrTy == nullptr || !ptrTy->isPointerTy()) {
+            splc_ilog_error(&ptrNode->getLocation(), false)
+                << "cannot infer the pointee type of the pointer operand";
+            return nullptr;
+        }
+        llvm::Type *elemTy = getCvtType(ptrTy->getContainedType(0));
+
+        if (lhsIsPtr && rhsIsPtr) {
+            if (opType == ASTSymType::OpPlus) {
+                splc_ilog_error(&binaryExprRoot->getLocation(), false)
+                    << "cannot add two pointers";
+                return nullptr;
+            }
+            // The difference is counted in elements, as an `int`.
+            llvm::Value *diff = builder->CreatePtrDiff(elemTy, lhsVal, rhsVal);
+            return builder->CreateTrunc(diff, builder->getInt32Ty());
+        }
+        if (!rhsVal->getType()->isIntegerTy()) {
+            splc_ilog_error(&binaryExprRoot->getLocation(), false)
+                << "invalid operands to pointer arithmetic";
+            return nullptr;
+        }
+
+        llvm::Value *offset =
+            builder->CreateSExtOrTrunc(rhsVal, builder->getInt64Ty());
+        if (opType == ASTSymType::OpMinus)
+            offset = builder->CreateNeg(offset);
+        return builder->CreateInBoundsGEP(elemTy, lhsVal, offset);
+    }
 
     switch (opType) {
     case ASTSymType::OpLShift: {
@@ -1010,7 +1166,7 @@ llvm::Value *ObjBuilder::CGBinaryArithExpr(Ptr<AST> binaryExprRoot)
     return nullptr;
 }
 
-llvm::Value *ObjBuilder::CGTrinaryCondExpr(Ptr<AST> triCondExprRoot)
+llvm::Value *ObjBuilder::CGTrinaryCondExpr(const Ptr<AST> &triCondExprRoot)
 {
     // TODO(future)
     splc_ilog_error(&triCondExprRoot->getLocation(), false)
@@ -1018,7 +1174,7 @@ llvm::Value *ObjBuilder::CGTrinaryCondExpr(Ptr<AST> triCondExprRoot)
     return nullptr;
 }
 
-llvm::Value *ObjBuilder::CGImplicitCastExpr(Ptr<AST> impCastExprRoot)
+llvm::Value *ObjBuilder::CGImplicitCastExpr(const Ptr<AST> &impCastExprRoot)
 {
     // TODO(future)
     splc_ilog_error(&impCastExprRoot->getLocation(), false)
@@ -1026,7 +1182,7 @@ llvm::Value *ObjBuilder::CGImplicitCastExpr(Ptr<AST> impCastExprRoot)
     return nullptr;
 }
 
-llvm::Value *ObjBuilder::CGExplicitCastExpr(Ptr<AST> expCastExprRoot)
+llvm::Value *ObjBuilder::CGExplicitCastExpr(const Ptr<AST> &expCastExprRoot)
 {
     // TODO(future)
     splc_ilog_error(&expCastExprRoot->getLocation(), false)
@@ -1034,15 +1190,299 @@ llvm::Value *ObjBuilder::CGExplicitCastExpr(Ptr<AST> expCastExprRoot)
     return nullptr;
 }
 
-llvm::Value *ObjBuilder::CGExprID(Ptr<AST> IDRoot)
+llvm::Value *ObjBuilder::CGExprID(const Ptr<AST> &IDRoot)
 {
     splc_dbgassert(IDRoot->isID());
     auto name = IDRoot->getConstVal<ASTIDType>();
-    auto [ty, allocaInst] = findNamedValue(name);
-    return builder->CreateLoad(ty, allocaInst, name);
+    ObjNamedValue var = findNamedValue(name);
+    if (var.alloca == nullptr) {
+        splc_ilog_error(&IDRoot->getLocation(), false)
+            << "use of undeclared identifier " << name;
+        return nullptr;
+    }
+    return CGLoadLValue({var.alloca, var.langTy}, name);
+}
+
+ObjLValue ObjBuilder::CGLValue(const Ptr<AST> &exprRoot)
+{
+    auto &children = exprRoot->getChildren();
+
+    switch (exprRoot->getSymType()) {
+    case ASTSymType::ID: {
+        ObjNamedValue var = findNamedValue(exprRoot->getRootID());
+        if (var.alloca == nullptr)
+            break;
+        return {var.alloca, var.langTy};
+    }
+
+    case ASTSymType::SubscriptExpr: {
+        splc_dbgassert(children.size() == 4);
+        auto &baseNode = children[0];
+        splc::Type *baseTy = getExprLangType(baseNode);
+        if (baseTy == nullptr)
+            break;
+
+        // Arrays are indexed in place. The first index steps over the whole
+        // array, so that the access stays within its bounds.
+        if (baseTy->isArrayTy()) {
+            ObjLValue base = CGLValue(baseNode);
+            if (base.addr == nullptr)
+                break;
+            llvm::Value *idx = CGGeneralExprDispatch(children[2]);
+            if (idx == nullptr)
+                break;
+            idx = builder->CreateSExtOrTrunc(idx, builder->getInt64Ty());
+            llvm::Value *addr = builder->CreateInBoundsGEP(
+                getCvtType(baseTy), base.addr, {builder->getInt64(0), idx},
+                "arrayidx");
+            return {addr, baseTy->getArrayElementType()};
+        }
+
+        ObjLValue ptr = CGPointerExpr(baseNode);
+        if (ptr.addr == nullptr)
+            break;
+        llvm::Value *idx = CGGeneralExprDispatch(children[2]);
+        if (idx == nullptr)
+            break;
+        idx = builder->CreateSExtOrTrunc(idx, builder->getInt64Ty());
+        llvm::Value *addr = builder->CreateInBoundsGEP(
+            getCvtType(ptr.langTy), ptr.addr, idx, "arrayidx");
+        return {addr, ptr.langTy};
+    }
+
+    case ASTSymType::DerefExpr: {
+        splc_dbgassert(children.size() == 2);
+        return CGPointerExpr(children[1]);
+    }
+
+    case ASTSymType::AccessExpr: {
+        splc_dbgassert(children.size() == 3);
+        ObjLValue base = children[1]->isOpRArrow() ? CGPointerExpr(children[0])
+                                                   : CGLValue(children[0]);
+        if (base.addr == nullptr || base.langTy == nullptr ||
+            !base.langTy->isStructTy())
+            break;
+
+        auto member = children[2]->getRootID();
+        int idx = getStructMemberIndex(base.langTy, member);
+        if (idx < 0) {
+            splc_ilog_error(&children[2]->getLocation(), false)
+                << "no member named " << member;
+            return {};
+        }
+        auto *structTy =
+            getStructType(dynamic_cast<splc::StructType *>(base.langTy));
+        llvm::Value *addr = builder->CreateStructGEP(
+            structTy, base.addr, static_cast<unsigned>(idx), member);
+
+        // Members of members keep the path from the outermost struct.
+        uint64_t offset = theModule->getDataLayout()
+                              .getStructLayout(structTy)
+                              ->getElementOffset(static_cast<unsigned>(idx));
+        if (base.baseTy != nullptr)
+            return {addr,
+                    base.langTy->getStructElementType(
+                        static_cast<unsigned>(idx)),
+                    base.baseTy, base.offset + offset};
+        return {addr,
+                base.langTy->getStructElementType(static_cast<unsigned>(idx)),
+                base.langTy, offset};
+    }
+
+    default: {
+        // Parenthesized expressions and primary expressions wrap the lvalue.
+        if (children.size() == 1 &&
+            children[0]->isSymTypeOneOf(ASTSymType::ID, ASTSymType::Expr))
+            return CGLValue(children[0]);
+        break;
+    }
+    }
+
+    splc_ilog_error(&exprRoot->getLocation(), false)
+        << "expression is not assignable";
+    return {};
+}
+
+ObjLValue ObjBuilder::CGPointerExpr(const Ptr<AST> &exprRoot)
+{
+    splc::Type *ty = getExprLangType(exprRoot);
+    if (ty != nullptr && ty->isArrayTy()) {
+        ObjLValue arr = CGLValue(exprRoot);
+        return {arr.addr, ty->getArrayElementType()};
+    }
+    if (ty == nullptr || !ty->isPointerTy()) {
+        splc_ilog_error(&exprRoot->getLocation(), false)
+            << "operand is neither a pointer nor an array";
+        return {};
+    }
+
+    llvm::Value *ptr = CGGeneralExprDispatch(exprRoot);
+    if (ptr == nullptr)
+        return {};
+    return {ptr, ty->getContainedType(0)};
+}
+
+llvm::Value *ObjBuilder::CGLoadLValue(const ObjLValue &lv,
+                                      std::string_view name)
+{
+    if (lv.addr == nullptr || lv.langTy == nullptr)
+        return nullptr;
+    if (lv.langTy->isArrayTy())
+        return lv.addr;
+
+    llvm::Type *ty = getCvtType(lv.langTy);
+    const llvm::DataLayout &DL = theModule->getDataLayout();
+    llvm::LoadInst *load = builder->CreateAlignedLoad(
+        ty, lv.addr, DL.getABITypeAlign(ty), name);
+    if (llvm::MDNode *tag = getTBAATag(lv))
+        load->setMetadata(llvm::LLVMContext::MD_tbaa, tag);
+    return load;
+}
+
+void ObjBuilder::CGStoreLValue(llvm::Value *val, const ObjLValue &lv)
+{
+    llvm::Type *ty = getCvtType(lv.langTy);
+    if (val->getType()->isIntegerTy() && ty->isIntegerTy())
+        val = builder->CreateSExtOrTrunc(val, ty);
+
+    const llvm::DataLayout &DL = theModule->getDataLayout();
+    llvm::StoreInst *store =
+        builder->CreateAlignedStore(val, lv.addr, DL.getABITypeAlign(ty));
+    if (llvm::MDNode *tag = getTBAATag(lv))
+        store->setMetadata(llvm::LLVMContext::MD_tbaa, tag);
+}
+
+llvm::Value *ObjBuilder::CGIncOrDec(const ObjLValue &lv, llvm::Value *val,
+                                    bool isInc)
+{
+    llvm::Type *ty = val->getType();
+    if (ty->isIntegerTy()) {
+        auto one = llvm::ConstantInt::get(ty, 1);
+        return isInc ? builder->CreateAdd(val, one)
+                     : builder->CreateSub(val, one);
+    }
+    if (ty->isFloatingPointTy()) {
+        auto one = llvm::ConstantFP::get(ty, 1.0);
+        return isInc ? builder->CreateFAdd(val, one)
+                     : builder->CreateFSub(val, one);
+    }
+    if (ty->isPointerTy() && lv.langTy->isPointerTy()) {
+        return builder->CreateInBoundsGEP(
+            getCvtType(lv.langTy->getContainedType(0)), val,
+            builder->getInt64(isInc ? 1 : -1));
+    }
+
+    splc_ilog_error(nullptr, false)
+        << "operand cannot be incremented or decremented";
+    return nullptr;
 }
 
-llvm::Value *ObjBuilder::CGGeneralExprDispCN1(Ptr<AST> exprRoot)
+splc::Type *ObjBuilder::getExprLangType(const Ptr<AST> &exprRoot)
+{
+    auto &children = exprRoot->getChildren();
+
+    switch (exprRoot->getSymType()) {
+    case ASTSymType::ID: {
+        return findNamedValue(exprRoot->getRootID()).langTy;
+    }
+
+    case ASTSymType::SubscriptExpr:
+    case ASTSymType::DerefExpr: {
+        splc::Type *ty = getExprLangType(children.front()->isGeneralExpr()
+                                             ? children.front()
+                                             : children[1]);
+        if (ty == nullptr)
+            return nullptr;
+        if (ty->isArrayTy())
+            return ty->getArrayElementType();
+        if (ty->isPointerTy())
+            return ty->getContainedType(0);
+        return nullptr;
+    }
+
+    case ASTSymType::AddrOfExpr: {
+        splc::Type *ty = getExprLangType(children[1]);
+        return ty == nullptr ? nullptr : ty->getPointerTo();
+    }
+
+    case ASTSymType::AccessExpr: {
+        splc::Type *ty = getExprLangType(children[0]);
+        if (ty != nullptr && children[1]->isOpRArrow())
+            ty = ty->isPointerTy() ? ty->getContainedType(0) : nullptr;
+        if (ty == nullptr || !ty->isStructTy())
+            return nullptr;
+        int idx = getStructMemberIndex(ty, children[2]->getRootID());
+        return idx < 0 ? nullptr
+                       : ty->getStructElementType(static_cast<unsigned>(idx));
+    }
+
+    default:
+        break;
+    }
+
+    if (children.size() == 1 &&
+        children[0]->isSymTypeOneOf(ASTSymType::ID, ASTSymType::Expr))
+        return getExprLangType(children[0]);
+
+    if (children.size() == 3) {
+        // Assignments and the comma operator have the type of one side.
+        if (children[1]->isOpComma())
+            return getExprLangType(children[2]);
+        if (children[1]->isSymTypeOneOf(ASTSymType::OpAssign,
+                                        ASTSymType::OpPlusAssign,
+                                        ASTSymType::OpMinusAssign))
+            return getExprLangType(children[0]);
+
+        // Pointer arithmetic, in which arrays decay to pointers.
+        if (children[1]->isSymTypeOneOf(ASTSymType::OpPlus,
+                                        ASTSymType::OpMinus)) {
+            auto decay = [](splc::Type *ty) -> splc::Type * {
+                if (ty != nullptr && ty->isArrayTy())
+                    return ty->getArrayElementType()->getPointerTo();
+                return ty != nullptr && ty->isPointerTy() ? ty : nullptr;
+            };
+            splc::Type *lhsTy = decay(getExprLangType(children[0]));
+            splc::Type *rhsTy = decay(getExprLangType(children[2]));
+            // `ptr - ptr` is an integer, and `int + ptr` is a pointer.
+            if (lhsTy != nullptr && rhsTy == nullptr)
+                return lhsTy;
+            if (lhsTy == nullptr && children[1]->isOpPlus())
+                return rhsTy;
+        }
+    }
+
+    if (children.size() == 2) {
+        if (children[1]->isSymTypeOneOf(ASTSymType::OpDPlus,
+                                        ASTSymType::OpDMinus))
+            return getExprLangType(children[0]);
+        if (children[0]->isSymTypeOneOf(ASTSymType::OpDPlus,
+                                        ASTSymType::OpDMinus))
+            return getExprLangType(children[1]);
+    }
+
+    return nullptr;
+}
+
+int ObjBuilder::getStructMemberIndex(splc::Type *ty, std::string_view member)
+{
+    auto it = structMembers.find(ty);
+    if (it == structMembers.end())
+        return -1;
+
+    // Members are the variables declared in the body, in declaration order.
+    int idx = 0;
+    for (const auto &[name, sym] : it->second->getSymbolList()) {
+        if (sym.symEntTy != SymEntryType::Variable &&
+            sym.symEntTy != SymEntryType::Paramater)
+            continue;
+        if (name == member)
+            return idx;
+        ++idx;
+    }
+    return -1;
+}
+
+llvm::Value *ObjBuilder::CGGeneralExprDispCN1(const Ptr<AST> &exprRoot)
 {
     auto &child = exprRoot->getChildren()[0];
 
@@ -1062,7 +1502,7 @@ llvm::Value *ObjBuilder::CGGeneralExprDispCN1(Ptr<AST> exprRoot)
     }
 }
 
-llvm::Value *ObjBuilder::CGGeneralExprDispCN2(Ptr<AST> exprRoot)
+llvm::Value *ObjBuilder::CGGeneralExprDispCN2(const Ptr<AST> &exprRoot)
 {
     auto &children = exprRoot->getChildren();
 
@@ -1079,7 +1519,7 @@ llvm::Value *ObjBuilder::CGGeneralExprDispCN2(Ptr<AST> exprRoot)
     return nullptr;
 }
 
-llvm::Value *ObjBuilder::CGGeneralExprDispCN3(Ptr<AST> exprRoot)
+llvm::Value *ObjBuilder::CGGeneralExprDispCN3(const Ptr<AST> &exprRoot)
 {
     auto &children = exprRoot->getChildren();
 
@@ -1116,7 +1556,7 @@ llvm::Value *ObjBuilder::CGGeneralExprDispCN3(Ptr<AST> exprRoot)
     return nullptr;
 }
 
-llvm::Value *ObjBuilder::CGGeneralExprDispCNN(Ptr<AST> exprRoot)
+llvm::Value *ObjBuilder::CGGeneralExprDispCNN(const Ptr<AST> &exprRoot)
 {
     splc_dbgassert(exprRoot->getChildrenNum() > 0);
     auto &children = exprRoot->getChildren();
@@ -1129,7 +1569,7 @@ llvm::Value *ObjBuilder::CGGeneralExprDispCNN(Ptr<AST> exprRoot)
     return nullptr;
 }
 
-llvm::Value *ObjBuilder::CGGeneralExprDispatch(Ptr<AST> exprRoot)
+llvm::Value *ObjBuilder::CGGeneralExprDispatch(const Ptr<AST> &exprRoot)
 {
     splc_dbgassert(exprRoot->isGeneralExpr());
 
@@ -1179,7 +1619,7 @@ llvm::Value *ObjBuilder::CGGeneralExprDispatch(Ptr<AST> exprRoot)
 //===----------------------------------------------------------------------===//
 // Statements
 
-void ObjBuilder::CGCompStmt(Ptr<AST> compStmtRoot)
+void ObjBuilder::CGCompStmt(const Ptr<AST> &compStmtRoot)
 {
     splc_dbgassert(compStmtRoot->isCompStmt());
 
@@ -1205,14 +1645,14 @@ void ObjBuilder::CGCompStmt(Ptr<AST> compStmtRoot)
     popVarCtxStack();
 }
 
-void ObjBuilder::CGExprStmt(Ptr<AST> exprStmtRoot)
+void ObjBuilder::CGExprStmt(const Ptr<AST> &exprStmtRoot)
 {
     splc_dbgassert(exprStmtRoot->isExprStmt());
     auto &expr = exprStmtRoot->getChildren()[0];
     CGGeneralExprDispatch(expr);
 }
 
-void ObjBuilder::CGIfStmt(Ptr<AST> ifStmtRoot)
+void ObjBuilder::CGIfStmt(const Ptr<AST> &ifStmtRoot)
 {
     splc_dbgassert(ifStmtRoot->isSelStmt());
 
@@ -1274,7 +1714,7 @@ void ObjBuilder::CGIfStmt(Ptr<AST> ifStmtRoot)
     // No PHI node because they don't return llvm::Value*
 }
 
-void ObjBuilder::CGSelStmt(Ptr<AST> selStmtRoot)
+void ObjBuilder::CGSelStmt(const Ptr<AST> &selStmtRoot)
 {
     splc_dbgassert(selStmtRoot->isSelStmt());
 
@@ -1290,7 +1730,7 @@ void ObjBuilder::CGSelStmt(Ptr<AST> selStmtRoot)
         << "not supported in ObjBuilder";
 }
 
-void ObjBuilder::CGDoWhileStmt(Ptr<AST> doWhileStmtRoot)
+void ObjBuilder::CGDoWhileStmt(const Ptr<AST> &doWhileStmtRoot)
 {
     splc_dbgassert(doWhileStmtRoot->isIterStmt());
     // TODO(near_future)
@@ -1298,7 +1738,7 @@ void ObjBuilder::CGDoWhileStmt(Ptr<AST> doWhileStmtRoot)
         << "not supported in ObjBuilder";
 }
 
-void ObjBuilder::CGWhileStmt(Ptr<AST> whileStmtRoot)
+void ObjBuilder::CGWhileStmt(const Ptr<AST> &whileStmtRoot)
 {
     splc_dbgassert(whileStmtRoot->isIterStmt());
 
@@ -1341,7 +1781,7 @@ void ObjBuilder::CGWhileStmt(Ptr<AST> whileStmtRoot)
     builder->SetInsertPoint(afterBB);
 }
 
-void ObjBuilder::CGForStmt(Ptr<AST> forStmtRoot)
+void ObjBuilder::CGForStmt(const Ptr<AST> &forStmtRoot)
 {
     splc_dbgassert(forStmtRoot->isIterStmt());
     // TODO(near_future)
@@ -1349,7 +1789,7 @@ void ObjBuilder::CGForStmt(Ptr<AST> forStmtRoot)
         << "not supported in ObjBuilder";
 }
 
-void ObjBuilder::CGIterStmt(Ptr<AST> iterStmtRoot)
+void ObjBuilder::CGIterStmt(const Ptr<AST> &iterStmtRoot)
 {
     splc_dbgassert(iterStmtRoot->isIterStmt());
 
@@ -1365,7 +1805,7 @@ void ObjBuilder::CGIterStmt(Ptr<AST> iterStmtRoot)
         << "not supported in ObjBuilder";
 }
 
-void ObjBuilder::CGLabeledStmt(Ptr<AST> labeledStmtRoot)
+void ObjBuilder::CGLabeledStmt(const Ptr<AST> &labeledStmtRoot)
 {
     splc_dbgassert(labeledStmtRoot->isLabeledStmt());
     // TODO(near_future)
@@ -1373,7 +1813,7 @@ void ObjBuilder::CGLabeledStmt(Ptr<AST> labeledStmtRoot)
         << "not supported in ObjBuilder";
 }
 
-void ObjBuilder::CGReturnStmt(Ptr<AST> returnStmtRoot)
+void ObjBuilder::CGReturnStmt(const Ptr<AST> &returnStmtRoot)
 {
     splc_dbgassert(returnStmtRoot->isJumpStmt());
 
@@ -1393,7 +1833,7 @@ void ObjBuilder::CGReturnStmt(Ptr<AST> returnStmtRoot)
     builder->CreateRet(val);
 }
 
-void ObjBuilder::CGJumpStmt(Ptr<AST> jumpStmtRoot)
+void ObjBuilder::CGJumpStmt(const Ptr<AST> &jumpStmtRoot)
 {
     splc_dbgassert(jumpStmtRoot->isJumpStmt());
 
@@ -1409,7 +1849,7 @@ void ObjBuilder::CGJumpStmt(Ptr<AST> jumpStmtRoot)
         << "not supported in ObjBuilder";
 }
 
-void ObjBuilder::CGStmt(Ptr<AST> stmtRoot)
+void ObjBuilder::CGStmt(const Ptr<AST> &stmtRoot)
 {
     splc_dbgassert(stmtRoot->isStmt());
 
@@ -1459,13 +1899,13 @@ void ObjBuilder::CGStmt(Ptr<AST> stmtRoot)
 //===----------------------------------------------------------------------===//
 // Declarations
 
-llvm::Function *ObjBuilder::CGFuncProto(Ptr<AST> protoRoot)
+llvm::Function *ObjBuilder::CGFuncProto(const Ptr<AST> &protoRoot)
 {
     // TODO(revise): just do nothing
     return nullptr;
 }
 
-llvm::Function *ObjBuilder::CGFuncDef(Ptr<AST> funcRoot)
+llvm::Function *ObjBuilder::CGFuncDef(const Ptr<AST> &funcRoot)
 {
     // The given node should be of ASTSymType::FuncDef
     splc_dbgassert(funcRoot->isFuncDef());
@@ -1474,10 +1914,6 @@ llvm::Function *ObjBuilder::CGFuncDef(Ptr<AST> funcRoot)
     auto &compStmtNode = funcRoot->getChildren()[1];
     auto &funcDecltrNode = protoNode->getChildren()[1];
 
-    // Get the type of this function
-    Type *splcFuncTy = funcDecltrNode->getLangType();
-    llvm::Type *funcTy = getCvtType(splcFuncTy); // transform into llvm type
-
     auto ID = funcDecltrNode->getRootID();
     llvm::Function *theFunction = getFunction(ID);
     if (!theFunction) {
@@ -1489,16 +1925,27 @@ llvm::Function *ObjBuilder::CGFuncDef(Ptr<AST> funcRoot)
     builder->SetInsertPoint(BB);
 
     pushVarCtxStack();
-    registerCtx(protoNode->getASTContext());
+    auto protoCtx = protoNode->getASTContext();
+    registerCtx(protoCtx);
+
+    std::vector<std::pair<SymbolID, splc::Type *>> params;
+    auto &protoSymList = protoCtx->getSymbolList();
+    for (size_t i = 0; i < protoSymList.size(); ++i) {
+        const auto &sym = protoSymList[i].second;
+        if (sym.symEntTy == SymEntryType::Paramater)
+            params.emplace_back(protoCtx->getSymbolIDList()[i], sym.type);
+    }
+    splc_dbgassert(params.size() == theFunction->arg_size());
 
     for (auto &arg : theFunction->args()) {
         // Create an alloca for this variable
-        llvm::AllocaInst *alloca =
-            createEntryBlockAlloc(theFunction, funcTy, nullptr, arg.getName());
+        llvm::AllocaInst *alloca = createEntryBlockAlloc(
+            theFunction, arg.getType(), nullptr, arg.getName());
 
         builder->CreateStore(&arg, alloca);
 
-        insertNamedValue(arg.getName(), arg.getType(), alloca);
+        auto [id, langTy] = params[arg.getArgNo()];
+        insertNamedValue(id, arg.getType(), alloca, langTy);
     }
 
     CGCompStmt(compStmtNode);
@@ -1528,10 +1975,14 @@ llvm::Function *ObjBuilder::CGFuncDef(Ptr<AST> funcRoot)
         return nullptr;
     }
 
+    // The analyses are of no use once the function is promoted.
+    theFPM->run(*theFunction, *theFAM);
+    theFAM->clear(*theFunction, theFunction->getName());
+
     return theFunction;
 }
 
-llvm::Value *ObjBuilder::CGInitializer(Ptr<AST> initRoot)
+llvm::Value *ObjBuilder::CGInitializer(const Ptr<AST> &initRoot)
 {
     splc_dbgassert(initRoot->isInitializer());
     // TODO(future): support all kinds of initializers
@@ -1547,7 +1998,7 @@ llvm::Value *ObjBuilder::CGInitializer(Ptr<AST> initRoot)
     return CGGeneralExprDispatch(child);
 }
 
-void ObjBuilder::CGInitDecltr(Ptr<AST> initDecltrRoot)
+void ObjBuilder::CGInitDecltr(const Ptr<AST> &initDecltrRoot)
 {
     splc_dbgassert(initDecltrRoot->isInitDecltr());
 
@@ -1564,13 +2015,14 @@ void ObjBuilder::CGInitDecltr(Ptr<AST> initDecltrRoot)
 
     llvm::Value *initVal = CGInitializer(initNode);
     auto ID = decltrNode->getRootID();
-    auto [ty, allocaInst] = findNamedValue(ID);
-    splc_dbgassert(allocaInst != nullptr)
+    ObjNamedValue var = findNamedValue(ID);
+    splc_dbgassert(var.alloca != nullptr)
         << "cannot bind allocation instance to ID " << ID;
-    builder->CreateStore(initVal, allocaInst);
+    if (initVal != nullptr)
+        CGStoreLValue(initVal, {var.alloca, var.langTy});
 }
 
-void ObjBuilder::CGInitDecltrList(Ptr<AST> initDecltrListRoot)
+void ObjBuilder::CGInitDecltrList(const Ptr<AST> &initDecltrListRoot)
 {
     splc_dbgassert(initDecltrListRoot->isInitDecltrList());
     for (auto &child : initDecltrListRoot->getChildren()) {
@@ -1578,7 +2030,7 @@ void ObjBuilder::CGInitDecltrList(Ptr<AST> initDecltrListRoot)
     }
 }
 
-void ObjBuilder::CGDirDecl(Ptr<AST> dirDeclRoot)
+void ObjBuilder::CGDirDecl(const Ptr<AST> &dirDeclRoot)
 {
     splc_dbgassert(dirDeclRoot->isDirDecl());
     // Two possibilities:
@@ -1593,14 +2045,14 @@ void ObjBuilder::CGDirDecl(Ptr<AST> dirDeclRoot)
     }
 }
 
-void ObjBuilder::CGDecl(Ptr<AST> declRoot)
+void ObjBuilder::CGDecl(const Ptr<AST> &declRoot)
 {
     splc_dbgassert(declRoot->isDecl());
     auto &child0 = declRoot->getChildren()[0];
     CGDirDecl(child0);
 }
 
-void ObjBuilder::CGExternDecl(Ptr<AST> externDeclRoot)
+void ObjBuilder::CGExternDecl(const Ptr<AST> &externDeclRoot)
 {
     splc_dbgassert(externDeclRoot->isExternDecl());
     auto &child0 = externDeclRoot->getChildren()[0];
@@ -1619,7 +2071,7 @@ void ObjBuilder::CGExternDecl(Ptr<AST> externDeclRoot)
     }
 }
 
-void ObjBuilder::CGExternDeclList(Ptr<AST> externDeclListRoot)
+void ObjBuilder::CGExternDeclList(const Ptr<AST> &externDeclListRoot)
 {
     splc_dbgassert(externDeclListRoot->isExternDeclList());
     for (auto &child : externDeclListRoot->getChildren()) {
@@ -1627,15 +2079,17 @@ void ObjBuilder::CGExternDeclList(Ptr<AST> externDeclListRoot)
     }
 }
 
-void ObjBuilder::CGTransUnit(Ptr<AST> transUnitRoot)
+void ObjBuilder::CGTransUnit(const Ptr<AST> &transUnitRoot)
 {
     splc_dbgassert(transUnitRoot->isTransUnit());
     if (transUnitRoot->getChildrenNum() == 0)
         return;
 
     // Register the context of translation unit
+    symbolPool = transUnitRoot->getASTContext()->getSymbolPool();
     pushVarCtxStack();
     registerCtx(transUnitRoot->getASTContext());
+    declareRuntimeFunctions();
 
     auto &child = transUnitRoot->getChildren()[0];
     CGExternDeclList(child);
@@ -1649,23 +2103,110 @@ void ObjBuilder::generateModule(TranslationUnit &tunit)
     generateModuleImpl(tunit);
 }
 
-void ObjBuilder::optimizeModule() { optimizeModuleImpl(); }
+void ObjBuilder::optimizeModule(llvm::OptimizationLevel level,
+                                unsigned numThreads)
+{
+    optimizeModuleImpl(level, numThreads);
+}
+
+void ObjBuilder::optimizeModuleForLTO(llvm::OptimizationLevel level,
+                                      bool preLink)
+{
+    if (!llvmModuleGenerated) {
+        splc_ilog_error(nullptr, false)
+            << "contained module has not been generated";
+        return;
+    }
+
+    runPipeline(*theModule, targetMachine.get(), [&](llvm::PassBuilder &PB) {
+        return preLink ? PB.buildLTOPreLinkDefaultPipeline(level)
+                       : PB.buildLTODefaultPipeline(level, nullptr);
+    });
+}
+
+bool ObjBuilder::linkBitcodeFiles(const std::vector<std::string> &paths)
+{
+    initializeInternalStates();
+
+    llvm::Linker linker{*theModule};
+    for (auto &path : paths) {
+        auto bufOrErr = llvm::MemoryBuffer::getFile(path);
+        if (!bufOrErr) {
+            splc_ilog_error(nullptr, false)
+                << "cannot read " << path << ": "
+                << bufOrErr.getError().message();
+            setGenerationStatus(false);
+            return false;
+        }
+
+        auto partOrErr =
+            llvm::parseBitcodeFile((*bufOrErr)->getMemBufferRef(), getLLVMCtx());
+        if (!partOrErr) {
+            splc_ilog_error(nullptr, false)
+                << "cannot parse " << path << ": "
+                << llvm::toString(partOrErr.takeError());
+            setGenerationStatus(false);
+            return false;
+        }
+
+        if (linker.linkInModule(std::move(*partOrErr))) {
+            splc_ilog_error(nullptr, false) << "failed to link " << path;
+            setGenerationStatus(false);
+            return false;
+        }
+    }
+
+    // Only `main` is called from outside of the program.
+    llvm::internalizeModule(*theModule, [](const llvm::GlobalValue &GV) {
+        return GV.getName() == "main";
+    });
+
+    llvmModuleGenerated = true;
+    return true;
+}
 
 void ObjBuilder::writeModuleAsLLVMIR(std::ostream &os)
 {
     writeModuleLLVMIRImpl(os);
 }
 
-void ObjBuilder::writeModuleAsAsm(std::string_view targetTriple,
-                                  std::string_view path)
+bool ObjBuilder::writeModuleAsBitcode(std::string_view path)
 {
-    writeModuleAsFile(llvm::CodeGenFileType::AssemblyFile, targetTriple, path);
+    if (!llvmModuleGenerated || !isGenerationSuccess()) {
+        splc_ilog_fatal_error(nullptr, false)
+            << "no module generated/generation has failed. Skipping writing "
+               "bitcode.";
+        return false;
+    }
+
+    std::error_code errorCode;
+    llvm::raw_fd_ostream dest(path, errorCode, llvm::sys::fs::OF_None);
+    if (errorCode) {
+        splc_ilog_fatal_error(nullptr, false)
+            << "Could not open file: " << errorCode.message();
+        return false;
+    }
+
+    llvm::WriteBitcodeToFile(*theModule, dest);
+    dest.flush();
+    SPLC_LOG_INFO(nullptr, false) << "wrote " << path;
+    return !dest.has_error();
+}
+
+bool ObjBuilder::writeModuleAsAsm(std::string_view path)
+{
+    return writeModuleAsFile(llvm::CodeGenFileType::AssemblyFile, path);
+}
+
+bool ObjBuilder::writeModuleAsObj(std::string_view path)
+{
+    return writeModuleAsFile(llvm::CodeGenFileType::ObjectFile, path);
 }
 
-void ObjBuilder::writeModuleAsObj(std::string_view targetTriple,
-                                  std::string_view path)
+int ObjBuilder::runModuleInJIT(std::string_view programName,
+                               const std::vector<std::string> &args)
 {
-    writeModuleAsFile(llvm::CodeGenFileType::ObjectFile, targetTriple, path);
+    return runModuleInJITImpl(programName, args);
 }
 
 //===----------------------------------------------------------------------===//
@@ -1679,7 +2220,8 @@ void ObjBuilder::generateModuleImpl(TranslationUnit &tunit)
     llvmModuleGenerated = true;
 }
 
-void ObjBuilder::optimizeModuleImpl()
+void ObjBuilder::optimizeModuleImpl(llvm::OptimizationLevel level,
+                                    unsigned numThreads)
 {
     if (!llvmModuleGenerated) {
         splc_ilog_error(nullptr, false)
@@ -1687,41 +2229,82 @@ void ObjBuilder::optimizeModuleImpl()
         return;
     }
 
-    // Create new pass and analysis managers.
-    theFPM = makeUniquePtr<llvm::FunctionPassManager>();
-    theLAM = makeUniquePtr<llvm::LoopAnalysisManager>();
-    theFAM = makeUniquePtr<llvm::FunctionAnalysisManager>();
-    theCGAM = makeUniquePtr<llvm::CGSCCAnalysisManager>();
-    theMAM = makeUniquePtr<llvm::ModuleAnalysisManager>();
-    thePIC = makeUniquePtr<llvm::PassInstrumentationCallbacks>();
-    theSI =
-        makeUniquePtr<llvm::StandardInstrumentations>(getLLVMCtx(),
-                                                      /*DebugLogging*/ true);
-    theSI->registerCallbacks(*thePIC, theMAM.get());
-
-    // Add transform passes.
-    // Do simple "peephole" optimizations and bit-twiddling optzns.
-    theFPM->addPass(llvm::InstCombinePass());
-    // Reassociate expressions.
-    theFPM->addPass(llvm::ReassociatePass());
-    // Eliminate Common SubExpressions.
-    theFPM->addPass(llvm::GVNPass());
-    // Simplify the control flow graph (deleting unreachable blocks, etc).
-    theFPM->addPass(llvm::SimplifyCFGPass());
-
-    // Register analysis passes used in these transform passes.
-    llvm::PassBuilder PB;
-    PB.registerModuleAnalyses(*theMAM);
-    PB.registerFunctionAnalyses(*theFAM);
-    PB.crossRegisterProxies(*theLAM, *theFAM, *theCGAM, *theMAM);
+    size_t numDefinedFuncs = std::ranges::count_if(
+        theModule->functions(),
+        [](const llvm::Function &func) { return !func.isDeclaration(); });
+    size_t numParts = std::min<size_t>(
+        numThreads, numDefinedFuncs / minFunctionsPerPartition);
 
-    // Optimize each function (if not declaration only)
-    for (auto &func : theModule->getFunctionList()) {
-        if (!func.isDeclaration())
-            theFPM->run(func, *theFAM);
+    if (level == llvm::OptimizationLevel::O0 || numParts <= 1) {
+        runDefaultPipeline(*theModule, targetMachine.get(), level);
+        return;
+    }
+
+    // An LLVMContext cannot be shared among threads. Each partition is
+    // carried over to its own context as bitcode. Internal symbols are kept
+    // in the partition of their users, so that they can still be inlined.
+    std::vector<llvm::SmallVector<char, 0>> partitions;
+    llvm::SplitModule(
+        *theModule, static_cast<unsigned>(numParts),
+        [&](std::unique_ptr<llvm::Module> part) {
+            writeBitcode(*part, partitions.emplace_back());
+        },
+        /*PreserveLocals=*/true);
+
+    std::vector<std::string> errors(partitions.size());
+    std::vector<std::thread> workers;
+    workers.reserve(partitions.size());
+    for (size_t i = 0; i < partitions.size(); ++i) {
+        workers.emplace_back([&, i]() {
+            llvm::LLVMContext partCtx;
+            auto partOrErr = readBitcode(partitions[i], partCtx);
+            if (!partOrErr) {
+                errors[i] = llvm::toString(partOrErr.takeError());
+                return;
+            }
+            // A target machine must not be used by two threads at once.
+            TargetService::Lease partMachine =
+                TargetService::getInstance().acquireTargetMachine(
+                    targetTriple, targetCPU, targetFeatures, errors[i]);
+            if (!partMachine)
+                return;
+            runDefaultPipeline(**partOrErr, partMachine.get(), level);
+            writeBitcode(**partOrErr, partitions[i]);
+        });
+    }
+    for (auto &t : workers) {
+        t.join();
     }
 
-    // TODO(near_future): module-level optimization
+    for (auto &err : errors) {
+        if (!err.empty()) {
+            splc_ilog_error(nullptr, false)
+                << "failed to optimize module partition: " << err;
+            return;
+        }
+    }
+
+    // Link the optimized partitions back into the context of the builder.
+    auto merged = makeUniquePtr<llvm::Module>(theModule->getName(),
+                                              getLLVMCtx());
+    merged->setTargetTriple(theModule->getTargetTriple());
+    merged->setDataLayout(theModule->getDataLayout());
+    llvm::Linker linker{*merged};
+    for (auto &buf : partitions) {
+        auto partOrErr = readBitcode(buf, getLLVMCtx());
+        if (!partOrErr) {
+            splc_ilog_error(nullptr, false)
+                << "failed to read optimized partition: "
+                << llvm::toString(partOrErr.takeError());
+            return;
+        }
+        if (linker.linkInModule(std::move(*partOrErr))) {
+            splc_ilog_error(nullptr, false)
+                << "failed to link optimized partitions";
+            return;
+        }
+    }
+    theModule = std::move(merged);
 }
 
 void ObjBuilder::writeModuleLLVMIRImpl(std::ostream &os)
@@ -1730,46 +2313,23 @@ void ObjBuilder::writeModuleLLVMIRImpl(std::ostream &os)
     theModule->print(trueOs, nullptr);
 }
 
-void ObjBuilder::writeModuleAsFile(llvm::CodeGenFileType fileType,
-                                   std::string_view path,
-                                   std::string_view targetTriple)
+bool ObjBuilder::writeModuleAsFile(llvm::CodeGenFileType fileType,
+                                   std::string_view path)
 {
-    if (!llvmModuleGenerated && !isGenerationSuccess()) {
+    if (!llvmModuleGenerated || !isGenerationSuccess()) {
         splc_ilog_fatal_error(nullptr, false)
             << "no module generated/generation has failed. Skipping writing "
                "object file.";
-        return;
+        return false;
     }
 
-    initializeTargetRegistry();
-    theModule->setTargetTriple(targetTriple);
-
-    std::string errorMsg;
-    auto target = llvm::TargetRegistry::lookupTarget(targetTriple, errorMsg);
-
-    if (!target) {
-        splc_ilog_fatal_error(nullptr, false)
-            << "failed to lookup target: " << targetTriple;
-        splc_ilog_fatal_error(nullptr, false) << errorMsg;
-        return;
-    }
-
-    auto CPU = "generic";
-    auto Features = "";
-
-    llvm::TargetOptions opt;
-    UniquePtr<llvm::TargetMachine> targetMachine{target->createTargetMachine(
-        targetTriple, CPU, Features, opt, llvm::Reloc::PIC_)};
-
-    theModule->setDataLayout(targetMachine->createDataLayout());
-
     std::error_code errorCode;
     llvm::raw_fd_ostream dest(path, errorCode, llvm::sys::fs::OF_None);
 
     if (errorCode) {
         splc_ilog_fatal_error(nullptr, false)
             << "Could not open file: " << errorCode.message();
-        return;
+        return false;
     }
 
     llvm::legacy::PassManager pass;
@@ -1777,7 +2337,7 @@ void ObjBuilder::writeModuleAsFile(llvm::CodeGenFileType fileType,
     if (targetMachine->addPassesToEmitFile(pass, dest, nullptr, fileType)) {
         splc_ilog_fatal_error(nullptr, false)
             << "TheTargetMachine can't emit a file of this type";
-        return;
+        return false;
     }
 
     pass.run(*theModule);
@@ -1790,6 +2350,88 @@ void ObjBuilder::writeModuleAsFile(llvm::CodeGenFileType fileType,
         << "writing object file for platform: " << CS::BrightCyan
         << targetTriple << CS::Reset;
     SPLC_LOG_INFO(nullptr, false) << "wrote " << path;
+    return !dest.has_error();
+}
+
+int ObjBuilder::runModuleInJITImpl(std::string_view programName,
+                                   const std::vector<std::string> &args)
+{
+    if (!llvmModuleGenerated || !isGenerationSuccess()) {
+        splc_ilog_fatal_error(nullptr, false)
+            << "no module generated/generation has failed. Skipping running "
+               "the program.";
+        return -1;
+    }
+
+    // The JIT generates code for the host through the native backend.
+    std::string errorMsg;
+    if (!TargetService::getInstance().initializeTarget(
+            llvm::sys::getProcessTriple(), errorMsg)) {
+        splc_ilog_fatal_error(nullptr, false)
+            << "failed to initialize the native target: " << errorMsg;
+        return -1;
+    }
+
+    auto jitOrErr = llvm::orc::LLLazyJITBuilder{}.create();
+    if (!jitOrErr) {
+        splc_ilog_fatal_error(nullptr, false)
+            << "failed to create the JIT: "
+            << llvm::toString(jitOrErr.takeError());
+        return -1;
+    }
+    auto &jit = **jitOrErr;
+
+    // Symbols of the main dylib take precedence over those of the process,
+    // e.g., POSIX read() and write().
+    llvm::orc::SymbolMap hostSymbols;
+    auto flags =
+        llvm::JITSymbolFlags::Exported | llvm::JITSymbolFlags::Callable;
+    hostSymbols[jit.mangleAndIntern("read")] = llvm::orc::ExecutorSymbolDef{
+        llvm::orc::ExecutorAddr::fromPtr(&hostRead), flags};
+    hostSymbols[jit.mangleAndIntern("write")] = llvm::orc::ExecutorSymbolDef{
+        llvm::orc::ExecutorAddr::fromPtr(&hostWrite), flags};
+    if (auto err = jit.getMainJITDylib().define(
+            llvm::orc::absoluteSymbols(std::move(hostSymbols)))) {
+        splc_ilog_fatal_error(nullptr, false)
+            << "failed to define host symbols: "
+            << llvm::toString(std::move(err));
+        return -1;
+    }
+
+    // The JIT takes ownership of the module together with its context.
+    llvmModuleGenerated = false;
+    targetMachine = TargetService::Lease{};
+    builder.reset();
+    tyCache.clear();
+    tbaaRoot = nullptr;
+    tbaaTypeNodes.clear();
+    varCtxStack.clear();
+    namedValues.clear();
+    symbolPool.reset();
+    functionProtos.clear();
+    if (auto err = jit.addLazyIRModule(llvm::orc::ThreadSafeModule{
+            std::move(theModule), std::move(llvmCtx)})) {
+        splc_ilog_fatal_error(nullptr, false)
+            << "failed to add the module to the JIT: "
+            << llvm::toString(std::move(err));
+        return -1;
+    }
+
+    auto mainOrErr = jit.lookup("main");
+    if (!mainOrErr) {
+        splc_ilog_fatal_error(nullptr, false)
+            << "failed to look up main: "
+            << llvm::toString(mainOrErr.takeError());
+        return -1;
+    }
+
+    // Calling a `main` without parameters with (argc, argv) is harmless in
+    // the C calling convention.
+    using MainFnTy = int (*)(int, char *[]);
+    int exitCode = llvm::orc::runAsMain(mainOrErr->toPtr<MainFnTy>(), args,
+                                        llvm::StringRef{programName});
+    std::fflush(stdout);
+    return exitCode;
 }
 
 //===----------------------------------------------------------------------===//
@@ -1803,27 +2445,53 @@ void ObjBuilder::initializeModuleAndManagers()
     theModule = makeUniquePtr<llvm::Module>(
         "splc auto-gen module " + std::to_string(moduleCnt++), getLLVMCtx());
 
+    // The data layout decides type sizes and alignments during generation,
+    // and the target machine the cost models during optimization.
+    std::string errorMsg;
+    targetMachine = TargetService::getInstance().acquireTargetMachine(
+        targetTriple, targetCPU, targetFeatures, errorMsg);
+    if (targetMachine) {
+        theModule->setTargetTriple(targetTriple);
+        theModule->setDataLayout(targetMachine->createDataLayout());
+    }
+    else {
+        splc_ilog_fatal_error(nullptr, false)
+            << "failed to lookup target: " << targetTriple;
+        splc_ilog_fatal_error(nullptr, false) << errorMsg;
+        setGenerationStatus(false);
+    }
+
     // Create a new builder for the module.
     builder = makeUniquePtr<llvm::IRBuilder<>>(getLLVMCtx());
-}
 
-void ObjBuilder::initializeTargetRegistry()
-{
-    if (llvmTargetEnvInitialized)
-        return;
+    // Create new pass and analysis managers.
+    theFPM = makeUniquePtr<llvm::FunctionPassManager>();
+    theLAM = makeUniquePtr<llvm::LoopAnalysisManager>();
+    theFAM = makeUniquePtr<llvm::FunctionAnalysisManager>();
+    theCGAM = makeUniquePtr<llvm::CGSCCAnalysisManager>();
+    theMAM = makeUniquePtr<llvm::ModuleAnalysisManager>();
+
+    // SROA without CFG changes is mem2reg extended to aggregates, and is cheap
+    // enough to run in unoptimized builds.
+    theFPM->addPass(llvm::SROAPass{llvm::SROAOptions::PreserveCFG});
 
-    llvm::InitializeAllTargetInfos();
-    llvm::InitializeAllTargets();
-    llvm::InitializeAllTargetMCs();
-    llvm::InitializeAllAsmParsers();
-    llvm::InitializeAllAsmPrinters();
-    llvmTargetEnvInitialized = true;
+    llvm::PassBuilder PB{targetMachine.get()};
+    PB.registerModuleAnalyses(*theMAM);
+    PB.registerCGSCCAnalyses(*theCGAM);
+    PB.registerFunctionAnalyses(*theFAM);
+    PB.registerLoopAnalyses(*theLAM);
+    PB.crossRegisterProxies(*theLAM, *theFAM, *theCGAM, *theMAM);
 }
 
 void ObjBuilder::initializeInternalStates()
 {
     tyCache.clear();
+    structMembers.clear();
+    tbaaRoot = nullptr;
+    tbaaTypeNodes.clear();
     varCtxStack.clear();
+    namedValues.clear();
+    symbolPool.reset();
     functionProtos.clear();
     setGenerationStatus(true);
     llvmModuleGenerated = false;
@@ -1846,28 +2514,33 @@ llvm::AllocaInst *ObjBuilder::createEntryBlockAlloc(llvm::Function *theFunction,
 
 void ObjBuilder::pushVarCtxStack() { varCtxStack.push_back({}); }
 
-void ObjBuilder::popVarCtxStack() { varCtxStack.pop_back(); }
-
-std::pair<llvm::Type *, llvm::AllocaInst *>
-ObjBuilder::findNamedValue(std::string_view name) const
+void ObjBuilder::popVarCtxStack()
 {
-    for (auto &varCtx : std::views::reverse(varCtxStack)) {
-        auto it = varCtx.namedValues.find(name);
-        if (it != varCtx.namedValues.end())
-            return it->second;
+    auto &shadowed = varCtxStack.back().shadowedValues;
+    for (auto &[id, value] : std::views::reverse(shadowed)) {
+        namedValues[id] = value;
     }
-    return {nullptr, nullptr};
+    varCtxStack.pop_back();
+}
+
+ObjNamedValue ObjBuilder::findNamedValue(std::string_view name) const
+{
+    if (symbolPool == nullptr)
+        return {};
+    return findNamedValue(symbolPool->find(name));
 }
 
-void ObjBuilder::insertNamedValue(std::string_view name, llvm::Type *ty,
-                                  llvm::AllocaInst *alloca)
+void ObjBuilder::insertNamedValue(SymbolID id, llvm::Type *ty,
+                                  llvm::AllocaInst *alloca, splc::Type *langTy)
 {
-    auto &varCtx = varCtxStack.back();
-    varCtx.namedValues[std::string{name}] = {ty, alloca};
+    if (id >= namedValues.size())
+        namedValues.resize(id + 1);
+    varCtxStack.back().shadowedValues.emplace_back(id, namedValues[id]);
+    namedValues[id] = {ty, alloca, langTy};
 }
 
 void ObjBuilder::registerFuncProto(std::string_view name, llvm::Type *ty,
-                                   Ptr<AST> protoRoot)
+                                   const Ptr<AST> &protoRoot)
 {
     functionProtos[std::string{name}] = {ty, protoRoot};
 }
@@ -0,0 +1,113 @@
+#include "CodeGen/TargetService.hh"
+
+namespace splc {
+
+namespace {
+
+using InitializerFn = void (*)();
+
+/// Target and MC layer initializers of every backend built into LLVM, keyed
+/// by backend name.
+// clang-format off
+const std::map<std::string_view, std::vector<InitializerFn>> &
+getBackendInitializers()
+{
+    static const std::map<std::string_view, std::vector<InitializerFn>>
+        initializers = [] {
+            std::map<std::string_view, std::vector<InitializerFn>> map;
+#define LLVM_TARGET(TargetName)                                                \
+    map[#TargetName].push_back(LLVMInitialize##TargetName##Target);            \
+    map[#TargetName].push_back(LLVMInitialize##TargetName##TargetMC);
+#include "llvm/Config/Targets.def"
+#define LLVM_ASM_PRINTER(TargetName)                                           \
+    map[#TargetName].push_back(LLVMInitialize##TargetName##AsmPrinter);
+#include "llvm/Config/AsmPrinters.def"
+            return map;
+        }();
+    return initializers;
+}
+// clang-format on
+
+} // namespace
+
+TargetService &TargetService::getInstance()
+{
+    static TargetService service;
+    return service;
+}
+
+TargetService::Lease::~Lease()
+{
+    if (service && machine)
+        service->release(std::move(key), std::move(machine));
+}
+
+const llvm::Target *TargetService::initializeTarget(std::string_view triple,
+                                                    std::string &errorMsg)
+{
+    std::lock_guard<std::mutex> lockGuard{serviceMutex};
+
+    // Target infos only register names, which is cheap and required to look
+    // up the backend of a triple.
+    if (!targetInfosInitialized) {
+        llvm::InitializeAllTargetInfos();
+        targetInfosInitialized = true;
+    }
+
+    const llvm::Target *target =
+        llvm::TargetRegistry::lookupTarget(std::string{triple}, errorMsg);
+    if (!target)
+        return nullptr;
+
+    std::string_view backend = target->getBackendName();
+    if (initializedBackends.contains(backend))
+        return target;
+
+    auto &initializers = getBackendInitializers();
+    if (auto it = initializers.find(backend); it != initializers.end()) {
+        for (InitializerFn init : it->second)
+            init();
+    }
+    initializedBackends.emplace(backend);
+    return target;
+}
+
+TargetService::Lease
+TargetService::acquireTargetMachine(std::string_view triple,
+                                    std::string_view cpu,
+                                    std::string_view features,
+                                    std::string &errorMsg)
+{
+    KeyType key{std::string{triple}, std::string{cpu}, std::string{features}};
+    {
+        std::lock_guard<std::mutex> lockGuard{serviceMutex};
+        if (auto it = idleMachines.find(key);
+            it != idleMachines.end() && !it->second.empty()) {
+            UniquePtr<llvm::TargetMachine> machine = std::move(it->second.back());
+            it->second.pop_back();
+            return Lease{this, std::move(key), std::move(machine)};
+        }
+    }
+
+    const llvm::Target *target = initializeTarget(triple, errorMsg);
+    if (!target)
+        return {};
+
+    llvm::TargetOptions opt;
+    UniquePtr<llvm::TargetMachine> machine{target->createTargetMachine(
+        std::get<0>(key), std::get<1>(key), std::get<2>(key), opt,
+        llvm::Reloc::PIC_)};
+    if (!machine) {
+        errorMsg = "cannot create target machine for " + std::get<0>(key);
+        return {};
+    }
+    return Lease{this, std::move(key), std::move(machine)};
+}
+
+void TargetService::release(KeyType key, UniquePtr<llvm::TargetMachine> machine)
+{
+    std::lock_guard<std::mutex> lockGuard{serviceMutex};
+    idleMachines[std::move(key)].push_back(std::move(machine));
+}
+
+} // namespace splc
@@ -36,6 +36,8 @@ void CommandLineParser::parseArgs(const int argc,
                                   const char *const argv[]) noexcept
 {
     int i = 0;
+    bool stopAtDirArg = false;
+    bool endOfOptions = false;
 
     // Skip itself, assume user has passed the original argc/argv
     if (argc >= 1) {
@@ -43,6 +45,16 @@ void CommandLineParser::parseArgs(const int argc,
     }
     for (; i < argc; ++i) {
         std::string_view arg{argv[i]};
+        if (endOfOptions) {
+            dirArg.push_back(std::string{arg});
+            continue;
+        }
+        if (arg == "--"sv) {
+            // Everything that follows is a direct argument.
+            endOfOptions = true;
+            continue;
+        }
+
         std::string_view argName;
         std::string_view argOpt = ""sv;
         auto pos = arg.find('=');
@@ -79,6 +91,7 @@ void CommandLineParser::parseArgs(const int argc,
         else {
             // a direct argument
             dirArg.push_back(std::string{arg});
+            endOfOptions = stopAtDirArg;
             continue;
         }
 
@@ -90,7 +103,8 @@ void CommandLineParser::parseArgs(const int argc,
             continue;
         }
 
-        bool requireOpt = it->second == ArgOption::WithOption;
+        bool requireOpt = (it->second & ArgOption::WithOption) != 0;
+        stopAtDirArg |= (it->second & ArgOption::StopAtDirArg) != 0;
 
         // find the corresponding argOpt, if any
         if (pos != std::string_view::npos) {
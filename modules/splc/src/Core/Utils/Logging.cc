@@ -11,8 +11,7 @@ namespace internal {
 
 std::mutex logStreamMutex;
 
-// TODO: consider change logStream
-std::ostream *logStream = &std::cerr;
+thread_local std::ostream *logStream = &std::cerr;
 
 std::ostream &getLogStream() { return *logStream; }
 
@@ -24,13 +24,22 @@ Ptr<TranslationUnit> Driver::parse(std::string_view filename)
 
     transMgr->startTranslationRecord(getContext());
 
-    Ptr<TranslationContext> context =
-        transMgr->pushTransFileContext(nullptr, filename);
+    Ptr<TranslationUnit> tunit = transMgr->getTransUnit();
+    {
+        // All nodes created during parsing live in the arena of the unit.
+        ASTArena::ActiveScope arenaScope{&tunit->getASTArena()};
 
-    internalParse(context);
-    transMgr->endTranslationRecord();
+        Ptr<TranslationContext> context =
+            transMgr->pushTransFileContext(nullptr, filename);
 
-    Ptr<TranslationUnit> tunit = transMgr->getTransUnit();
+        internalParse(context);
+        transMgr->endTranslationRecord();
+
+        // The parser and scanner may still hold nodes, which must not
+        // outlive the unit.
+        parser.reset();
+        scanner.reset();
+    }
 
     // Clear the TranslationManager
     transMgr.reset();
@@ -38,6 +47,26 @@ Ptr<TranslationUnit> Driver::parse(std::string_view filename)
     return tunit;
 }
 
+void Driver::preprocess(std::string_view filename, std::ostream &os)
+{
+    transMgr = makeSharedPtr<TranslationManager>();
+
+    transMgr->startTranslationRecord(getContext());
+
+    // No arena here: each token is released as soon as it has been written.
+    Ptr<TranslationContext> context =
+        transMgr->pushTransFileContext(nullptr, filename);
+
+    scanner = makeSharedPtr<Scanner>(*transMgr);
+    scanner->setInitialContext(context);
+    scanner->getPreprocessor().writePreprocessedTokens(os);
+
+    transMgr->endTranslationRecord();
+
+    scanner.reset();
+    transMgr.reset();
+}
+
 // // TODO: remove experimental
 // Ptr<TranslationUnit>
 // Driver::parse(const std::vector<std::string> &filenameVector_)
@@ -4,7 +4,7 @@
 %{
 
 #undef  YY_DECL
-#define YY_DECL int splc::IO::Scanner::yylex(splc::IO::Parser::value_type *const yylval, splc::utils::Location *yyloc)
+#define YY_DECL int splc::IO::Scanner::lexRaw(splc::IO::Parser::value_type *const yylval, splc::utils::Location *yyloc)
 
 // Implementation of yyFlexScanner
 #include "Core/splc.hh"
@@ -60,6 +60,8 @@ using String = std::string;
 %s IN_PPD_INCL_ABFN
 /* Preprocessor Directive: define */
 %s IN_PPD_DEFINE
+/* Preprocessor Directive: define parameter list */
+%s IN_PPD_DEFINE_PARAMS
 /* Preprocessor Directive: define body */
 %s IN_PPD_DEFINE_BODY
 
@@ -138,7 +140,12 @@ identifier [a-zA-Z_][a-zA-Z0-9_]*
     //                   Preprocessor Directive Translation
     //===------------------------------------------------------------------===*/
 <INITIAL># {
-    yy_push_state(IN_PPD);
+    if (tokenizeOnly) {
+        SPLC_LOG_ERROR(gloc, true) << "'#' and '##' are not supported in macro replacement lists";
+    }
+    else {
+        yy_push_state(IN_PPD);
+    }
 }
 
     /* PPD Dispatch: include */
@@ -211,7 +218,9 @@ identifier [a-zA-Z_][a-zA-Z0-9_]*
 }
 
 <IN_PPD_INCL_ABFN,IN_PPD_INCL_DQFN>\r?\n {
-    yy_pop_state();
+    /* IN_PPD was replaced by IN_PPD_INCL and then by the file name state,
+       so a single pop returns to the state before '#'. */
+    gloc->lines();
     yy_pop_state();
 }
 
@@ -222,7 +231,7 @@ identifier [a-zA-Z_][a-zA-Z0-9_]*
     //                        PPD: #define directive
     //===------------------------------------------------------------------===*/
 <IN_PPD_DEFINE>{identifier} {
-    if (!isMacroVarContextPresent(yytext))
+    if (!preprocessor.isMacroDefined(yytext))
     {
         tmpStr = yytext;
         tmpLoc = *gloc;
@@ -231,10 +240,30 @@ identifier [a-zA-Z_][a-zA-Z0-9_]*
     else {
         internalFlag = false;
     }
+    macroFunctionLike = false;
+    macroParams.clear();
+    macroBodyLoc = *gloc;
     yy_pop_state();
     yy_push_state(IN_PPD_DEFINE_BODY);
 }
 
+    /* Function-like macro: the parameter list follows the name immediately */
+<IN_PPD_DEFINE>{identifier}/"(" {
+    if (!preprocessor.isMacroDefined(yytext))
+    {
+        tmpStr = yytext;
+        tmpLoc = *gloc;
+        internalFlag = true;
+    }
+    else {
+        internalFlag = false;
+    }
+    macroFunctionLike = true;
+    macroParams.clear();
+    yy_pop_state();
+    yy_push_state(IN_PPD_DEFINE_PARAMS);
+}
+
 <IN_PPD_DEFINE>. {
 
 }
@@ -248,7 +277,51 @@ identifier [a-zA-Z_][a-zA-Z0-9_]*
     yy_pop_state();
 }
 
-<IN_PPD_DEFINE_BODY>[^\r\n]+ {
+<IN_PPD_DEFINE_PARAMS>"(" {
+}
+
+<IN_PPD_DEFINE_PARAMS>{identifier} {
+    if (std::find(macroParams.begin(), macroParams.end(), yytext) != macroParams.end()) {
+        SPLC_LOG_ERROR(gloc, true) << "duplicate macro parameter '" << yytext << "'";
+    }
+    macroParams.push_back(yytext);
+}
+
+<IN_PPD_DEFINE_PARAMS>"..." {
+    SPLC_LOG_ERROR(gloc, true) << "variadic macros are not supported";
+}
+
+<IN_PPD_DEFINE_PARAMS>[ \t,] {
+}
+
+<IN_PPD_DEFINE_PARAMS>")" {
+    macroBodyLoc = *gloc;
+    yy_pop_state();
+    yy_push_state(IN_PPD_DEFINE_BODY);
+}
+
+<IN_PPD_DEFINE_PARAMS>\\\r?\n {
+    gloc->lines();
+}
+
+<IN_PPD_DEFINE_PARAMS>\r?\n {
+    SPLC_LOG_ERROR(gloc, true) << "missing ')' in macro parameter list";
+    gloc->lines();
+    yy_pop_state();
+}
+
+<IN_PPD_DEFINE_PARAMS>. {
+    SPLC_LOG_ERROR(gloc, true) << "expected parameter name";
+}
+
+<IN_PPD_DEFINE_BODY>[^\\\r\n]+ {
+    if (internalFlag) {
+        strVec.push_back(yytext);
+        locVec.push_back(*gloc);
+    }
+}
+
+<IN_PPD_DEFINE_BODY>\\ {
     if (internalFlag) {
         strVec.push_back(yytext);
         locVec.push_back(*gloc);
@@ -258,7 +331,8 @@ identifier [a-zA-Z_][a-zA-Z0-9_]*
 <IN_PPD_DEFINE_BODY>\\\r?\n {
     gloc->lines();
     if (internalFlag) {
-        strVec.push_back(yytext);
+        /* A line continuation separates tokens like a space */
+        strVec.push_back(" ");
         locVec.push_back(*gloc);
     }
 }
@@ -272,7 +346,9 @@ identifier [a-zA-Z_][a-zA-Z0-9_]*
         
         String content = concatTmpStrVec();
         *gloc = concatTmpLocVec();
-        splc_assert(registerMacroVarContext(&tmpLoc, tmpStr, content)) << "internal error: cannot register macro var";
+        preprocessor.defineMacro(&tmpLoc, tmpStr, macroFunctionLike,
+                                 std::move(macroParams), content,
+                                 macroBodyLoc);
     }
 }
 
@@ -566,21 +642,11 @@ identifier [a-zA-Z_][a-zA-Z0-9_]*
     /*===------------------------------------------------------------------===//
     //                           Identifier Definition
     //===------------------------------------------------------------------===*/
+    /* Macros and typedef names are resolved by the preprocessor. */
 <INITIAL>{identifier} {
     String val{yytext};
-    /* First, check if it is a macro definition. If it is, just expand. */
-    if (isMacroVarContextPresent(val)) {
-        splc_assert(pushMacroVarContext(gloc, val));
-        yy_push_state(INITIAL);
-    }
-    else if (transMgr.isSymDeclared(SymEntryType::Typedef, val)) {
-        *glval = AST::make(tyCtx, SymType::TypedefID, *gloc, val);
-        return Token::TypedefID;
-    }
-    else {
-        *glval = AST::make(tyCtx, SymType::ID, *gloc, val);
-        return Token::ID;
-    }
+    *glval = AST::make(tyCtx, SymType::ID, *gloc, val);
+    return Token::ID;
 }
 
 <INITIAL>[0-9][a-zA-Z0-9_]* {
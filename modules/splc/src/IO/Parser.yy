@@ -320,7 +320,7 @@ StructOrUnionSpec:
                                   SymEntryType::UnionDecl,
               "",
               structTy,
-              true, &$$->getLocation());
+              true, &$$->getLocation(), $$);
       }
     | StructOrUnion IDWrapper StructDeclBody {
           $$ = AST::makeDerived<StructOrUnionSpecAST>(tyCtx, @$, $1, $2, $3);
@@ -334,7 +334,7 @@ StructOrUnionSpec:
                                   SymEntryType::UnionDecl,
               $2->getRootID(),
               structTy,
-              true, &$$->getLocation());
+              true, &$$->getLocation(), $$);
       }
     ;
 
@@ -636,35 +636,35 @@ FuncProto:
       DeclSpecWrapper FuncDecltr {
           auto ID = $2->getRootID();
 
-          if (!transMgr.isSymDefined(SymEntryType::Function, ID)) {
-
-              $$ = AST::make(tyCtx, SymType::FuncProto, @$, $1, $2);
+          $$ = AST::make(tyCtx, SymType::FuncProto, @$, $1, $2);
 
-              // push all parameters
-              auto paramTypeNode = $2->findFirstChildBFS(SymType::ParamTypeList);
+          // push all parameters
+          auto paramTypeNode = $2->findFirstChildBFS(SymType::ParamTypeList);
 
-              for (auto &child : paramTypeNode->getChildren()[0]->getChildren()) {
-                  auto IDNode = child->getRootIDNode();
-                  transMgr.tryRegisterSymbol(
-                      SymEntryType::Paramater, IDNode->getRootID(),
-                      IDNode->getRootIDLangType(),
-                      false, &child->getLocation());
-              }
+          for (auto &child : paramTypeNode->getChildren()[0]->getChildren()) {
+              auto IDNode = child->getRootIDNode();
+              transMgr.tryRegisterSymbol(
+                  SymEntryType::Paramater, IDNode->getRootID(),
+                  IDNode->getRootIDLangType(),
+                  false, &child->getLocation());
+          }
 
-              auto ctx = transMgr.getASTCtxMgr()[0]; // Pop the context temporarily to push function definition.
-              transMgr.popASTCtx();
+          auto ctx = transMgr.getASTCtxMgr()[0]; // Pop the context temporarily to push function definition.
+          transMgr.popASTCtx();
 
-              // register function
-              $2->computeAndSetLangType($1->computeAndSetLangType());
+          // register function
+          $2->computeAndSetLangType($1->computeAndSetLangType());
 
+          // A redefinition is reported once the body is registered in FuncDef.
+          if (!transMgr.isSymDefined(SymEntryType::Function, ID)) {
               transMgr.tryRegisterSymbol(
                   SymEntryType::Function, ID,
                   $2->getRootIDLangType(),
                   false, &@2);
-
-              transMgr.pushASTCtx(ctx);
-              $$->setASTContext(ctx);
           }
+
+          transMgr.pushASTCtx(ctx);
+          $$->setASTContext(ctx);
       }
     ;
 
@@ -0,0 +1,470 @@
+#include "IO/Preprocessor.hh"
+#include "AST/DerivedAST.hh"
+#include "Core/Utils/Logging.hh"
+#include "IO/Scanner.hh"
+#include "Translation/SourceBuffer.hh"
+
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+
+namespace splc::IO {
+
+using Token = Parser::token;
+
+namespace {
+
+/// \return the spelling of keywords and punctuators, or an empty view.
+std::string_view getFixedSpelling(ASTSymType symType) noexcept
+{
+    switch (symType) {
+    // clang-format off
+    case ASTSymType::KwdAuto:        return "auto";
+    case ASTSymType::KwdExtern:      return "extern";
+    case ASTSymType::KwdRegister:    return "register";
+    case ASTSymType::KwdStatic:      return "static";
+    case ASTSymType::KwdTypedef:     return "typedef";
+    case ASTSymType::KwdConst:       return "const";
+    case ASTSymType::KwdRestrict:    return "restrict";
+    case ASTSymType::KwdVolatile:    return "volatile";
+    case ASTSymType::KwdInline:      return "inline";
+    case ASTSymType::VoidTy:         return "void";
+    case ASTSymType::CharTy:         return "char";
+    case ASTSymType::ShortTy:        return "short";
+    case ASTSymType::IntTy:          return "int";
+    case ASTSymType::SignedTy:       return "signed";
+    case ASTSymType::UnsignedTy:     return "unsigned";
+    case ASTSymType::LongTy:         return "long";
+    case ASTSymType::FloatTy:        return "float";
+    case ASTSymType::DoubleTy:       return "double";
+    case ASTSymType::KwdEnum:        return "enum";
+    case ASTSymType::KwdStruct:      return "struct";
+    case ASTSymType::KwdUnion:       return "union";
+    case ASTSymType::KwdIf:          return "if";
+    case ASTSymType::KwdElse:        return "else";
+    case ASTSymType::KwdSwitch:      return "switch";
+    case ASTSymType::KwdWhile:       return "while";
+    case ASTSymType::KwdFor:         return "for";
+    case ASTSymType::KwdDo:          return "do";
+    case ASTSymType::KwdDefault:     return "default";
+    case ASTSymType::KwdCase:        return "case";
+    case ASTSymType::KwdGoto:        return "goto";
+    case ASTSymType::KwdContinue:    return "continue";
+    case ASTSymType::KwdBreak:       return "break";
+    case ASTSymType::KwdReturn:      return "return";
+    case ASTSymType::OpAssign:       return "=";
+    case ASTSymType::OpMulAssign:    return "*=";
+    case ASTSymType::OpDivAssign:    return "/=";
+    case ASTSymType::OpModAssign:    return "%=";
+    case ASTSymType::OpPlusAssign:   return "+=";
+    case ASTSymType::OpMinusAssign:  return "-=";
+    case ASTSymType::OpLShiftAssign: return "<<=";
+    case ASTSymType::OpRShiftAssign: return ">>=";
+    case ASTSymType::OpBAndAssign:   return "&=";
+    case ASTSymType::OpBXorAssign:   return "^=";
+    case ASTSymType::OpBOrAssign:    return "|=";
+    case ASTSymType::OpAnd:          return "&&";
+    case ASTSymType::OpOr:           return "||";
+    case ASTSymType::OpNot:          return "!";
+    case ASTSymType::OpLT:           return "<";
+    case ASTSymType::OpLE:           return "<=";
+    case ASTSymType::OpGT:           return ">";
+    case ASTSymType::OpGE:           return ">=";
+    case ASTSymType::OpNE:           return "!=";
+    case ASTSymType::OpEQ:           return "==";
+    case ASTSymType::OpQMark:        return "?";
+    case ASTSymType::OpColon:        return ":";
+    case ASTSymType::OpLShift:       return "<<";
+    case ASTSymType::OpRShift:       return ">>";
+    case ASTSymType::OpBAnd:         return "&";
+    case ASTSymType::OpBOr:          return "|";
+    case ASTSymType::OpBNot:         return "~";
+    case ASTSymType::OpBXor:         return "^";
+    case ASTSymType::OpDPlus:        return "++";
+    case ASTSymType::OpDMinus:       return "--";
+    case ASTSymType::OpPlus:         return "+";
+    case ASTSymType::OpMinus:        return "-";
+    case ASTSymType::OpAstrk:        return "*";
+    case ASTSymType::OpDiv:          return "/";
+    case ASTSymType::OpMod:          return "%";
+    case ASTSymType::OpDot:          return ".";
+    case ASTSymType::OpRArrow:       return "->";
+    case ASTSymType::OpSizeOf:       return "sizeof";
+    case ASTSymType::OpLSB:          return "[";
+    case ASTSymType::OpRSB:          return "]";
+    case ASTSymType::OpComma:        return ",";
+    case ASTSymType::OpEllipsis:     return "...";
+    case ASTSymType::PSemi:          return ";";
+    case ASTSymType::PLC:            return "{";
+    case ASTSymType::PRC:            return "}";
+    case ASTSymType::PLP:            return "(";
+    case ASTSymType::PRP:            return ")";
+    default:                         return {};
+    // clang-format on
+    }
+}
+
+///
+/// \brief Write `c` as it would appear inside a literal delimited by `quote`.
+/// \return true if `c` was written as a hexadecimal escape sequence.
+///
+bool writeEscapedChar(std::ostream &os, char c, char quote)
+{
+    if (c == '\\' || c == quote) {
+        os << '\\' << c;
+        return false;
+    }
+    if (std::isprint(static_cast<unsigned char>(c))) {
+        os << c;
+        return false;
+    }
+    static constexpr char hexDigits[] = "0123456789abcdef";
+    auto u = static_cast<unsigned char>(c);
+    os << "\\x" << hexDigits[u >> 4] << hexDigits[u & 0xf];
+    return true;
+}
+
+void writeTokenSpelling(std::ostream &os, AST &node)
+{
+    ASTSymType symType = node.getSymType();
+    if (std::string_view spelling = getFixedSpelling(symType);
+        !spelling.empty()) {
+        os << spelling;
+        return;
+    }
+
+    switch (symType) {
+    case ASTSymType::ID:
+    case ASTSymType::TypedefID: {
+        os << node.getConstVal<ASTIDType>();
+        break;
+    }
+    case ASTSymType::UIntLiteral: {
+        os << node.getConstVal<ASTUIntType>();
+        break;
+    }
+    case ASTSymType::SIntLiteral: {
+        os << node.getConstVal<ASTSIntType>();
+        break;
+    }
+    case ASTSymType::FloatLiteral: {
+        // Shortest representation that reads back to the same value. The
+        // scanner requires a decimal point.
+        char buf[32];
+        auto res = std::to_chars(buf, buf + sizeof(buf),
+                                 node.getConstVal<ASTFloatType>());
+        std::string_view str{buf, static_cast<size_t>(res.ptr - buf)};
+        if (str.find_first_of(".eEn") == std::string_view::npos)
+            os << str << ".0";
+        else if (str.find('.') == std::string_view::npos)
+            os << str.substr(0, str.find_first_of("eE")) << ".0"
+               << str.substr(str.find_first_of("eE"));
+        else
+            os << str;
+        break;
+    }
+    case ASTSymType::CharLiteral: {
+        os << '\'';
+        writeEscapedChar(os, node.getConstVal<ASTCharType>(), '\'');
+        os << '\'';
+        break;
+    }
+    case ASTSymType::StrUnit: {
+        os << '"';
+        bool afterHexEscape = false;
+        for (char c : node.getConstVal<ASTIDType>()) {
+            // A hexadecimal escape sequence would swallow the digits after
+            // it, so the literal is split in two.
+            if (afterHexEscape && std::isxdigit(static_cast<unsigned char>(c)))
+                os << "\" \"";
+            afterHexEscape = writeEscapedChar(os, c, '"');
+        }
+        os << '"';
+        break;
+    }
+    default: {
+        splc_error() << "no spelling for token " << symType;
+    }
+    }
+}
+
+} // namespace
+
+int MacroDefinition::findParam(std::string_view name_) const noexcept
+{
+    auto it = std::find(params.begin(), params.end(), name_);
+    return it == params.end() ? -1 : static_cast<int>(it - params.begin());
+}
+
+int Preprocessor::lex(value_type *yylval, Location *yyloc)
+{
+    for (;;) {
+        PPToken tok = nextToken();
+        if (tok.isIdentifier()) {
+            if (tryExpand(tok))
+                continue;
+
+            // Typedef names can only be told apart once the parser has seen
+            // the declarations before them.
+            if (transMgr.isSymDeclared(SymEntryType::Typedef,
+                                       tok.getIdentifier())) {
+                tok.kind = Token::TypedefID;
+                tok.node = AST::make(tyCtx, ASTSymType::TypedefID, tok.loc,
+                                     ASTIDType{tok.getIdentifier()});
+            }
+        }
+
+        *yylval = std::move(tok.node);
+        *yyloc = tok.loc;
+        return tok.kind;
+    }
+}
+
+bool Preprocessor::defineMacro(const Location *defLoc_, std::string_view name_,
+                               bool isFunctionLike_,
+                               std::vector<std::string> params_,
+                               std::string_view body_,
+                               const Location &bodyLoc_)
+{
+    if (isMacroDefined(name_))
+        return false;
+
+    MacroDefinition macro;
+    macro.name = name_;
+    macro.defLoc = *defLoc_;
+    macro.isFunctionLike = isFunctionLike_;
+    macro.params = std::move(params_);
+
+    // Lex the replacement list once, with a scanner of its own that neither
+    // expands macros nor follows directives.
+    MemoryInputStream bodyStream{body_};
+    Scanner bodyScanner{transMgr, &bodyStream};
+    bodyScanner.tokenizeOnly = true;
+
+    Location loc = bodyLoc_;
+    value_type val;
+    while (int kind = bodyScanner.lexRaw(&val, &loc)) {
+        macro.body.push_back(PPToken{kind, std::move(val), loc});
+        val = nullptr;
+    }
+
+    std::string key = macro.name;
+    macros.emplace(std::move(key), std::move(macro));
+    return true;
+}
+
+void Preprocessor::writePreprocessedTokens(std::ostream &os)
+{
+    const Location::ContextNameType *curFile = nullptr;
+    Location::CounterType curLine = 0;
+    bool atLineStart = true;
+
+    value_type val;
+    Location loc;
+    while (lex(&val, &loc) != Token::YYEOF) {
+        const Position &pos = loc.begin;
+        if (pos.contextName != curFile || pos.line < curLine ||
+            pos.line > curLine + 8) {
+            // Jump with a line marker.
+            if (!atLineStart)
+                os << '\n';
+            os << "# " << pos.line << " \"";
+            if (pos.contextName)
+                os << *pos.contextName;
+            os << "\"\n";
+            curFile = pos.contextName;
+            curLine = pos.line;
+            atLineStart = true;
+        }
+        else if (pos.line > curLine) {
+            // Short gaps are cheaper as plain newlines.
+            for (; curLine < pos.line; ++curLine)
+                os << '\n';
+            atLineStart = true;
+        }
+
+        if (atLineStart)
+            os << std::string(std::max(pos.column - 1, 0), ' ');
+        else
+            os << ' ';
+        writeTokenSpelling(os, *val);
+        atLineStart = false;
+    }
+    if (!atLineStart)
+        os << '\n';
+    os.flush();
+}
+
+const MacroDefinition *
+Preprocessor::findMacro(std::string_view name_) const noexcept
+{
+    auto it = macros.find(name_);
+    return it == macros.end() ? nullptr : &it->second;
+}
+
+PPToken Preprocessor::lexRaw()
+{
+    value_type val;
+    int kind = scanner.lexRaw(&val, &rawLoc);
+    return PPToken{kind, std::move(val), rawLoc};
+}
+
+PPToken Preprocessor::nextToken()
+{
+    while (!pending.empty()) {
+        PPToken tok = std::move(pending.front());
+        pending.pop_front();
+        if (tok.kind != PPToken::endOfExpansion)
+            return tok;
+
+        auto it = std::find(activeMacros.rbegin(), activeMacros.rend(),
+                            tok.macro);
+        if (it != activeMacros.rend())
+            activeMacros.erase(std::next(it).base());
+    }
+    return lexRaw();
+}
+
+bool Preprocessor::tryExpand(const PPToken &tok)
+{
+    if (tok.noExpand)
+        return false;
+
+    const MacroDefinition *macro = findMacro(tok.getIdentifier());
+    if (macro == nullptr || isActive(macro))
+        return false;
+
+    std::vector<std::vector<PPToken>> args;
+    if (macro->isFunctionLike) {
+        // A function-like macro name not followed by `(` is an ordinary
+        // identifier.
+        PPToken next = nextToken();
+        if (next.kind != Token::PLP) {
+            pending.push_front(std::move(next));
+            return false;
+        }
+        if (!collectArguments(*macro, tok.loc, args))
+            return true;
+        for (auto &arg : args)
+            expandArgument(arg);
+    }
+
+    // Expanded tokens are located at the invocation, while substituted
+    // arguments keep their own locations.
+    std::vector<PPToken> result;
+    result.reserve(macro->body.size() + 1);
+    for (const PPToken &proto : macro->body) {
+        int paramIdx = macro->isFunctionLike && proto.isIdentifier()
+                           ? macro->findParam(proto.getIdentifier())
+                           : -1;
+        if (paramIdx < 0) {
+            result.push_back(instantiate(proto, tok.loc));
+            continue;
+        }
+        for (const PPToken &argTok : args[paramIdx])
+            result.push_back(instantiate(argTok, argTok.loc));
+    }
+    result.push_back(
+        PPToken{PPToken::endOfExpansion, nullptr, tok.loc, macro});
+
+    pending.insert(pending.begin(), std::make_move_iterator(result.begin()),
+                   std::make_move_iterator(result.end()));
+    activeMacros.push_back(macro);
+    return true;
+}
+
+bool Preprocessor::collectArguments(const MacroDefinition &macro,
+                                    const Location &useLoc,
+                                    std::vector<std::vector<PPToken>> &args)
+{
+    args.assign(1, {});
+
+    int depth = 0;
+    for (;;) {
+        PPToken tok = nextToken();
+        if (tok.kind == Token::YYEOF) {
+            SPLC_LOG_ERROR(&useLoc, true)
+                << "unterminated argument list invoking macro '" << macro.name
+                << "'";
+            pending.push_front(std::move(tok));
+            return false;
+        }
+
+        if (tok.kind == Token::PLP) {
+            ++depth;
+        }
+        else if (tok.kind == Token::PRP) {
+            if (depth == 0)
+                break;
+            --depth;
+        }
+        else if (tok.kind == Token::OpComma && depth == 0) {
+            args.emplace_back();
+            continue;
+        }
+        else if (tok.isIdentifier() && isActive(findMacro(tok.getIdentifier()))) {
+            tok.noExpand = true;
+        }
+        args.back().push_back(std::move(tok));
+    }
+
+    if (macro.params.empty() && args.size() == 1 && args.front().empty())
+        args.clear();
+
+    if (args.size() != macro.params.size()) {
+        SPLC_LOG_ERROR(&useLoc, true)
+            << "macro '" << macro.name << "' requires " << macro.params.size()
+            << " arguments, but " << args.size() << " given";
+        SPLC_LOG_NOTE(&macro.defLoc, false) << "macro defined here";
+        return false;
+    }
+    return true;
+}
+
+void Preprocessor::expandArgument(std::vector<PPToken> &arg)
+{
+    // Run the argument through the pending queue on its own, terminated by
+    // `YYEOF` so that nothing is read past it.
+    std::deque<PPToken> outerPending;
+    outerPending.swap(pending);
+    pending.assign(std::make_move_iterator(arg.begin()),
+                   std::make_move_iterator(arg.end()));
+    pending.push_back(PPToken{Token::YYEOF, nullptr, Location{}});
+    arg.clear();
+
+    for (;;) {
+        PPToken tok = nextToken();
+        if (tok.kind == Token::YYEOF)
+            break;
+        if (tok.isIdentifier()) {
+            if (tryExpand(tok))
+                continue;
+            // Macros suppressed now stay suppressed after substitution.
+            if (isActive(findMacro(tok.getIdentifier())))
+                tok.noExpand = true;
+        }
+        arg.push_back(std::move(tok));
+    }
+
+    pending.swap(outerPending);
+}
+
+PPToken Preprocessor::instantiate(const PPToken &proto, const Location &loc)
+{
+    PPToken tok{proto.kind, nullptr, loc};
+    tok.noExpand = proto.noExpand;
+    if (proto.node) {
+        tok.node = AST::make(tyCtx, proto.node->getSymType(), loc,
+                             proto.node->getVariant());
+    }
+    return tok;
+}
+
+bool Preprocessor::isActive(const MacroDefinition *macro) const noexcept
+{
+    return macro != nullptr && std::find(activeMacros.begin(),
+                                         activeMacros.end(),
+                                         macro) != activeMacros.end();
+}
+
+} // namespace splc::IO
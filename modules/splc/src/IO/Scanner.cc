@@ -3,6 +3,7 @@
 #include "Core/Utils/Location.hh"
 #include "Core/Utils/Logging.hh"
 #include "Translation/TranslationContext.hh"
+#include <algorithm>
 #include <numeric>
 
 // *This file constitute only part of the definition of class
@@ -10,13 +11,35 @@
 
 namespace splc::IO {
 
+int Scanner::yylex(splc::IO::Parser::value_type *const yylval,
+                   splc::IO::Parser::location_type *yyloc)
+{
+    return preprocessor.lex(yylval, yyloc);
+}
+
 int Scanner::yywrap()
 {
+    if (tokenizeOnly)
+        return 1;
+
+    Ptr<TranslationContext> context;
     if (!transMgr.transCtxStackEmpty()) {
-        Ptr<TranslationContext> context = transMgr.popTransContext();
+        context = transMgr.popTransContext();
     }
 
-    return transMgr.transCtxStackEmpty();
+    if (transMgr.transCtxStackEmpty())
+        return 1;
+
+    // Resume the interrupted buffer. Switching buffers here prevents flex from
+    // restarting the exhausted one.
+    yypop_buffer_state();
+    yy_pop_state();
+
+    if (context->bufferType == TranslationContextBufferType::File) {
+        *gloc = context->intrLocation;
+        gloc->switchToContext(transMgr.getCurTransCtxKey());
+    }
+    return 0;
 }
 
 bool Scanner::setInitialContext(Ptr<TranslationContext> initialContext)
@@ -32,25 +55,20 @@ bool Scanner::pushFileContext(const Location *intrLoc_,
                               std::string_view fileName_)
 {
     try {
-        Ptr<TranslationContext> context =
-            transMgr.pushTransFileContext(intrLoc_, fileName_);
+        Ptr<TranslationContext> context = transMgr.pushTransFileContext(
+            intrLoc_, fileName_, [this](std::string_view name) {
+                return preprocessor.isMacroDefined(name);
+            });
+        if (!context) {
+            // Skipped by include guard or `#pragma once`
+            return false;
+        }
 
         pushInternalBuffer(context);
-        return true;
-    }
-    catch (SemanticError &e) {
-        SPLC_LOG_ERROR(intrLoc_, true) << e.what();
-    }
-    return false;
-}
 
-bool Scanner::pushMacroVarContext(const Location *intrLoc_,
-                                  std::string_view macroVarName_)
-{
-    try {
-        Ptr<TranslationContext> context =
-            transMgr.pushTransMacroVarContext(intrLoc_, macroVarName_);
-        pushInternalBuffer(context);
+        // Locations inside the included file start from its first line.
+        *gloc = Location{};
+        gloc->switchToContext(context->getKey());
         return true;
     }
     catch (SemanticError &e) {
@@ -65,43 +83,10 @@ bool Scanner::isContextPresent(TranslationContextBufferType type_,
     return transMgr.isContextExistInStack(type_, contextName_);
 }
 
-bool Scanner::isMacroVarContextPresent(
-    std::string_view macroVarName_) const noexcept
-{
-    return transMgr.isTransMacroVarPresent(macroVarName_);
-}
-
-bool Scanner::registerMacroVarContext(const Location *regLocation,
-                                      std::string_view macroVarName_,
-                                      std::string_view content_)
-{
-    try {
-        return transMgr.registerTransMacroVarContext(regLocation, macroVarName_,
-                                                     content_) != nullptr;
-    }
-    catch (SemanticError &e) {
-        SPLC_LOG_ERROR(regLocation, true) << e.what();
-        if (e.loc)
-            SPLC_LOG_NOTE(&e.loc, false) << "previously defined here";
-        return false;
-    }
-}
-
-bool Scanner::unregisterMacroVarContext(const Location *unRegLoc,
-                                        std::string_view macroVarName_)
-{
-    try {
-        return transMgr.unregisterTransMacroVarContext(
-                   unRegLoc, macroVarName_) != nullptr;
-    }
-    catch (SemanticError &e) {
-        SPLC_LOG_ERROR(unRegLoc, true) << e.what();
-        return false;
-    }
-}
-
 void Scanner::pushInternalBuffer(Ptr<TranslationContext> context)
 {
+    // flex refills the buffer from the stream in chunks, so that the memory
+    // taken by an input does not grow with its size.
     yy_buffer_state *state =
         yy_create_buffer(context->inputStream.get(), SPLC_BUF_SIZE);
     yypush_buffer_state(state);
@@ -1,273 +1,239 @@
 #include "SIR/IR.hh"
 
+#include <sstream>
+
 namespace splc::SIR {
 
 //===----------------------------------------------------------------------===//
-//                             IRVar Implementation
+//                         IRFunction Implementation
 //===----------------------------------------------------------------------===//
-// Create IRVar
-
-PtrIRVar IRVar::createLabel(IRIDType name)
-{
-    return makeSharedPtr<IRVar>(name, IRVarType::Label);
-}
-
-PtrIRVar IRVar::createFunction(IRIDType name, Type *type)
-{
-    return makeSharedPtr<IRVar>(name, IRVarType::Function, type);
-}
-
-PtrIRVar IRVar::createVariable(IRIDType name, Type *type)
-{
-    return makeSharedPtr<IRVar>(name, IRVarType::Variable, type);
-}
-
-PtrIRVar IRVar::createConstant(Type *type, ASTValueType val)
-{
-    if (std::holds_alternative<ASTUIntType>(val)) {
-        val = static_cast<ASTSIntType>(std::get<ASTUIntType>(val));
-    }
-    return makeSharedPtr<IRVar>("", IRVarType::Constant, type, val, true);
-}
+// Create IR Function
 
-std::string IRVar::getName() const noexcept
+Ptr<IRFunction> IRFunction::create(IRIDType name_, Type *retTy_)
 {
-    if ((irVarType == IRVarType::Variable && isConstant) ||
-        irVarType == IRVarType::Constant) {
-        if (holdsValueType<ASTSIntType>()) {
-            return "#" + std::to_string(getValue<ASTSIntType>());
-        }
-        else if (holdsValueType<ASTUIntType>()) {
-
-            return "#" + std::to_string(getValue<ASTUIntType>());
-        }
-        else if (holdsValueType<ASTIDType>()) {
-
-            return getValue<ASTIDType>();
-        }
-    }
-    return name;
+    return makeSharedPtr<IRFunction>(name_, retTy_);
 }
 
 //===----------------------------------------------------------------------===//
-//                             IRStmt Implementation
-//===----------------------------------------------------------------------===//
-// Create IRStmt
-
-PtrIRStmt IRStmt::createLabelStmt(PtrIRVar op)
-{
-    op->setUsed();
-    return makeSharedPtr<IRStmt>(IRType::SetLabel, op);
-}
-
-PtrIRStmt IRStmt::createFuncDeclStmt(PtrIRVar op)
-{
-    op->setUsed();
-    return makeSharedPtr<IRStmt>(IRType::FuncDecl, op);
-}
-
-PtrIRStmt IRStmt::createAssignStmt(PtrIRVar lhs, PtrIRVar rhs)
-{
-    rhs->setUsed();
-    return makeSharedPtr<IRStmt>(IRType::Assign, lhs, rhs);
-}
-
-PtrIRStmt IRStmt::createArithmeticStmt(IRType irType, PtrIRVar op1,
-                                       PtrIRVar op2, PtrIRVar op3)
-{
-    op2->setUsed();
-    op3->setUsed();
-    return makeSharedPtr<IRStmt>(irType, op1, op2, op3);
-}
-
-PtrIRStmt IRStmt::createAddrOfStmt(PtrIRVar op1, PtrIRVar op2)
-{
-    op2->setUsed();
-    return makeSharedPtr<IRStmt>(IRType::AddrOf, op1, op2);
-}
-
-PtrIRStmt IRStmt::createDerefStmt(PtrIRVar op1, PtrIRVar op2)
-{
-    op2->setUsed();
-    return makeSharedPtr<IRStmt>(IRType::Deref, op1, op2);
-}
-
-PtrIRStmt IRStmt::createCopyToAddrStmt(PtrIRVar op1, PtrIRVar op2)
-{
-    op2->setUsed();
-    return makeSharedPtr<IRStmt>(IRType::CopyToAddr, op1, op2);
-}
-
-PtrIRStmt IRStmt::createGotoStmt(PtrIRVar op)
-{
-    op->setUsed();
-    return makeSharedPtr<IRStmt>(IRType::Goto, op);
-}
-
-PtrIRStmt IRStmt::createBranchIfStmt(IRBranchType branchType, PtrIRVar lhs,
-                                     PtrIRVar rhs, PtrIRVar label)
-{
-    lhs->setUsed();
-    rhs->setUsed();
-    return makeSharedPtr<IRStmt>(IRType::BranchIf, lhs, rhs, label, branchType);
-}
-
-PtrIRStmt IRStmt::createReturnStmt(PtrIRVar op)
-{
-    op->setUsed();
-    return makeSharedPtr<IRStmt>(IRType::Return, op);
-}
+// Operand Tables
 
-PtrIRStmt IRStmt::createAllocStmt(PtrIRVar op1, PtrIRVar op2)
+IRNameID IRFunction::internName(StrRef str)
 {
-    op1->setUsed();
-    op2->setUsed();
-    return makeSharedPtr<IRStmt>(IRType::Alloc, op1, op2);
+    if (auto it = nameMap.find(str); it != nameMap.end())
+        return it->second;
+    splc_assert(names.size() <= IROperand::maxIndex)
+        << "too many names in function " << name;
+    IRNameID id = static_cast<IRNameID>(names.size());
+    const std::string &stored = names.emplace_back(str);
+    nameMap.emplace(stored, id);
+    return id;
 }
 
-PtrIRStmt IRStmt::createPopCallArgStmt(PtrIRVar op)
+IROperand IRFunction::createVariable(IRNameID prefix, uint32_t number,
+                                     Type *type)
 {
-    op->setUsed();
-    return makeSharedPtr<IRStmt>(IRType::PopCallArg, op);
+    splc_assert(vars.size() <= IROperand::maxIndex)
+        << "too many variables in function " << name;
+    vars.push_back(IRSymbol{prefix, number, type});
+    return IROperand{IROperand::Kind::Variable,
+                     static_cast<uint32_t>(vars.size() - 1)};
 }
 
-PtrIRStmt IRStmt::createPushCallArgStmt(PtrIRVar op)
+IROperand IRFunction::createLabel(IRNameID prefix, uint32_t number)
 {
-    op->setUsed();
-    return makeSharedPtr<IRStmt>(IRType::PushCallArg, op);
+    splc_assert(labels.size() <= IROperand::maxIndex)
+        << "too many labels in function " << name;
+    labels.push_back(IRSymbol{prefix, number, nullptr});
+    return IROperand{IROperand::Kind::Label,
+                     static_cast<uint32_t>(labels.size() - 1)};
 }
 
-PtrIRStmt IRStmt::createInvokeFuncStmt(PtrIRVar lhs, PtrIRVar func)
+IROperand IRFunction::getConstant(ASTSIntType value)
 {
-    func->setUsed();
-    return makeSharedPtr<IRStmt>(IRType::InvokeFunc, lhs, func);
+    auto [it, inserted] = constantMap.try_emplace(
+        value, static_cast<uint32_t>(constants.size()));
+    if (inserted) {
+        splc_assert(constants.size() <= IROperand::maxIndex)
+            << "too many constants in function " << name;
+        constants.push_back(value);
+    }
+    return IROperand{IROperand::Kind::Constant, it->second};
 }
 
-PtrIRStmt IRStmt::createReadStmt(PtrIRVar op)
+void IRFunction::writeOperand(std::ostream &os, IROperand op) const
 {
-    op->setUsed();
-    return makeSharedPtr<IRStmt>(IRType::Read, op);
+    auto writeSymbol = [&](const IRSymbol &sym) {
+        os << names[sym.prefix];
+        if (sym.number != IRSymbol::noNumber)
+            os << sym.number;
+    };
+
+    switch (op.getKind()) {
+    case IROperand::Kind::Variable: {
+        writeSymbol(vars[op.getIndex()]);
+        break;
+    }
+    case IROperand::Kind::Label: {
+        writeSymbol(labels[op.getIndex()]);
+        break;
+    }
+    case IROperand::Kind::Constant: {
+        os << "#" << constants[op.getIndex()];
+        break;
+    }
+    case IROperand::Kind::Function: {
+        os << names[op.getIndex()];
+        break;
+    }
+    case IROperand::Kind::None: {
+        splc_error() << "writing an empty operand";
+        break;
+    }
+    }
 }
 
-PtrIRStmt IRStmt::createWriteStmt(PtrIRVar op)
+std::string IRFunction::getOperandName(IROperand op) const
 {
-    op->setUsed();
-    return makeSharedPtr<IRStmt>(IRType::Write, op);
+    std::ostringstream oss;
+    writeOperand(oss, op);
+    return oss.str();
 }
 
-void IRStmt::assignmentToArithmetic(IRStmt *stmtAssign,
-                                    IRStmt *stmtArith) noexcept
-{
-    // TODO
-    auto resVar = stmtAssign->op1;
-    *stmtAssign = *stmtArith;
-    stmtAssign->op1 = resVar;
-}
+//===----------------------------------------------------------------------===//
+// Statements
 
-void IRStmt::concatAssign(IRStmt *stmtTail, IRStmt *stmtHead) noexcept
+IRStmtID IRFunction::createStmt(IRType irType, IROperand op1, IROperand op2,
+                                 IROperand op3, IRBranchType branchType)
 {
-    // TODO
-    auto resVar = stmtTail->op1;
-    *stmtTail = *stmtHead;
-    stmtTail->op1 = resVar;
+    IRStmtID id = static_cast<IRStmtID>(stmtTypes.size());
+    stmtTypes.push_back(irType);
+    stmtBranchTypes.push_back(branchType);
+    stmtOp1s.push_back(op1);
+    stmtOp2s.push_back(op2);
+    stmtOp3s.push_back(op3);
+    return id;
 }
 
-void IRStmt::arithmeticToConstAssign(IRStmt *stmtArith, IRVar *cVar1,
-                                     IRVar *cVar2) noexcept
+void IRFunction::compact()
 {
-    // TODO
-    if (cVar1->isConst() && cVar2->isConst()) {
-        ASTSIntType val = 0;
-
-        switch (stmtArith->irType) {
-        case IRType::Plus: {
-            val =
-                cVar1->getValue<ASTSIntType>() + cVar2->getValue<ASTSIntType>();
-            break;
-        }
-        case IRType::Minus: {
-            val =
-                cVar1->getValue<ASTSIntType>() - cVar2->getValue<ASTSIntType>();
-            break;
-        }
-        case IRType::Mul: {
-            val =
-                cVar1->getValue<ASTSIntType>() * cVar2->getValue<ASTSIntType>();
-            break;
-        }
-        case IRType::Div: {
-            val =
-                cVar1->getValue<ASTSIntType>() / cVar2->getValue<ASTSIntType>();
-            break;
-        }
-        default:
-            return;
-        }
-        auto tmpRes = IRVar::createConstant(stmtArith->op1->valType, val);
-        *stmtArith = *createAssignStmt(stmtArith->op1, tmpRes);
+    size_t numStmts = body.size();
+    IRVec<IRType> newTypes(numStmts);
+    IRVec<IRBranchType> newBranchTypes(numStmts);
+    IRVec<IROperand> newOp1s(numStmts), newOp2s(numStmts), newOp3s(numStmts);
+    std::unordered_map<IRStmtID, IRVec<IRPhiArg>> newPhiArgs;
+
+    for (IRStmtID newID = 0; newID < numStmts; ++newID) {
+        IRStmtID oldID = body[newID];
+        newTypes[newID] = stmtTypes[oldID];
+        newBranchTypes[newID] = stmtBranchTypes[oldID];
+        newOp1s[newID] = stmtOp1s[oldID];
+        newOp2s[newID] = stmtOp2s[oldID];
+        newOp3s[newID] = stmtOp3s[oldID];
+        if (auto it = phiArgs.find(oldID); it != phiArgs.end())
+            newPhiArgs.emplace(newID, std::move(it->second));
+        body[newID] = newID;
     }
+
+    stmtTypes = std::move(newTypes);
+    stmtBranchTypes = std::move(newBranchTypes);
+    stmtOp1s = std::move(newOp1s);
+    stmtOp2s = std::move(newOp2s);
+    stmtOp3s = std::move(newOp3s);
+    phiArgs = std::move(newPhiArgs);
 }
 
 //===----------------------------------------------------------------------===//
-//                         IRFunction Implementation
+//                          IRStmtRef Implementation
 //===----------------------------------------------------------------------===//
-// Create IR Function
 
-Ptr<IRFunction> IRFunction::create(IRIDType name_, Type *retTy_)
+IROperand *IRStmtRef::getDefOperand() const noexcept
 {
-    return makeSharedPtr<IRFunction>(name_, retTy_);
+    switch (getIRType()) {
+    case IRType::Assign:
+    case IRType::Plus:
+    case IRType::Minus:
+    case IRType::Mul:
+    case IRType::Div:
+    case IRType::AddrOf:
+    case IRType::Deref:
+    case IRType::PopCallArg:
+    case IRType::InvokeFunc:
+    case IRType::Read:
+    case IRType::Phi:
+        return &op1();
+    default:
+        return nullptr;
+    }
 }
 
-std::ostream &operator<<(std::ostream &os, const IRStmt &stmt) noexcept
+std::ostream &operator<<(std::ostream &os, const IRStmtRef &stmt) noexcept
 {
-    switch (stmt.irType) {
+    const IRFunction &func = stmt.getFunction();
+    auto w = [&](IROperand op) -> std::ostream & {
+        func.writeOperand(os, op);
+        return os;
+    };
+
+    switch (stmt.getIRType()) {
     case IRType::SetLabel: {
-        os << "LABEL " << stmt.op1->getName() << " :";
+        os << "LABEL ";
+        w(stmt.op1()) << " :";
         break;
     }
     case IRType::Assign: {
-        os << stmt.op1->getName() << " := " << stmt.op2->getName();
+        w(stmt.op1()) << " := ";
+        w(stmt.op2());
         break;
     }
     case IRType::Plus: {
-        os << stmt.op1->getName() << " := " << stmt.op2->getName() << " + "
-           << stmt.op3->getName();
+        w(stmt.op1()) << " := ";
+        w(stmt.op2()) << " + ";
+        w(stmt.op3());
         break;
     }
     case IRType::Minus: {
-        os << stmt.op1->getName() << " := " << stmt.op2->getName() << " - "
-           << stmt.op3->getName();
+        w(stmt.op1()) << " := ";
+        w(stmt.op2()) << " - ";
+        w(stmt.op3());
         break;
     }
     case IRType::Mul: {
-        os << stmt.op1->getName() << " := " << stmt.op2->getName() << " * "
-           << stmt.op3->getName();
+        w(stmt.op1()) << " := ";
+        w(stmt.op2()) << " * ";
+        w(stmt.op3());
         break;
     }
     case IRType::Div: {
-        os << stmt.op1->getName() << " := " << stmt.op2->getName() << " / "
-           << stmt.op3->getName();
+        w(stmt.op1()) << " := ";
+        w(stmt.op2()) << " / ";
+        w(stmt.op3());
         break;
     }
     case IRType::AddrOf: {
-        os << stmt.op1->getName() << " := &" << stmt.op2->getName() << "";
+        w(stmt.op1()) << " := &";
+        w(stmt.op2());
         break;
     }
     case IRType::Deref: {
-        os << stmt.op1->getName() << " := *" << stmt.op2->getName();
+        w(stmt.op1()) << " := *";
+        w(stmt.op2());
         break;
     }
     case IRType::CopyToAddr: {
-        os << "*" << stmt.op1->getName() << " := " << stmt.op2->getName();
+        os << "*";
+        w(stmt.op1()) << " := ";
+        w(stmt.op2());
         break;
     }
     case IRType::Goto: {
-        os << "GOTO " << stmt.op1->getName();
+        os << "GOTO ";
+        w(stmt.op1());
         break;
     }
     case IRType::BranchIf: {
-        os << "IF " << stmt.op1->getName() << " ";
-        switch (stmt.branchType) {
+        os << "IF ";
+        w(stmt.op1()) << " ";
+        switch (stmt.getBranchType()) {
         case IRBranchType::None: {
             splc_error();
             break;
@@ -297,35 +263,55 @@ std::ostream &operator<<(std::ostream &os, const IRStmt &stmt) noexcept
             break;
         }
         }
-        os << " " << stmt.op2->getName() << " GOTO " << stmt.op3->getName();
+        os << " ";
+        w(stmt.op2()) << " GOTO ";
+        w(stmt.op3());
         break;
     }
     case IRType::Return: {
-        os << "RETURN " << stmt.op1->getName();
+        os << "RETURN ";
+        w(stmt.op1());
         break;
     }
     case IRType::Alloc: {
-        os << "DEC " << stmt.op1->getName() << " " << stmt.op2->getName();
+        os << "DEC ";
+        w(stmt.op1()) << " ";
+        w(stmt.op2());
         break;
     }
     case IRType::PopCallArg: {
-        os << "PARAM " << stmt.op1->getName();
+        os << "PARAM ";
+        w(stmt.op1());
         break;
     }
     case IRType::PushCallArg: {
-        os << "ARG " << stmt.op1->getName();
+        os << "ARG ";
+        w(stmt.op1());
         break;
     }
     case IRType::InvokeFunc: {
-        os << stmt.op1->getName() << " := CALL " << stmt.op2->getName();
+        w(stmt.op1()) << " := CALL ";
+        w(stmt.op2());
         break;
     }
     case IRType::Read: {
-        os << "READ " << stmt.op1->getName();
+        os << "READ ";
+        w(stmt.op1());
         break;
     }
     case IRType::Write: {
-        os << "WRITE " << stmt.op1->getName();
+        os << "WRITE ";
+        w(stmt.op1());
+        break;
+    }
+    case IRType::Phi: {
+        w(stmt.op1()) << " := PHI(";
+        auto &args = func.getPhiArgs(stmt.getID());
+        for (size_t i = 0; i < args.size(); ++i) {
+            os << (i ? ", " : "");
+            w(args[i].first);
+        }
+        os << ")";
         break;
     }
     case IRType::FuncDecl: {
@@ -343,10 +329,11 @@ std::ostream &operator<<(std::ostream &os, const IRStmt &stmt) noexcept
 std::ostream &operator<<(std::ostream &os, const IRFunction &func) noexcept
 {
     os << "FUNCTION " << func.name << " :\n";
-    for (auto stmt : func.body) {
-        os << *stmt << "\n";
+    auto &mutFunc = const_cast<IRFunction &>(func);
+    for (IRStmtID id : func.body) {
+        os << mutFunc.getStmt(id) << "\n";
     }
     return os;
 }
 
-} // namespace splc::SIR
\ No newline at end of file
+} // namespace splc::SIR
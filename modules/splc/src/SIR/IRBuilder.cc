@@ -4,18 +4,35 @@
 using namespace splc;
 using namespace splc::SIR;
 
-PtrIRVar IRBuilder::getTmpLabel()
+IROperand IRBuilder::getTmpLabel()
 {
-    return IRVar::createLabel("lb_" + std::to_string(allocCnt++));
+    return currentFunc->createLabel(tmpLabelPrefix, allocCnt++);
 }
 
-PtrIRVar IRBuilder::getTmpVar()
+IROperand IRBuilder::getTmpVar()
 {
-    return IRVar::createVariable("tmp_" + std::to_string(allocCnt++),
-                                 &tyCtx.SInt32Ty);
+    return currentFunc->createVariable(tmpVarPrefix, allocCnt++,
+                                       &tyCtx.SInt32Ty);
 }
 
-void IRBuilder::recRegisterDeclVar(IRVec<PtrIRStmt> &stmtList, PtrAST declRoot)
+IROperand IRBuilder::getConstant(const ASTValueType &val)
+{
+    if (std::holds_alternative<ASTSIntType>(val)) {
+        return currentFunc->getConstant(std::get<ASTSIntType>(val));
+    }
+    else if (std::holds_alternative<ASTUIntType>(val)) {
+        return currentFunc->getConstant(
+            static_cast<ASTSIntType>(std::get<ASTUIntType>(val)));
+    }
+    else if (std::holds_alternative<ASTCharType>(val)) {
+        return currentFunc->getConstant(std::get<ASTCharType>(val));
+    }
+    splc_error() << "only integer and character constants are supported in SIR";
+    splc_unreachable();
+}
+
+void IRBuilder::recRegisterDeclVar(IRVec<IRStmtID> &stmtList,
+                                   const PtrAST &declRoot)
 {
     if (declRoot->isDecl()) {
         recRegisterDeclVar(stmtList, declRoot->getChildren()[0]);
@@ -30,21 +47,22 @@ void IRBuilder::recRegisterDeclVar(IRVec<PtrIRStmt> &stmtList, PtrAST declRoot)
                                   ->getChildren()[0]
                                   ->getConstVal<IRIDType>();
 
-                auto it = currentFunc->varMap.find(id);
-                splc_dbgassert(it == currentFunc->varMap.end())
+                auto it = varMap.find(id);
+                splc_dbgassert(it == varMap.end())
                     << "redefinition of id in varMap: " << id;
-                PtrIRVar var = IRVar::createVariable(id, &tyCtx.SInt32Ty);
+                IROperand var =
+                    currentFunc->createVariable(id, &tyCtx.SInt32Ty);
 
-                currentFunc->varList.push_back(var);
-                currentFunc->varMap.insert({id, var});
+                varMap.insert({id, var});
                 SPLC_LOG_DEBUG(nullptr, false)
                     << "defined id in varMap: " << id;
 
                 // Process initializer, if any
                 if (initDecltr->getChildrenNum() == 3) {
-                    PtrIRVar init = recRegisterExprs(
+                    IROperand init = recRegisterExprs(
                         stmtList, initDecltr->getChildren()[2]);
-                    stmtList.push_back(IRStmt::createAssignStmt(var, init));
+                    stmtList.push_back(
+                        currentFunc->createAssignStmt(var, init));
                 }
             }
             else {
@@ -54,8 +72,8 @@ void IRBuilder::recRegisterDeclVar(IRVec<PtrIRStmt> &stmtList, PtrAST declRoot)
     }
 }
 
-PtrIRVar IRBuilder::recRegisterCallExpr(IRVec<PtrIRStmt> &stmtList,
-                                        PtrAST exprRoot)
+IROperand IRBuilder::recRegisterCallExpr(IRVec<IRStmtID> &stmtList,
+                                        const PtrAST &exprRoot)
 {
     IRIDType funcID =
         exprRoot->getChildren()[0]->getChildren()[0]->getConstVal<IRIDType>();
@@ -66,38 +84,40 @@ PtrIRVar IRBuilder::recRegisterCallExpr(IRVec<PtrIRStmt> &stmtList,
     // Read or Write function call
     if (funcID == "write") {
         SPLC_LOG_DEBUG(nullptr, false) << "write to terminal";
-        PtrIRVar arg = recRegisterExprs(stmtList, argAST->getChildren()[0]);
-        stmtList.push_back(IRStmt::createWriteStmt(arg));
-        return nullptr; // Nothing to return
+        IROperand arg = recRegisterExprs(stmtList, argAST->getChildren()[0]);
+        stmtList.push_back(currentFunc->createWriteStmt(arg));
+        return {}; // Nothing to return
     }
     else if (funcID == "read") {
         SPLC_LOG_DEBUG(nullptr, false) << "read from input";
-        PtrIRVar res = getTmpVar();
-        stmtList.push_back(IRStmt::createReadStmt(res));
+        IROperand res = getTmpVar();
+        stmtList.push_back(currentFunc->createReadStmt(res));
         return res;
     }
 
-    auto it = funcVarMap.find(funcID);
-    splc_dbgassert(it != funcVarMap.end());
-    PtrIRVar funcVar = it->second;
+    splc_dbgassert(funcMap.contains(funcID))
+        << "call to undefined function: " << funcID;
+    IROperand funcVar = currentFunc->getFunctionRef(funcID);
 
     // normal function call
-    PtrIRVar res = getTmpVar();
+    IROperand res = getTmpVar();
 
     for (auto &arg : argAST->getChildren()) {
-        PtrIRVar argVar = recRegisterExprs(stmtList, arg);
+        IROperand argVar = recRegisterExprs(stmtList, arg);
         SPLC_LOG_DEBUG(nullptr, false)
-            << "pushing call arg: " << argVar->getName();
-        stmtList.push_back(IRStmt::createPushCallArgStmt(argVar));
+            << "pushing call arg: "
+            << currentFunc->getOperandName(argVar);
+        stmtList.push_back(currentFunc->createPushCallArgStmt(argVar));
     }
 
     // CALL stmt
-    stmtList.push_back(IRStmt::createInvokeFuncStmt(res, funcVar));
+    stmtList.push_back(currentFunc->createInvokeFuncStmt(res, funcVar));
     return res;
 }
 
-void IRBuilder::recRegisterCondExpr(IRVec<PtrIRStmt> &stmtList, PtrAST stmtRoot,
-                                    PtrIRVar lbt, PtrIRVar lbf)
+void IRBuilder::recRegisterCondExpr(IRVec<IRStmtID> &stmtList,
+                                    const PtrAST &stmtRoot,
+                                    IROperand lbt, IROperand lbf)
 {
     auto &children = stmtRoot->getChildren();
     if (children.size() == 2 && children[0]->isOpNot()) {
@@ -142,23 +162,23 @@ void IRBuilder::recRegisterCondExpr(IRVec<PtrIRStmt> &stmtList, PtrAST stmtRoot,
             }
             }
 
-            PtrIRVar lhs = recRegisterExprs(stmtList, exprL);
-            PtrIRVar rhs = recRegisterExprs(stmtList, exprR);
+            IROperand lhs = recRegisterExprs(stmtList, exprL);
+            IROperand rhs = recRegisterExprs(stmtList, exprR);
 
             stmtList.push_back(
-                IRStmt::createBranchIfStmt(bType, lhs, rhs, lbt));
-            stmtList.push_back(IRStmt::createGotoStmt(lbf));
+                currentFunc->createBranchIfStmt(bType, lhs, rhs, lbt));
+            stmtList.push_back(currentFunc->createGotoStmt(lbf));
         }
         else if (opType == ASTSymType::OpAnd) {
-            PtrIRVar lb = getTmpLabel();
+            IROperand lb = getTmpLabel();
             recRegisterCondExpr(stmtList, exprL, lb, lbf);
-            stmtList.push_back(IRStmt::createLabelStmt(lb));
+            stmtList.push_back(currentFunc->createLabelStmt(lb));
             recRegisterCondExpr(stmtList, exprR, lbt, lbf);
         }
         else if (opType == ASTSymType::OpOr) {
-            PtrIRVar lb = getTmpLabel();
+            IROperand lb = getTmpLabel();
             recRegisterCondExpr(stmtList, exprL, lbt, lb);
-            stmtList.push_back(IRStmt::createLabelStmt(lb));
+            stmtList.push_back(currentFunc->createLabelStmt(lb));
             recRegisterCondExpr(stmtList, exprR, lbt, lbf);
         }
         else {
@@ -167,8 +187,8 @@ void IRBuilder::recRegisterCondExpr(IRVec<PtrIRStmt> &stmtList, PtrAST stmtRoot,
     }
 }
 
-PtrIRVar IRBuilder::recRegisterExprs(IRVec<PtrIRStmt> &stmtList,
-                                     PtrAST exprRoot)
+IROperand IRBuilder::recRegisterExprs(IRVec<IRStmtID> &stmtList,
+                                     const PtrAST &exprRoot)
 {
     if (exprRoot->isCallExpr()) {
         return recRegisterCallExpr(stmtList, exprRoot);
@@ -183,12 +203,11 @@ PtrIRVar IRBuilder::recRegisterExprs(IRVec<PtrIRStmt> &stmtList,
             return recRegisterExprs(stmtList, child);
         }
         case ASTSymType::Constant: {
-            return IRVar::createConstant(&tyCtx.SInt32Ty,
-                                         child->getChildren()[0]->getVariant());
+            return getConstant(child->getChildren()[0]->getVariant());
         }
         case ASTSymType::ID: {
-            auto it = currentFunc->varMap.find(child->getConstVal<IRIDType>());
-            splc_dbgassert(it != currentFunc->varMap.end());
+            auto it = varMap.find(child->getConstVal<IRIDType>());
+            splc_dbgassert(it != varMap.end());
             return it->second;
         }
         default: {
@@ -197,13 +216,13 @@ PtrIRVar IRBuilder::recRegisterExprs(IRVec<PtrIRStmt> &stmtList,
         }
     }
     else if (exprRoot->getChildrenNum() == 2) {
-        IRVec<PtrAST> children = exprRoot->getChildren();
+        auto &children = exprRoot->getChildren();
         if (children[0]->isOpMinus()) {
-            PtrIRVar var = recRegisterExprs(stmtList, children[1]);
-            PtrIRVar zero = IRVar::createConstant(&tyCtx.SInt32Ty, 0ULL);
-            PtrIRVar res = getTmpVar();
-            PtrIRStmt stmt =
-                IRStmt::createArithmeticStmt(IRType::Minus, res, zero, var);
+            IROperand var = recRegisterExprs(stmtList, children[1]);
+            IROperand zero = currentFunc->getConstant(0);
+            IROperand res = getTmpVar();
+            IRStmtID stmt = currentFunc->createArithmeticStmt(
+                IRType::Minus, res, zero, var);
             stmtList.push_back(stmt);
             return res;
         }
@@ -216,13 +235,13 @@ PtrIRVar IRBuilder::recRegisterExprs(IRVec<PtrIRStmt> &stmtList,
         PtrAST exprL = exprRoot->getChildren()[0];
         PtrAST exprR = exprRoot->getChildren()[2];
 
-        PtrIRVar lhs = recRegisterExprs(stmtList, exprL);
-        PtrIRVar rhs = recRegisterExprs(stmtList, exprR);
+        IROperand lhs = recRegisterExprs(stmtList, exprL);
+        IROperand rhs = recRegisterExprs(stmtList, exprR);
 
         if (op->isOpAssign()) {
             splc_dbgassert(exprL->getChildren()[0]->getSymType() ==
                            ASTSymType::ID);
-            stmtList.push_back(IRStmt::createAssignStmt(lhs, rhs));
+            stmtList.push_back(currentFunc->createAssignStmt(lhs, rhs));
             return lhs;
         }
         else if (op->isSymTypeOneOf(ASTSymType::OpPlus, ASTSymType::OpMinus,
@@ -249,28 +268,28 @@ PtrIRVar IRBuilder::recRegisterExprs(IRVec<PtrIRStmt> &stmtList,
                 splc_error();
             }
             }
-            PtrIRVar res = getTmpVar();
-            stmtList.push_back(
-                IRStmt::createArithmeticStmt(arithmeticType, res, lhs, rhs));
+            IROperand res = getTmpVar();
+            stmtList.push_back(currentFunc->createArithmeticStmt(
+                arithmeticType, res, lhs, rhs));
             return res;
         }
         else if (op->isSymTypeOneOf(ASTSymType::OpLT, ASTSymType::OpLE,
                                     ASTSymType::OpGT, ASTSymType::OpGE,
                                     ASTSymType::OpEQ, ASTSymType::OpNE,
                                     ASTSymType::OpAnd, ASTSymType::OpOr)) {
-            PtrIRVar lb1 = getTmpLabel();
-            PtrIRVar lb2 = getTmpLabel();
+            IROperand lb1 = getTmpLabel();
+            IROperand lb2 = getTmpLabel();
 
             // TODO: optimize
             // Treat True as 1 and False as 0
-            PtrIRVar condResVar = getTmpVar();
-            stmtList.push_back(IRStmt::createAssignStmt(
-                condResVar, IRVar::createConstant(&tyCtx.SInt32Ty, 0)));
+            IROperand condResVar = getTmpVar();
+            stmtList.push_back(currentFunc->createAssignStmt(
+                condResVar, currentFunc->getConstant(0)));
             recRegisterCondExpr(stmtList, exprRoot, lb1, lb2);
-            stmtList.push_back(IRStmt::createLabelStmt(lb1));
-            stmtList.push_back(IRStmt::createAssignStmt(
-                condResVar, IRVar::createConstant(&tyCtx.SInt32Ty, 1)));
-            stmtList.push_back(IRStmt::createLabelStmt(lb2));
+            stmtList.push_back(currentFunc->createLabelStmt(lb1));
+            stmtList.push_back(currentFunc->createAssignStmt(
+                condResVar, currentFunc->getConstant(1)));
+            stmtList.push_back(currentFunc->createLabelStmt(lb2));
             return condResVar;
         }
         else {
@@ -283,20 +302,21 @@ PtrIRVar IRBuilder::recRegisterExprs(IRVec<PtrIRStmt> &stmtList,
     splc_unreachable();
 }
 
-void IRBuilder::recRegisterIterStmt(IRVec<PtrIRStmt> &stmtList, PtrAST stmtRoot)
+void IRBuilder::recRegisterIterStmt(IRVec<IRStmtID> &stmtList,
+                                    const PtrAST &stmtRoot)
 {
     // CHECK: WHILE
     // KwdWhile Expr Stmt
-    IRVec<PtrAST> children = stmtRoot->getChildren();
+    auto &children = stmtRoot->getChildren();
     splc_dbgassert(children[0]->getSymType() == ASTSymType::KwdWhile);
 
     // TODO: reverse op to optimize
-    PtrIRVar lb1 = getTmpLabel();
-    PtrIRStmt lbSt1 = IRStmt::createLabelStmt(lb1);
-    PtrIRVar lb2 = getTmpLabel();
-    PtrIRStmt lbSt2 = IRStmt::createLabelStmt(lb2);
-    PtrIRVar lb3 = getTmpLabel();
-    PtrIRStmt lbSt3 = IRStmt::createLabelStmt(lb3);
+    IROperand lb1 = getTmpLabel();
+    IRStmtID lbSt1 = currentFunc->createLabelStmt(lb1);
+    IROperand lb2 = getTmpLabel();
+    IRStmtID lbSt2 = currentFunc->createLabelStmt(lb2);
+    IROperand lb3 = getTmpLabel();
+    IRStmtID lbSt3 = currentFunc->createLabelStmt(lb3);
 
     stmtList.push_back(lbSt1);
 
@@ -306,20 +326,21 @@ void IRBuilder::recRegisterIterStmt(IRVec<PtrIRStmt> &stmtList, PtrAST stmtRoot)
     stmtList.push_back(lbSt2);
     PtrAST body = children[2];
     recRegisterStmts(stmtList, body);
-    stmtList.push_back(IRStmt::createGotoStmt(lb1));
+    stmtList.push_back(currentFunc->createGotoStmt(lb1));
 
     stmtList.push_back(lbSt3);
 }
 
-void IRBuilder::recRegisterSelStmt(IRVec<PtrIRStmt> &stmtList, PtrAST stmtRoot)
+void IRBuilder::recRegisterSelStmt(IRVec<IRStmtID> &stmtList,
+                                   const PtrAST &stmtRoot)
 {
-    IRVec<PtrAST> children = stmtRoot->getChildren();
+    auto &children = stmtRoot->getChildren();
     splc_dbgassert(children[0]->isKwdIf());
 
-    PtrIRVar lb1 = getTmpLabel();
-    PtrIRStmt lbSt1 = IRStmt::createLabelStmt(lb1);
-    PtrIRVar lb2 = getTmpLabel();
-    PtrIRStmt lbSt2 = IRStmt::createLabelStmt(lb2);
+    IROperand lb1 = getTmpLabel();
+    IRStmtID lbSt1 = currentFunc->createLabelStmt(lb1);
+    IROperand lb2 = getTmpLabel();
+    IRStmtID lbSt2 = currentFunc->createLabelStmt(lb2);
 
     recRegisterCondExpr(stmtList, children[1], lb1, lb2);
     stmtList.push_back(lbSt1);
@@ -331,9 +352,9 @@ void IRBuilder::recRegisterSelStmt(IRVec<PtrIRStmt> &stmtList, PtrAST stmtRoot)
     }
     else if (children.size() == 5) {
         // KwdIf Expr Stmt1 KwdElse Stmt2
-        PtrIRVar lb3 = getTmpLabel();
-        PtrIRStmt lbSt3 = IRStmt::createLabelStmt(lb3);
-        stmtList.push_back(IRStmt::createGotoStmt(lb3));
+        IROperand lb3 = getTmpLabel();
+        IRStmtID lbSt3 = currentFunc->createLabelStmt(lb3);
+        stmtList.push_back(currentFunc->createGotoStmt(lb3));
         stmtList.push_back(lbSt2);
 
         recRegisterStmts(stmtList, children[4]);
@@ -344,16 +365,18 @@ void IRBuilder::recRegisterSelStmt(IRVec<PtrIRStmt> &stmtList, PtrAST stmtRoot)
     }
 }
 
-void IRBuilder::recRegisterJumpStmt(IRVec<PtrIRStmt> &stmtList, PtrAST stmtRoot)
+void IRBuilder::recRegisterJumpStmt(IRVec<IRStmtID> &stmtList,
+                                    const PtrAST &stmtRoot)
 {
-    IRVec<PtrAST> children = stmtRoot->getChildren();
+    auto &children = stmtRoot->getChildren();
     splc_dbgassert(children[0]->getSymType() == ASTSymType::KwdReturn &&
                    children.size() == 2);
-    PtrIRVar var = recRegisterExprs(stmtList, children[1]);
-    stmtList.push_back(IRStmt::createReturnStmt(var));
+    IROperand var = recRegisterExprs(stmtList, children[1]);
+    stmtList.push_back(currentFunc->createReturnStmt(var));
 }
 
-void IRBuilder::recRegisterStmts(IRVec<PtrIRStmt> &stmtList, PtrAST stmtRoot)
+void IRBuilder::recRegisterStmts(IRVec<IRStmtID> &stmtList,
+                                 const PtrAST &stmtRoot)
 {
     SPLC_LOG_DEBUG(nullptr, false) << "dispatch: " << stmtRoot->getSymType();
     if (isASTSymbolTypeOneOf(stmtRoot->getSymType(),
@@ -404,7 +427,7 @@ void IRBuilder::recRegisterStmts(IRVec<PtrIRStmt> &stmtList, PtrAST stmtRoot)
     }
 }
 
-void IRBuilder::registerFunction(PtrAST funcRoot)
+void IRBuilder::registerFunction(const PtrAST &funcRoot)
 {
     // Find function name (id)
     IRIDType funcID = funcRoot->getChildren()[1]
@@ -415,32 +438,26 @@ void IRBuilder::registerFunction(PtrAST funcRoot)
     // assume SInt32Ty
     Ptr<IRFunction> function = IRFunction::create(funcID, &tyCtx.SInt32Ty);
     currentFunc = function;
+    varMap.clear();
+    tmpVarPrefix = function->internName("tmp_");
+    tmpLabelPrefix = function->internName("lb_");
 
     // Find all params
     IRVec<IRIDType> paramIDs = IRBuilderHelper::recfindFuncParam(funcRoot);
 
-    IRVec<IRPair<IRIDType, PtrIRVar>> params;
-    params.reserve(paramIDs.size());
-
     // TODO (future): support more type
     for (auto &pid : paramIDs) {
-        params.emplace_back(pid, IRVar::createVariable(pid, &tyCtx.SInt32Ty));
-    }
-
-    // Push all parameters
-    for (auto &p : params) {
-        function->paramList.push_back(p.second);
+        IROperand param = function->createVariable(pid, &tyCtx.SInt32Ty);
+        function->paramList.push_back(param);
+        varMap.insert({pid, param});
     }
 
     for (auto &p : std::views::reverse(function->paramList)) {
-        function->body.push_back(IRStmt::createPopCallArgStmt(p));
+        function->body.push_back(function->createPopCallArgStmt(p));
     }
 
-    function->varMap.insert(params.begin(), params.end());
-
     // Insert to funcMap
     funcMap.insert({funcID, function});
-    funcVarMap.insert({funcID, IRVar::createFunction(funcID, &tyCtx.SInt32Ty)});
 
     // Register the body stmts
     PtrAST body = funcRoot->getChildren()[2];
@@ -451,7 +468,7 @@ void IRBuilder::registerFunction(PtrAST funcRoot)
     recRegisterStmts(function->body, body);
 }
 
-void IRBuilder::recParseAST(PtrAST parseRoot)
+void IRBuilder::recParseAST(const PtrAST &parseRoot)
 {
     if (parseRoot->isFuncDef()) {
         registerFunction(parseRoot);
@@ -0,0 +1,470 @@
+#include "SIR/IRCFG.hh"
+
+#include <algorithm>
+
+namespace splc::SIR {
+
+namespace {
+
+bool isTerminatorStmt(const IRStmtRef &stmt) noexcept
+{
+    return stmt.isGoto() || stmt.isBranchIf() || stmt.isReturn();
+}
+
+template <class T>
+bool contains(const IRVec<T> &vec, const T &val) noexcept
+{
+    return std::find(vec.begin(), vec.end(), val) != vec.end();
+}
+
+template <class T>
+void eraseValue(IRVec<T> &vec, const T &val) noexcept
+{
+    auto it = std::find(vec.begin(), vec.end(), val);
+    if (it != vec.end())
+        vec.erase(it);
+}
+
+} // namespace
+
+//===----------------------------------------------------------------------===//
+//                             IRSB Implementation
+//===----------------------------------------------------------------------===//
+
+IROperand IRSB::getLabel() const noexcept
+{
+    if (!stmts.empty() && getStmt(0).isSetLabel())
+        return getStmt(0).op1();
+    return {};
+}
+
+std::optional<IRStmtRef> IRSB::getTerminator() const noexcept
+{
+    if (stmts.empty())
+        return std::nullopt;
+    IRStmtRef last = getStmt(stmts.size() - 1);
+    if (!isTerminatorStmt(last))
+        return std::nullopt;
+    return last;
+}
+
+//===----------------------------------------------------------------------===//
+//                           IRDomTree Implementation
+//===----------------------------------------------------------------------===//
+
+void IRDomTree::recalculate(const IRCFG &cfg)
+{
+    size_t n = cfg.size();
+    rpo.clear();
+    rpoIndex.assign(n, unvisited);
+    idoms.assign(n, nullptr);
+    children.assign(n, {});
+    frontiers.assign(n, {});
+    dfsIn.assign(n, 0);
+    dfsOut.assign(n, 0);
+
+    // Postorder of the reachable blocks, without recursion
+    IRSB *entry = cfg.getEntry();
+    IRVec<bool> visited(n, false);
+    IRVec<IRPair<IRSB *, size_t>> stack;
+    stack.emplace_back(entry, 0);
+    visited[entry->id] = true;
+    while (!stack.empty()) {
+        auto &[bb, next] = stack.back();
+        if (next < bb->succs.size()) {
+            IRSB *succ = bb->succs[next++];
+            if (!visited[succ->id]) {
+                visited[succ->id] = true;
+                stack.emplace_back(succ, 0);
+            }
+        }
+        else {
+            rpo.push_back(bb);
+            stack.pop_back();
+        }
+    }
+    std::reverse(rpo.begin(), rpo.end());
+    for (size_t i = 0; i < rpo.size(); ++i)
+        rpoIndex[rpo[i]->id] = i;
+
+    // Immediate dominators. During the iteration, the entry is its own
+    // immediate dominator.
+    idoms[entry->id] = entry;
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (size_t i = 1; i < rpo.size(); ++i) {
+            IRSB *bb = rpo[i];
+            IRSB *newIDom = nullptr;
+            for (IRSB *pred : bb->preds) {
+                if (idoms[pred->id] == nullptr)
+                    continue;
+                newIDom = newIDom ? intersect(pred, newIDom) : pred;
+            }
+            if (idoms[bb->id] != newIDom) {
+                idoms[bb->id] = newIDom;
+                changed = true;
+            }
+        }
+    }
+
+    for (size_t i = 1; i < rpo.size(); ++i)
+        children[idoms[rpo[i]->id]->id].push_back(rpo[i]);
+
+    // Dominance frontiers: walk up from each predecessor of a join point
+    // until its immediate dominator is reached.
+    for (IRSB *bb : rpo) {
+        if (bb->preds.size() < 2)
+            continue;
+        for (IRSB *pred : bb->preds) {
+            if (!isReachable(pred))
+                continue;
+            for (IRSB *runner = pred; runner != idoms[bb->id];
+                 runner = idoms[runner->id]) {
+                auto &df = frontiers[runner->id];
+                if (df.empty() || df.back() != bb)
+                    df.push_back(bb);
+            }
+        }
+    }
+    idoms[entry->id] = nullptr;
+
+    // Number the dominator tree for constant-time `dominates` queries.
+    size_t clock = 0;
+    stack.clear();
+    stack.emplace_back(entry, 0);
+    dfsIn[entry->id] = clock++;
+    while (!stack.empty()) {
+        auto &[bb, next] = stack.back();
+        if (next < children[bb->id].size()) {
+            IRSB *child = children[bb->id][next++];
+            dfsIn[child->id] = clock++;
+            stack.emplace_back(child, 0);
+        }
+        else {
+            dfsOut[bb->id] = clock++;
+            stack.pop_back();
+        }
+    }
+}
+
+IRSB *IRDomTree::intersect(IRSB *a, IRSB *b) const noexcept
+{
+    while (a != b) {
+        while (rpoIndex[a->id] > rpoIndex[b->id])
+            a = idoms[a->id];
+        while (rpoIndex[b->id] > rpoIndex[a->id])
+            b = idoms[b->id];
+    }
+    return a;
+}
+
+//===----------------------------------------------------------------------===//
+//                             IRCFG Implementation
+//===----------------------------------------------------------------------===//
+
+void IRCFG::rebuild()
+{
+    blocks.clear();
+    labelMap.assign(func->getNumLabels(), nullptr);
+    domTreeValid = false;
+
+    IRSB *cur = nullptr;
+    for (IRStmtID id : func->body) {
+        IRStmtRef stmt = func->getStmt(id);
+        if (cur == nullptr || (stmt.isSetLabel() && !cur->stmts.empty()))
+            cur = insertBlock(blocks.size());
+        if (stmt.isSetLabel())
+            labelMap[stmt.op1().getIndex()] = cur;
+        cur->stmts.push_back(id);
+        if (isTerminatorStmt(stmt))
+            cur = nullptr;
+    }
+    if (blocks.empty())
+        insertBlock(0);
+
+    for (auto &bb : blocks) {
+        computeSuccessors(bb.get(), bb->succs);
+        for (IRSB *succ : bb->succs)
+            succ->preds.push_back(bb.get());
+    }
+
+    if (!getEntry()->preds.empty()) {
+        IRSB *entry = insertBlock(0);
+        IRSB *first = blocks[1].get();
+        entry->succs.push_back(first);
+        first->preds.push_back(entry);
+    }
+}
+
+void IRCFG::writeBack() const
+{
+    size_t numStmts = 0;
+    for (auto &bb : blocks)
+        numStmts += bb->stmts.size();
+
+    func->body.clear();
+    func->body.reserve(numStmts);
+    for (auto &bb : blocks)
+        func->body.insert(func->body.end(), bb->stmts.begin(),
+                          bb->stmts.end());
+}
+
+IRSB *IRCFG::findBlock(IROperand label) const
+{
+    IRSB *bb = label.getIndex() < labelMap.size()
+                   ? labelMap[label.getIndex()]
+                   : nullptr;
+    splc_assert(bb != nullptr) << "undefined label in " << func->name << ": "
+                               << func->getOperandName(label);
+    return bb;
+}
+
+const IRDomTree &IRCFG::getDomTree()
+{
+    if (!domTreeValid) {
+        domTree.recalculate(*this);
+        domTreeValid = true;
+    }
+    return domTree;
+}
+
+void IRCFG::insertStmt(IRSB *bb, size_t pos, IRStmtID stmt)
+{
+    splc_dbgassert(!func->getStmt(stmt).isSetLabel());
+    splc_dbgassert(pos <= bb->stmts.size() && pos >= bb->getFirstNonLabel());
+    bool atEnd = pos == bb->stmts.size();
+    splc_dbgassert(atEnd ? !bb->getTerminator()
+                         : !isTerminatorStmt(func->getStmt(stmt)));
+
+    bb->stmts.insert(bb->stmts.begin() + pos, stmt);
+    if (atEnd)
+        updateEdges(bb);
+}
+
+void IRCFG::eraseStmt(IRSB *bb, size_t pos)
+{
+    splc_dbgassert(pos < bb->stmts.size());
+    bool atEnd = pos + 1 == bb->stmts.size();
+    if (IRStmtRef stmt = bb->getStmt(pos); stmt.isSetLabel())
+        labelMap[stmt.op1().getIndex()] = nullptr;
+
+    bb->stmts.erase(bb->stmts.begin() + pos);
+    if (atEnd)
+        updateEdges(bb);
+}
+
+void IRCFG::replaceStmt(IRSB *bb, size_t pos, IRStmtID stmt)
+{
+    splc_dbgassert(pos < bb->stmts.size() && pos >= bb->getFirstNonLabel());
+    splc_dbgassert(!func->getStmt(stmt).isSetLabel());
+    bool atEnd = pos + 1 == bb->stmts.size();
+    splc_dbgassert(atEnd || !isTerminatorStmt(func->getStmt(stmt)));
+
+    bb->stmts[pos] = stmt;
+    if (atEnd)
+        updateEdges(bb);
+}
+
+void IRCFG::updateEdges(IRSB *bb)
+{
+    IRVec<IRSB *> newSuccs;
+    computeSuccessors(bb, newSuccs);
+    if (newSuccs == bb->succs)
+        return;
+
+    for (IRSB *succ : bb->succs) {
+        if (!contains(newSuccs, succ))
+            eraseValue(succ->preds, bb);
+    }
+    for (IRSB *succ : newSuccs) {
+        if (!contains(bb->succs, succ))
+            succ->preds.push_back(bb);
+    }
+    bb->succs = std::move(newSuccs);
+    domTreeValid = false;
+}
+
+IRSB *IRCFG::splitEdge(IRSB *from, IRSB *to)
+{
+    splc_dbgassert(contains(from->succs, to));
+
+    auto term = from->getTerminator();
+    IROperand *jumpTarget = nullptr;
+    if (term && term->isGoto())
+        jumpTarget = &term->op1();
+    else if (term && term->isBranchIf())
+        jumpTarget = &term->op3();
+    if (jumpTarget != nullptr && findBlock(*jumpTarget) != to)
+        jumpTarget = nullptr;
+
+    IRSB *mid = nullptr;
+    if (from->hasFallThrough() && getLayoutSuccessor(from) == to) {
+        // Falls through to `to`, which now follows it in the layout.
+        mid = insertBlock(from->id + 1);
+    }
+    else {
+        mid = insertBlock(findDetachedPosition());
+        mid->stmts.push_back(func->createGotoStmt(getOrCreateLabel(to)));
+    }
+    if (jumpTarget != nullptr)
+        *jumpTarget = getOrCreateLabel(mid);
+
+    std::replace(from->succs.begin(), from->succs.end(), to, mid);
+    std::replace(to->preds.begin(), to->preds.end(), from, mid);
+    mid->preds.push_back(from);
+    mid->succs.push_back(to);
+    return mid;
+}
+
+IROperand IRCFG::getOrCreateLabel(IRSB *bb)
+{
+    if (IROperand label = bb->getLabel())
+        return label;
+
+    // Numbering by the index into the label table keeps the names unique
+    // across the CFGs built for the same function.
+    IROperand label =
+        func->createLabel(labelPrefix, static_cast<uint32_t>(labelMap.size()));
+    bb->stmts.insert(bb->stmts.begin(), func->createLabelStmt(label));
+    labelMap.resize(func->getNumLabels(), nullptr);
+    labelMap[label.getIndex()] = bb;
+    return label;
+}
+
+size_t IRCFG::removeUnreachableBlocks()
+{
+    const IRDomTree &domTree_ = getDomTree();
+
+    // A reachable block never falls through to an unreachable one, so the
+    // fall-through edges of the remaining blocks are preserved.
+    size_t numRemoved = 0;
+    for (auto &bb : blocks) {
+        if (domTree_.isReachable(bb.get()))
+            continue;
+        for (IRSB *succ : bb->succs)
+            eraseValue(succ->preds, bb.get());
+        if (IROperand label = bb->getLabel())
+            labelMap[label.getIndex()] = nullptr;
+        bb.reset();
+        ++numRemoved;
+    }
+    if (numRemoved == 0)
+        return 0;
+
+    std::erase(blocks, nullptr);
+    renumberBlocks(0);
+    domTreeValid = false;
+    return numRemoved;
+}
+
+IRSB *IRCFG::insertBlock(size_t pos)
+{
+    auto it =
+        blocks.insert(blocks.begin() + pos, makeUniquePtr<IRSB>(*func, pos));
+    renumberBlocks(pos + 1);
+    domTreeValid = false;
+    return it->get();
+}
+
+size_t IRCFG::findDetachedPosition() const noexcept
+{
+    // Usually the last block returns, so this is found immediately. If every
+    // block falls through, the function falls off its end and the new block
+    // is placed there.
+    for (size_t i = blocks.size(); i > 0; --i) {
+        if (!blocks[i - 1]->hasFallThrough())
+            return i;
+    }
+    return blocks.size();
+}
+
+void IRCFG::renumberBlocks(size_t from) noexcept
+{
+    for (size_t i = from; i < blocks.size(); ++i)
+        blocks[i]->id = i;
+}
+
+void IRCFG::computeSuccessors(const IRSB *bb, IRVec<IRSB *> &succs) const
+{
+    succs.clear();
+    if (auto term = bb->getTerminator()) {
+        if (term->isGoto())
+            succs.push_back(findBlock(term->op1()));
+        else if (term->isBranchIf())
+            succs.push_back(findBlock(term->op3()));
+    }
+    if (bb->hasFallThrough()) {
+        IRSB *next = getLayoutSuccessor(bb);
+        if (next != nullptr && !contains(succs, next))
+            succs.push_back(next);
+    }
+}
+
+std::ostream &operator<<(std::ostream &os, const IRCFG &cfg)
+{
+    os << "CFG of " << cfg.func->name << ":\n";
+    for (auto &bb : cfg.blocks) {
+        os << "bb" << bb->id << ": preds =";
+        for (IRSB *pred : bb->preds)
+            os << " bb" << pred->id;
+        os << ", succs =";
+        for (IRSB *succ : bb->succs)
+            os << " bb" << succ->id;
+        os << "\n";
+        for (IRStmtID id : bb->stmts)
+            os << "    " << cfg.func->getStmt(id) << "\n";
+    }
+    return os;
+}
+
+//===----------------------------------------------------------------------===//
+//                          IRLoopInfo Implementation
+//===----------------------------------------------------------------------===//
+
+void IRLoopInfo::recalculate(IRCFG &cfg)
+{
+    loops.clear();
+    const IRDomTree &domTree = cfg.getDomTree();
+
+    for (IRSB *header : domTree.getReversePostOrder()) {
+        IRLoop loop;
+        loop.header = header;
+        for (IRSB *pred : header->preds) {
+            if (domTree.dominates(header, pred))
+                loop.latches.push_back(pred);
+        }
+        if (loop.latches.empty())
+            continue;
+
+        // Walk backwards from the latches, stopping at the header.
+        loop.blockSet.insert(header);
+        IRVec<IRSB *> worklist;
+        for (IRSB *latch : loop.latches) {
+            if (loop.blockSet.insert(latch).second)
+                worklist.push_back(latch);
+        }
+        while (!worklist.empty()) {
+            IRSB *bb = worklist.back();
+            worklist.pop_back();
+            for (IRSB *pred : bb->preds) {
+                if (domTree.isReachable(pred) &&
+                    loop.blockSet.insert(pred).second)
+                    worklist.push_back(pred);
+            }
+        }
+
+        for (auto &bb : cfg.getBlocks()) {
+            if (loop.blockSet.contains(bb.get()))
+                loop.blocks.push_back(bb.get());
+        }
+        loops.push_back(std::move(loop));
+    }
+
+    // A loop nested in another has fewer blocks.
+    std::ranges::stable_sort(loops, [](const IRLoop &a, const IRLoop &b) {
+        return a.blocks.size() < b.blocks.size();
+    });
+}
+
+} // namespace splc::SIR
@@ -0,0 +1,296 @@
+#include "SIR/IRInliner.hh"
+#include "SIR/IROptimizer.hh"
+
+#include <algorithm>
+#include <string>
+
+namespace splc::SIR {
+
+struct IRInliner::CallSite {
+    IRStmtID call{};
+    IRVec<size_t> argPositions{}; ///< Of the `ARG`s in the new body, in order
+    IRVec<IROperand> args{};
+};
+
+namespace {
+
+/// \return the size of `func` for the cost model, in which labels and
+/// parameters are free.
+size_t getInlineSize(IRFunction &func)
+{
+    return static_cast<size_t>(
+        std::ranges::count_if(func.body, [&](IRStmtID id) {
+            IRStmtRef stmt = func.getStmt(id);
+            return !stmt.isSetLabel() && !stmt.isPopCallArg();
+        }));
+}
+
+size_t getNumParams(IRFunction &func)
+{
+    return static_cast<size_t>(
+        std::ranges::count_if(func.body, [&](IRStmtID id) {
+            return func.getStmt(id).isPopCallArg();
+        }));
+}
+
+/// \brief Call `fn` with the name of the callee of each call in `func`.
+template <class Fn>
+void forEachCallee(IRFunction &func, Fn &&fn)
+{
+    for (IRStmtID id : func.body) {
+        if (IRStmtRef stmt = func.getStmt(id); stmt.isInvokeFunc())
+            fn(func.getFunctionName(stmt.op2()));
+    }
+}
+
+} // namespace
+
+void IRInliner::countCalls()
+{
+    callCounts.clear();
+    for (auto &[name, func] : program.funcMap) {
+        forEachCallee(*func,
+                      [&](StrRef callee) { ++callCounts[IRIDType{callee}]; });
+    }
+}
+
+IRVec<Ptr<IRFunction>> IRInliner::sortBottomUp()
+{
+    IRVec<Ptr<IRFunction>> funcs;
+    IRMap<IRIDType, size_t> indices;
+    for (auto &[name, func] : program.funcMap) {
+        indices[name] = funcs.size();
+        funcs.push_back(func);
+    }
+
+    IRVec<IRVec<size_t>> callees(funcs.size());
+    for (size_t i = 0; i < funcs.size(); ++i) {
+        forEachCallee(*funcs[i], [&](StrRef callee) {
+            if (auto it = indices.find(callee); it != indices.end())
+                callees[i].push_back(it->second);
+        });
+    }
+
+    // Tarjan's algorithm, which completes the strongly connected components
+    // of the callees before those of their callers.
+    constexpr size_t unvisited = static_cast<size_t>(-1);
+    IRVec<size_t> index(funcs.size(), unvisited);
+    IRVec<size_t> lowLink(funcs.size(), 0);
+    IRVec<bool> onStack(funcs.size(), false);
+    IRVec<size_t> stack;
+    IRVec<Ptr<IRFunction>> order;
+    size_t nextIndex = 0;
+
+    auto visit = [&](auto &self, size_t v) -> void {
+        index[v] = lowLink[v] = nextIndex++;
+        stack.push_back(v);
+        onStack[v] = true;
+        for (size_t w : callees[v]) {
+            if (index[w] == unvisited) {
+                self(self, w);
+                lowLink[v] = std::min(lowLink[v], lowLink[w]);
+            }
+            else if (onStack[w]) {
+                lowLink[v] = std::min(lowLink[v], index[w]);
+            }
+        }
+        if (lowLink[v] != index[v])
+            return;
+
+        IRVec<size_t> component;
+        size_t w;
+        do {
+            w = stack.back();
+            stack.pop_back();
+            onStack[w] = false;
+            component.push_back(w);
+        } while (w != v);
+
+        bool isRecursive = component.size() > 1 ||
+                           std::ranges::find(callees[v], v) != callees[v].end();
+        for (size_t u : component) {
+            recursive[funcs[u]->name] = isRecursive;
+            order.push_back(funcs[u]);
+        }
+    };
+    for (size_t v = 0; v < funcs.size(); ++v) {
+        if (index[v] == unvisited)
+            visit(visit, v);
+    }
+    return order;
+}
+
+void IRInliner::run()
+{
+    countCalls();
+    IRVec<Ptr<IRFunction>> order = sortBottomUp();
+
+    for (auto &func : order) {
+        if (inlineCallsIn(*func))
+            IROptimizer::constantPropagate(func);
+    }
+
+    // Functions only called from the calls just inlined are dead.
+    for (auto &func : order) {
+        auto it = callCounts.find(func->name);
+        if (it != callCounts.end() && it->second == 0 && func->name != "main")
+            program.funcMap.erase(func->name);
+    }
+}
+
+bool IRInliner::inlineCallsIn(IRFunction &caller)
+{
+    size_t callerSize = getInlineSize(caller);
+    bool changed = false;
+
+    IRVec<IRStmtID> newBody;
+    newBody.reserve(caller.body.size());
+    IRVec<size_t> argStack;
+    for (IRStmtID id : caller.body) {
+        IRStmtRef stmt = caller.getStmt(id);
+        if (stmt.isPushCallArg())
+            argStack.push_back(newBody.size());
+        if (!stmt.isInvokeFunc()) {
+            newBody.push_back(id);
+            continue;
+        }
+
+        auto it = program.funcMap.find(caller.getFunctionName(stmt.op2()));
+        if (it == program.funcMap.end() ||
+            argStack.size() < it->second->paramList.size()) {
+            newBody.push_back(id);
+            continue;
+        }
+
+        // The arguments of this call are the last ones pushed.
+        IRFunction &callee = *it->second;
+        CallSite site{id};
+        size_t numArgs = callee.paramList.size();
+        site.argPositions.assign(argStack.end() - numArgs, argStack.end());
+        argStack.resize(argStack.size() - numArgs);
+        for (size_t pos : site.argPositions)
+            site.args.push_back(caller.getStmt(newBody[pos]).op1());
+
+        if (!shouldInline(caller, callee, site, callerSize)) {
+            newBody.push_back(id);
+            continue;
+        }
+        callerSize += getInlineSize(callee);
+        inlineCall(caller, callee, site, newBody);
+        --callCounts[callee.name];
+        ++numInlined;
+        changed = true;
+    }
+
+    caller.body = std::move(newBody);
+    return changed;
+}
+
+bool IRInliner::shouldInline(IRFunction &caller, IRFunction &callee,
+                             const CallSite &site, size_t callerSize)
+{
+    if (&caller == &callee || recursive[callee.name])
+        return false;
+    size_t numArgs = site.argPositions.size();
+    if (getNumParams(callee) != numArgs)
+        return false;
+
+    size_t calleeSize = getInlineSize(callee);
+    if (callerSize + calleeSize > params.maxFunctionSize)
+        return false;
+
+    // The `ARG`s and `PARAM`s, the call and the return disappear.
+    long cost = static_cast<long>(calleeSize) - static_cast<long>(numArgs) - 2;
+    cost -= params.constantArgBonus *
+            std::ranges::count_if(site.args, &IROperand::isConstant);
+    if (callCounts[callee.name] == 1)
+        cost -= params.singleCallBonus;
+    return cost <= params.threshold;
+}
+
+void IRInliner::inlineCall(IRFunction &caller, IRFunction &callee,
+                           const CallSite &site, IRVec<IRStmtID> &newBody)
+{
+    // The label table only grows, so its size tells the inlined copies apart.
+    std::string prefix = callee.name + "_" +
+                         std::to_string(caller.getNumLabels()) + "_";
+    IROperand endLabel = caller.createLabel(prefix + "ret");
+
+    IRVec<IROperand> vars(callee.getNumVariables());
+    IRVec<IROperand> labels(callee.getNumLabels());
+    auto mapOperand = [&](IROperand op) -> IROperand {
+        switch (op.getKind()) {
+        case IROperand::Kind::Variable: {
+            IROperand &var = vars[op.getIndex()];
+            if (!var) {
+                const IRSymbol &sym = callee.getVariable(op);
+                IRNameID name = caller.internName(
+                    prefix + std::string{callee.getNameString(sym.prefix)});
+                var = caller.createVariable(name, sym.number, sym.type);
+            }
+            return var;
+        }
+        case IROperand::Kind::Label: {
+            IROperand &label = labels[op.getIndex()];
+            if (!label) {
+                const IRSymbol &sym = callee.getLabel(op);
+                IRNameID name = caller.internName(
+                    prefix + std::string{callee.getNameString(sym.prefix)});
+                label = caller.createLabel(name, sym.number);
+            }
+            return label;
+        }
+        case IROperand::Kind::Constant: {
+            return caller.getConstant(callee.getConstantValue(op));
+        }
+        case IROperand::Kind::Function: {
+            return caller.getFunctionRef(callee.getFunctionName(op));
+        }
+        case IROperand::Kind::None: {
+            break;
+        }
+        }
+        return op;
+    };
+
+    // The first `PARAM` pops the last `ARG`.
+    size_t numArgs = site.argPositions.size();
+    size_t paramIdx = 0;
+    for (IRStmtID id : callee.body) {
+        IRStmtRef stmt = callee.getStmt(id);
+        if (!stmt.isPopCallArg())
+            continue;
+        size_t argIdx = numArgs - 1 - paramIdx++;
+        newBody[site.argPositions[argIdx]] =
+            caller.createAssignStmt(mapOperand(stmt.op1()), site.args[argIdx]);
+    }
+
+    IROperand result = caller.getStmt(site.call).op1();
+    for (IRStmtID id : callee.body) {
+        IRStmtRef stmt = callee.getStmt(id);
+        switch (stmt.getIRType()) {
+        case IRType::PopCallArg: {
+            break;
+        }
+        case IRType::Return: {
+            if (result && stmt.op1())
+                newBody.push_back(
+                    caller.createAssignStmt(result, mapOperand(stmt.op1())));
+            newBody.push_back(caller.createGotoStmt(endLabel));
+            break;
+        }
+        default: {
+            if (stmt.isInvokeFunc())
+                ++callCounts[IRIDType{callee.getFunctionName(stmt.op2())}];
+            newBody.push_back(caller.createStmt(
+                stmt.getIRType(), mapOperand(stmt.op1()),
+                mapOperand(stmt.op2()), mapOperand(stmt.op3()),
+                stmt.getBranchType()));
+            break;
+        }
+        }
+    }
+    newBody.push_back(caller.createLabelStmt(endLabel));
+}
+
+} // namespace splc::SIR
@@ -0,0 +1,75 @@
+#include "SIR/IRLiveness.hh"
+
+namespace splc::SIR {
+
+void IRLiveness::findInMemoryVariables()
+{
+    IRFunction &func = *cfg.getFunction();
+    inMemory.assign(func.getNumVariables(), false);
+    for (auto &bb : cfg.getBlocks()) {
+        for (IRStmtID id : bb->stmts) {
+            IRStmtRef stmt = func.getStmt(id);
+            if (stmt.isAddrOf() && stmt.op2().isVariable())
+                inMemory[stmt.op2().getIndex()] = true;
+            else if (stmt.isAlloc() && stmt.op1().isVariable())
+                inMemory[stmt.op1().getIndex()] = true;
+        }
+    }
+}
+
+void IRLiveness::recalculate()
+{
+    findInMemoryVariables();
+    IRFunction &func = *cfg.getFunction();
+
+    size_t numBlocks = cfg.size();
+    size_t numVars = getNumVars();
+    IRVec<IRBitVector> uses(numBlocks, IRBitVector{numVars});
+    IRVec<IRBitVector> defs(numBlocks, IRBitVector{numVars});
+    liveIn.assign(numBlocks, IRBitVector{numVars});
+    liveOut.assign(numBlocks, IRBitVector{numVars});
+
+    // Upward-exposed uses and definitions of each block
+    for (auto &bb : cfg.getBlocks()) {
+        auto &use = uses[bb->id];
+        auto &def = defs[bb->id];
+        for (IRStmtID id : bb->stmts) {
+            IRStmtRef stmt = func.getStmt(id);
+            stmt.forEachUseOperand([&](IROperand &op) {
+                if (size_t i = getIndex(op); i != npos && !def.test(i))
+                    use.set(i);
+            });
+            if (IROperand *defOp = stmt.getDefOperand()) {
+                if (size_t i = getIndex(*defOp); i != npos)
+                    def.set(i);
+            }
+        }
+    }
+
+    // Visiting the blocks from the end of the layout propagates most values
+    // in the first iteration.
+    auto &blocks = cfg.getBlocks();
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (auto it = blocks.rbegin(); it != blocks.rend(); ++it) {
+            IRSB *bb = it->get();
+            auto &out = liveOut[bb->id];
+            for (IRSB *succ : bb->succs)
+                out.unionWith(liveIn[succ->id]);
+
+            // in = use | (out & ~def)
+            auto &in = liveIn[bb->id];
+            auto &useWords = uses[bb->id].words;
+            auto &defWords = defs[bb->id].words;
+            for (size_t w = 0; w < in.words.size(); ++w) {
+                uint64_t res =
+                    useWords[w] | (out.words[w] & ~defWords[w]) | in.words[w];
+                changed |= res != in.words[w];
+                in.words[w] = res;
+            }
+        }
+    }
+}
+
+} // namespace splc::SIR
@@ -0,0 +1,647 @@
+#include "SIR/IRMIPSBackend.hh"
+#include "SIR/IRCFG.hh"
+#include "SIR/IRLiveness.hh"
+
+#include <algorithm>
+#include <bit>
+
+namespace splc::SIR {
+
+namespace {
+
+using Reg = unsigned;
+
+constexpr Reg regZero = 0;
+constexpr Reg regV0 = 2;
+constexpr Reg regA0 = 4;
+constexpr Reg regT8 = 24;
+constexpr Reg regT9 = 25;
+constexpr Reg regSP = 29;
+constexpr Reg regFP = 30;
+constexpr Reg regRA = 31;
+constexpr Reg noReg = static_cast<Reg>(-1);
+
+constexpr const char *regNames[32] = {
+    "$zero", "$at", "$v0", "$v1", "$a0", "$a1", "$a2", "$a3",
+    "$t0",   "$t1", "$t2", "$t3", "$t4", "$t5", "$t6", "$t7",
+    "$s0",   "$s1", "$s2", "$s3", "$s4", "$s5", "$s6", "$s7",
+    "$t8",   "$t9", "$k0", "$k1", "$gp", "$sp", "$fp", "$ra"};
+
+constexpr bool isCalleeSaved(Reg reg) noexcept { return reg >= 16 && reg <= 23; }
+
+constexpr bool fitsImm16(long long val) noexcept
+{
+    return val >= -32768 && val <= 32767;
+}
+
+///
+/// \brief Range of program points where a variable may be live. Every
+/// statement `i` of the layout has two points: `2i`, where its operands are
+/// read, and `2i + 1`, where its result is written. An interval ending at a
+/// read can thus share its register with one starting at the write.
+///
+struct LiveInterval {
+    uint32_t var;
+    size_t start;
+    size_t end;
+    bool crossesCall = false;
+    Reg reg = noReg;
+};
+
+class MIPSFunctionWriter {
+  public:
+    MIPSFunctionWriter(std::ostream &os_, const IRProgram &program_,
+                       Ptr<IRFunction> func_)
+        : os{os_}, program{program_}, func{func_}, cfg{func_}, liveness{cfg}
+    {
+    }
+
+    void write();
+
+  private:
+    static constexpr size_t npos = static_cast<size_t>(-1);
+
+    void buildIntervals();
+
+    void allocateRegisters();
+
+    void layoutFrame();
+
+    void writePrologue();
+
+    void writeEpilogue();
+
+    void writeStmt(IRStmtRef stmt);
+
+    void writeArithmetic(IRStmtRef stmt);
+
+    /// \return the register holding the value of `op`, loading it into
+    /// `scratch` if it is a constant or is not kept in a register.
+    Reg useReg(IROperand op, Reg scratch);
+
+    /// \return the register the value of `op` has to be computed into.
+    Reg defReg(IROperand op) const noexcept;
+
+    /// \brief Store the value of `op` computed into `reg` to the stack, if
+    /// `op` is not kept in a register.
+    void finishDef(IROperand op, Reg reg);
+
+    /// \return the offset from `$fp` of the stack location of `var`.
+    int getFrameOffset(IROperand var) const noexcept;
+
+    /// \brief Set `dst` to `$fp + offset`.
+    void writeFrameAddress(Reg dst, int offset);
+
+    /// \brief Load or store `reg` at `$fp + offset`, with `scratch` used to
+    /// compute the address if the offset does not fit an immediate.
+    void writeFrameAccess(StrRef opcode, Reg reg, int offset, Reg scratch);
+
+    void writeLabel(IROperand label);
+
+    template <class... Args>
+    void emit(StrRef opcode, const Args &...args)
+    {
+        os << "  " << opcode;
+        [[maybe_unused]] const char *sep = " ";
+        ((os << sep << args, sep = ", "), ...);
+        os << "\n";
+    }
+
+    static const char *reg(Reg r) noexcept { return regNames[r]; }
+
+    static std::string mem(int offset, Reg base)
+    {
+        return std::to_string(offset) + "(" + regNames[base] + ")";
+    }
+
+    std::ostream &os;
+    const IRProgram &program;
+    Ptr<IRFunction> func;
+    IRCFG cfg;
+    IRLiveness liveness;
+
+    IRVec<LiveInterval> intervals;
+    IRVec<size_t> callPoints;
+
+    IRVec<Reg> varRegs;       ///< Indexed by variable, `noReg` if on the stack
+    IRVec<size_t> varSlots;   ///< Spill slot of each spilled variable
+    IRVec<int> memOffsets;    ///< Offset of the variables living in memory
+    IRVec<Reg> savedRegs;     ///< `$s` registers to preserve
+    size_t numSlots = 0;
+    int frameSize = 0;
+    size_t paramIndex = 0;
+};
+
+void MIPSFunctionWriter::write()
+{
+    liveness.recalculate();
+    buildIntervals();
+    allocateRegisters();
+    layoutFrame();
+
+    writePrologue();
+    bool endsWithJump = false;
+    for (auto &bb : cfg.getBlocks()) {
+        for (IRStmtID id : bb->stmts) {
+            IRStmtRef stmt = func->getStmt(id);
+            writeStmt(stmt);
+            endsWithJump = stmt.isGoto() || stmt.isReturn();
+        }
+    }
+    // Falling off the end of the function returns an undefined value.
+    if (!endsWithJump)
+        writeEpilogue();
+}
+
+void MIPSFunctionWriter::buildIntervals()
+{
+    size_t numVars = liveness.getNumVars();
+    IRVec<size_t> starts(numVars, npos);
+    IRVec<size_t> ends(numVars, 0);
+    auto extend = [&](IROperand op, size_t point) {
+        size_t i = liveness.getIndex(op);
+        if (i == IRLiveness::npos)
+            return;
+        starts[i] = std::min(starts[i], point);
+        ends[i] = std::max(ends[i], point);
+    };
+    auto extendAll = [&](const IRBitVector &live, size_t point) {
+        for (size_t w = 0; w < live.words.size(); ++w) {
+            for (uint64_t word = live.words[w]; word != 0; word &= word - 1) {
+                size_t i = w * 64 + std::countr_zero(word);
+                starts[i] = std::min(starts[i], point);
+                ends[i] = std::max(ends[i], point);
+            }
+        }
+    };
+
+    size_t index = 0;
+    for (auto &bb : cfg.getBlocks()) {
+        size_t first = index;
+        for (IRStmtID id : bb->stmts) {
+            IRStmtRef stmt = func->getStmt(id);
+            stmt.forEachUseOperand(
+                [&](IROperand &op) { extend(op, 2 * index); });
+            if (IROperand *def = stmt.getDefOperand())
+                extend(*def, 2 * index + 1);
+            if (stmt.isInvokeFunc())
+                callPoints.push_back(2 * index);
+            ++index;
+        }
+        // Empty blocks still get a point, for the values live through them.
+        if (bb->stmts.empty())
+            ++index;
+        extendAll(liveness.getLiveIn(bb.get()), 2 * first);
+        extendAll(liveness.getLiveOut(bb.get()), 2 * index - 1);
+    }
+
+    for (size_t i = 0; i < numVars; ++i) {
+        if (starts[i] == npos)
+            continue;
+        LiveInterval interval{static_cast<uint32_t>(i), starts[i], ends[i]};
+        // Live across a call if defined before it and read after it.
+        auto it = std::ranges::upper_bound(callPoints, interval.start);
+        interval.crossesCall = it != callPoints.end() && *it + 1 < interval.end;
+        intervals.push_back(interval);
+    }
+}
+
+void MIPSFunctionWriter::allocateRegisters()
+{
+    std::ranges::sort(intervals, [](const auto &a, const auto &b) {
+        return a.start != b.start ? a.start < b.start : a.var < b.var;
+    });
+
+    // Popped from the back, so that `$t0` and `$s0` are used first.
+    IRVec<Reg> freeTemps = {15, 14, 13, 12, 11, 10, 9, 8};
+    IRVec<Reg> freeSaved = {23, 22, 21, 20, 19, 18, 17, 16};
+    auto release = [&](Reg r) {
+        (isCalleeSaved(r) ? freeSaved : freeTemps).push_back(r);
+    };
+
+    IRVec<LiveInterval *> active;
+    IRVec<LiveInterval *> spilled;
+    for (auto &cur : intervals) {
+        std::erase_if(active, [&](LiveInterval *interval) {
+            if (interval->end >= cur.start)
+                return false;
+            release(interval->reg);
+            return true;
+        });
+
+        if (!cur.crossesCall && !freeTemps.empty()) {
+            cur.reg = freeTemps.back();
+            freeTemps.pop_back();
+        }
+        else if (!freeSaved.empty()) {
+            cur.reg = freeSaved.back();
+            freeSaved.pop_back();
+        }
+        else {
+            // Spill whichever interval ends last, among those whose register
+            // `cur` could use.
+            auto victim = active.end();
+            for (auto it = active.begin(); it != active.end(); ++it) {
+                if (cur.crossesCall && !isCalleeSaved((*it)->reg))
+                    continue;
+                if (victim == active.end() || (*it)->end > (*victim)->end)
+                    victim = it;
+            }
+            if (victim != active.end() && (*victim)->end > cur.end) {
+                cur.reg = (*victim)->reg;
+                (*victim)->reg = noReg;
+                spilled.push_back(*victim);
+                active.erase(victim);
+            }
+            else {
+                spilled.push_back(&cur);
+                continue;
+            }
+        }
+        active.push_back(&cur);
+    }
+
+    varRegs.assign(liveness.getNumVars(), noReg);
+    for (auto &interval : intervals) {
+        varRegs[interval.var] = interval.reg;
+        if (interval.reg != noReg && isCalleeSaved(interval.reg) &&
+            std::ranges::find(savedRegs, interval.reg) == savedRegs.end())
+            savedRegs.push_back(interval.reg);
+    }
+    std::ranges::sort(savedRegs);
+
+    // Spilled intervals that do not overlap share a slot.
+    std::ranges::sort(spilled, [](const auto *a, const auto *b) {
+        return a->start < b->start;
+    });
+    varSlots.assign(liveness.getNumVars(), npos);
+    IRVec<size_t> slotEnds;
+    for (auto *interval : spilled) {
+        auto it = std::ranges::find_if(
+            slotEnds, [&](size_t end) { return end < interval->start; });
+        size_t slot = static_cast<size_t>(it - slotEnds.begin());
+        if (it == slotEnds.end())
+            slotEnds.push_back(interval->end);
+        else
+            *it = interval->end;
+        varSlots[interval->var] = slot;
+    }
+    numSlots = slotEnds.size();
+}
+
+void MIPSFunctionWriter::layoutFrame()
+{
+    // Sizes of the variables living in memory, 4 bytes unless declared.
+    IRVec<size_t> memSizes(liveness.getNumVars(), 0);
+    for (IRStmtID id : func->body) {
+        IRStmtRef stmt = func->getStmt(id);
+        if (stmt.isAlloc()) {
+            auto size = func->getConstantValue(stmt.op2());
+            memSizes[stmt.op1().getIndex()] =
+                (static_cast<size_t>(size) + 3) / 4 * 4;
+        }
+        else if (stmt.isAddrOf() && stmt.op2().isVariable()) {
+            size_t &size = memSizes[stmt.op2().getIndex()];
+            size = std::max<size_t>(size, 4);
+        }
+    }
+
+    // $ra and $fp come first, then the saved registers and the spill slots,
+    // which are thus reachable with immediate offsets.
+    size_t cursor = 8 + 4 * savedRegs.size() + 4 * numSlots;
+    memOffsets.assign(liveness.getNumVars(), 0);
+    for (size_t i = 0; i < memSizes.size(); ++i) {
+        if (memSizes[i] == 0)
+            continue;
+        cursor += memSizes[i];
+        memOffsets[i] = -static_cast<int>(cursor);
+    }
+    frameSize = static_cast<int>((cursor + 7) / 8 * 8);
+}
+
+int MIPSFunctionWriter::getFrameOffset(IROperand var) const noexcept
+{
+    size_t i = var.getIndex();
+    if (memOffsets[i] != 0)
+        return memOffsets[i];
+    splc_dbgassert(varSlots[i] != npos)
+        << "no location for " << func->getOperandName(var);
+    return -static_cast<int>(8 + 4 * savedRegs.size() + 4 * (varSlots[i] + 1));
+}
+
+void MIPSFunctionWriter::writeFrameAddress(Reg dst, int offset)
+{
+    if (fitsImm16(offset)) {
+        emit("addiu", reg(dst), reg(regFP), offset);
+    }
+    else {
+        emit("li", reg(dst), offset);
+        emit("addu", reg(dst), reg(regFP), reg(dst));
+    }
+}
+
+void MIPSFunctionWriter::writeFrameAccess(StrRef opcode, Reg r, int offset,
+                                          Reg scratch)
+{
+    if (fitsImm16(offset)) {
+        emit(opcode, reg(r), mem(offset, regFP));
+    }
+    else {
+        writeFrameAddress(scratch, offset);
+        emit(opcode, reg(r), mem(0, scratch));
+    }
+}
+
+void MIPSFunctionWriter::writePrologue()
+{
+    os << IRMIPSBackend::getFunctionLabel(func->name) << ":\n";
+    emit("sw", reg(regRA), mem(-4, regSP));
+    emit("sw", reg(regFP), mem(-8, regSP));
+    emit("move", reg(regFP), reg(regSP));
+    if (fitsImm16(-frameSize)) {
+        emit("addiu", reg(regSP), reg(regSP), -frameSize);
+    }
+    else {
+        emit("li", reg(regT8), frameSize);
+        emit("subu", reg(regSP), reg(regSP), reg(regT8));
+    }
+    for (size_t i = 0; i < savedRegs.size(); ++i)
+        emit("sw", reg(savedRegs[i]),
+             mem(-static_cast<int>(12 + 4 * i), regFP));
+}
+
+void MIPSFunctionWriter::writeEpilogue()
+{
+    for (size_t i = 0; i < savedRegs.size(); ++i)
+        emit("lw", reg(savedRegs[i]),
+             mem(-static_cast<int>(12 + 4 * i), regFP));
+    emit("lw", reg(regRA), mem(-4, regFP));
+    emit("move", reg(regSP), reg(regFP));
+    emit("lw", reg(regFP), mem(-8, regSP));
+    emit("jr", reg(regRA));
+}
+
+Reg MIPSFunctionWriter::useReg(IROperand op, Reg scratch)
+{
+    if (op.isConstant()) {
+        ASTSIntType val = func->getConstantValue(op);
+        if (val == 0)
+            return regZero;
+        emit("li", reg(scratch), val);
+        return scratch;
+    }
+    splc_dbgassert(op.isVariable())
+        << "invalid operand " << func->getOperandName(op);
+    if (Reg r = varRegs[op.getIndex()]; r != noReg)
+        return r;
+    writeFrameAccess("lw", scratch, getFrameOffset(op), scratch);
+    return scratch;
+}
+
+Reg MIPSFunctionWriter::defReg(IROperand op) const noexcept
+{
+    Reg r = varRegs[op.getIndex()];
+    return r != noReg ? r : regT8;
+}
+
+void MIPSFunctionWriter::finishDef(IROperand op, Reg r)
+{
+    if (varRegs[op.getIndex()] == noReg)
+        writeFrameAccess("sw", r, getFrameOffset(op), regT9);
+}
+
+void MIPSFunctionWriter::writeLabel(IROperand label)
+{
+    func->writeOperand(os, label);
+}
+
+void MIPSFunctionWriter::writeArithmetic(IRStmtRef stmt)
+{
+    IROperand lhs = stmt.op2();
+    IROperand rhs = stmt.op3();
+    Reg dst = defReg(stmt.op1());
+
+    // Additions and subtractions of constants use immediates.
+    if (stmt.getIRType() == IRType::Plus && lhs.isConstant() &&
+        !rhs.isConstant())
+        std::swap(lhs, rhs);
+    if (rhs.isConstant() && (stmt.getIRType() == IRType::Plus ||
+                             stmt.getIRType() == IRType::Minus)) {
+        long long val = func->getConstantValue(rhs);
+        if (stmt.getIRType() == IRType::Minus)
+            val = -val;
+        if (fitsImm16(val)) {
+            emit("addiu", reg(dst), reg(useReg(lhs, regT8)), val);
+            finishDef(stmt.op1(), dst);
+            return;
+        }
+    }
+
+    const char *a = reg(useReg(lhs, regT8));
+    const char *b = reg(useReg(rhs, regT9));
+    switch (stmt.getIRType()) {
+    case IRType::Plus: {
+        emit("addu", reg(dst), a, b);
+        break;
+    }
+    case IRType::Minus: {
+        emit("subu", reg(dst), a, b);
+        break;
+    }
+    case IRType::Mul: {
+        emit("mul", reg(dst), a, b);
+        break;
+    }
+    case IRType::Div: {
+        emit("div", a, b);
+        emit("mflo", reg(dst));
+        break;
+    }
+    default:
+        splc_unreachable();
+    }
+    finishDef(stmt.op1(), dst);
+}
+
+void MIPSFunctionWriter::writeStmt(IRStmtRef stmt)
+{
+    switch (stmt.getIRType()) {
+    case IRType::SetLabel: {
+        writeLabel(stmt.op1());
+        os << ":\n";
+        break;
+    }
+    case IRType::Assign: {
+        Reg dst = defReg(stmt.op1());
+        if (stmt.op2().isConstant()) {
+            emit("li", reg(dst), func->getConstantValue(stmt.op2()));
+        }
+        else if (Reg src = useReg(stmt.op2(), dst); src != dst) {
+            emit("move", reg(dst), reg(src));
+        }
+        finishDef(stmt.op1(), dst);
+        break;
+    }
+    case IRType::Plus:
+    case IRType::Minus:
+    case IRType::Mul:
+    case IRType::Div: {
+        writeArithmetic(stmt);
+        break;
+    }
+    case IRType::AddrOf: {
+        Reg dst = defReg(stmt.op1());
+        writeFrameAddress(dst, getFrameOffset(stmt.op2()));
+        finishDef(stmt.op1(), dst);
+        break;
+    }
+    case IRType::Deref: {
+        Reg addr = useReg(stmt.op2(), regT8);
+        Reg dst = defReg(stmt.op1());
+        emit("lw", reg(dst), mem(0, addr));
+        finishDef(stmt.op1(), dst);
+        break;
+    }
+    case IRType::CopyToAddr: {
+        Reg addr = useReg(stmt.op1(), regT8);
+        Reg val = useReg(stmt.op2(), regT9);
+        emit("sw", reg(val), mem(0, addr));
+        break;
+    }
+    case IRType::Goto: {
+        os << "  j ";
+        writeLabel(stmt.op1());
+        os << "\n";
+        break;
+    }
+    case IRType::BranchIf: {
+        const char *opcode = nullptr;
+        switch (stmt.getBranchType()) {
+        case IRBranchType::LT:
+            opcode = "blt";
+            break;
+        case IRBranchType::LE:
+            opcode = "ble";
+            break;
+        case IRBranchType::GT:
+            opcode = "bgt";
+            break;
+        case IRBranchType::GE:
+            opcode = "bge";
+            break;
+        case IRBranchType::EQ:
+            opcode = "beq";
+            break;
+        case IRBranchType::NE:
+            opcode = "bne";
+            break;
+        default:
+            splc_unreachable();
+        }
+        Reg a = useReg(stmt.op1(), regT8);
+        Reg b = useReg(stmt.op2(), regT9);
+        os << "  " << opcode << " " << reg(a) << ", " << reg(b) << ", ";
+        writeLabel(stmt.op3());
+        os << "\n";
+        break;
+    }
+    case IRType::Return: {
+        if (stmt.op1()) {
+            if (Reg val = useReg(stmt.op1(), regV0); val != regV0)
+                emit("move", reg(regV0), reg(val));
+        }
+        writeEpilogue();
+        break;
+    }
+    case IRType::Alloc: {
+        // The memory is reserved in the frame.
+        break;
+    }
+    case IRType::PopCallArg: {
+        Reg dst = defReg(stmt.op1());
+        emit("lw", reg(dst),
+             mem(static_cast<int>(4 * paramIndex++), regFP));
+        finishDef(stmt.op1(), dst);
+        break;
+    }
+    case IRType::PushCallArg: {
+        Reg val = useReg(stmt.op1(), regT8);
+        emit("addiu", reg(regSP), reg(regSP), -4);
+        emit("sw", reg(val), mem(0, regSP));
+        break;
+    }
+    case IRType::InvokeFunc: {
+        StrRef name = func->getFunctionName(stmt.op2());
+        auto it = program.funcMap.find(name);
+        if (it == program.funcMap.end())
+            splc_error() << "call to undefined function: " << name;
+
+        emit("jal", IRMIPSBackend::getFunctionLabel(name));
+        // Arguments of enclosing calls may still be below ours on the stack.
+        if (size_t numArgs = it->second->paramList.size(); numArgs > 0)
+            emit("addiu", reg(regSP), reg(regSP), 4 * numArgs);
+        if (stmt.op1()) {
+            Reg dst = defReg(stmt.op1());
+            emit("move", reg(dst), reg(regV0));
+            finishDef(stmt.op1(), dst);
+        }
+        break;
+    }
+    case IRType::Read: {
+        emit("li", reg(regV0), 5);
+        emit("syscall");
+        Reg dst = defReg(stmt.op1());
+        emit("move", reg(dst), reg(regV0));
+        finishDef(stmt.op1(), dst);
+        break;
+    }
+    case IRType::Write: {
+        if (Reg val = useReg(stmt.op1(), regA0); val != regA0)
+            emit("move", reg(regA0), reg(val));
+        emit("li", reg(regV0), 1);
+        emit("syscall");
+        emit("li", reg(regV0), 4);
+        emit("la", reg(regA0), "_splc_newline");
+        emit("syscall");
+        break;
+    }
+    default:
+        splc_error() << "cannot translate to MIPS: " << stmt;
+    }
+}
+
+} // namespace
+
+std::string IRMIPSBackend::getFunctionLabel(StrRef name)
+{
+    // Other labels are prefixed so that they never clash with mnemonics.
+    if (name == "main")
+        return std::string{name};
+    return "_" + std::string{name};
+}
+
+void IRMIPSBackend::writeFunction(std::ostream &os, const IRProgram &program,
+                                  Ptr<IRFunction> func)
+{
+    MIPSFunctionWriter{os, program, func}.write();
+}
+
+void IRMIPSBackend::writeProgram(std::ostream &os, Ptr<IRProgram> program)
+{
+    // SPIM enters `main` from its own startup code, while MARS starts at the
+    // first instruction of the text segment.
+    os << ".data\n"
+       << "_splc_newline: .asciiz \"\\n\"\n"
+       << ".globl main\n"
+       << ".text\n"
+       << "_splc_start:\n"
+       << "  jal main\n"
+       << "  li $v0, 10\n"
+       << "  syscall\n";
+    for (auto &[name, func] : program->funcMap) {
+        os << "\n";
+        writeFunction(os, *program, func);
+    }
+}
+
+} // namespace splc::SIR
@@ -1,371 +1,1510 @@
 #include "SIR/IROptimizer.hh"
+#include "SIR/IRPassManager.hh"
+
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <unordered_set>
 
 namespace splc::SIR {
 
-Ptr<DepNode> findOrMake(DepNodeMap &map, Ptr<IRVar> var, Ptr<IRStmt> stmt,
-                        DepNode::Type type)
+namespace {
+
+///
+/// \return whether each variable of `func` lives in memory, because its
+/// address is taken or it is declared with `DEC`.
+///
+IRVec<bool> findInMemoryVariables(IRFunction &func)
 {
-    auto it = map.find(var.get());
-    if (it == map.end()) {
-        auto node = DepNode::make(var, stmt, type);
-        map.insert({var.get(), node});
-        return node;
+    IRVec<bool> inMemory(func.getNumVariables(), false);
+    for (IRStmtID id : func.body) {
+        IRStmtRef stmt = func.getStmt(id);
+        if (stmt.isAddrOf() && stmt.op2().isVariable())
+            inMemory[stmt.op2().getIndex()] = true;
+        else if (stmt.isAlloc() && stmt.op1().isVariable())
+            inMemory[stmt.op1().getIndex()] = true;
     }
-    return it->second;
+    return inMemory;
+}
+
+} // namespace
+
+//===----------------------------------------------------------------------===//
+//                          Dead Code Elimination
+//===----------------------------------------------------------------------===//
+
+void IROptimizer::removeUnusedStmts(Ptr<IRFunction> func)
+{
+    IRCFG cfg{func};
+    cfg.removeUnreachableBlocks();
+
+    // Removing a statement may kill the definitions of its operands in other
+    // blocks, so liveness is solved again until nothing changes.
+    IRLiveness liveness{cfg};
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        liveness.recalculate();
+
+        for (auto &bb : cfg.getBlocks()) {
+            IRBitVector live = liveness.getLiveOut(bb.get());
+            for (size_t pos = bb->stmts.size(); pos-- > 0;) {
+                IRStmtRef stmt = bb->getStmt(pos);
+                IROperand *def = stmt.getDefOperand();
+                size_t defIdx =
+                    def ? liveness.getIndex(*def) : IRLiveness::npos;
+                if (defIdx != IRLiveness::npos) {
+                    if (!live.test(defIdx) && !stmt.hasSideEffects()) {
+                        cfg.eraseStmt(bb.get(), pos);
+                        changed = true;
+                        continue;
+                    }
+                    live.reset(defIdx);
+                }
+                stmt.forEachUseOperand([&](IROperand &op) {
+                    if (size_t i = liveness.getIndex(op);
+                        i != IRLiveness::npos)
+                        live.set(i);
+                });
+            }
+        }
+    }
+
+    // Variables only used to compute themselves, such as induction variables
+    // whose uses have been strength-reduced, stay live. Those needed by the
+    // statements with side effects are marked instead, keeping all their
+    // definitions.
+    IRVec<IRVec<IRStmtID>> defStmts(liveness.getNumVars());
+    IRVec<bool> useful(liveness.getNumVars(), false);
+    IRVec<size_t> worklist;
+    auto markUses = [&](IRStmtRef stmt) {
+        stmt.forEachUseOperand([&](IROperand &op) {
+            if (size_t i = liveness.getIndex(op);
+                i != IRLiveness::npos && !useful[i]) {
+                useful[i] = true;
+                worklist.push_back(i);
+            }
+        });
+    };
+    for (auto &bb : cfg.getBlocks()) {
+        for (IRStmtID id : bb->stmts) {
+            IRStmtRef stmt = func->getStmt(id);
+            IROperand *def = stmt.getDefOperand();
+            size_t defIdx = def ? liveness.getIndex(*def) : IRLiveness::npos;
+            if (defIdx == IRLiveness::npos || stmt.hasSideEffects())
+                markUses(stmt);
+            else
+                defStmts[defIdx].push_back(id);
+        }
+    }
+    while (!worklist.empty()) {
+        size_t i = worklist.back();
+        worklist.pop_back();
+        for (IRStmtID id : defStmts[i])
+            markUses(func->getStmt(id));
+    }
+    for (auto &bb : cfg.getBlocks()) {
+        std::erase_if(bb->stmts, [&](IRStmtID id) {
+            IRStmtRef stmt = func->getStmt(id);
+            IROperand *def = stmt.getDefOperand();
+            size_t defIdx = def ? liveness.getIndex(*def) : IRLiveness::npos;
+            return defIdx != IRLiveness::npos && !stmt.hasSideEffects() &&
+                   !useful[defIdx];
+        });
+    }
+
+    cfg.writeBack();
+}
+
+//===----------------------------------------------------------------------===//
+//                          Jump Simplification
+//===----------------------------------------------------------------------===//
+
+namespace {
+
+IRBranchType invertBranchType(IRBranchType branchType) noexcept
+{
+    switch (branchType) {
+    case IRBranchType::LT:
+        return IRBranchType::GE;
+    case IRBranchType::LE:
+        return IRBranchType::GT;
+    case IRBranchType::GT:
+        return IRBranchType::LE;
+    case IRBranchType::GE:
+        return IRBranchType::LT;
+    case IRBranchType::EQ:
+        return IRBranchType::NE;
+    case IRBranchType::NE:
+        return IRBranchType::EQ;
+    case IRBranchType::None:
+        break;
+    }
+    splc_unreachable();
+}
+
+/// \return true if `label` is set by the run of labels starting at `pos`.
+bool isLabelAt(IRFunction &func, size_t pos, IROperand label) noexcept
+{
+    auto &body = func.body;
+    for (; pos < body.size() && func.getStmt(body[pos]).isSetLabel(); ++pos) {
+        if (func.getStmt(body[pos]).op1() == label)
+            return true;
+    }
+    return false;
+}
+
+/// \brief Retarget jumps to a label that is only an alias of another one.
+/// \return true if any jump has been changed.
+bool threadJumps(IRFunction &func)
+{
+    auto &body = func.body;
+
+    // The labels in a run are aliases of the first one, and all of them are
+    // aliases of the target of a GOTO right after the run.
+    IRVec<IROperand> aliases(func.getNumLabels());
+    for (size_t i = 0; i < body.size();) {
+        if (!func.getStmt(body[i]).isSetLabel()) {
+            ++i;
+            continue;
+        }
+        size_t end = i + 1;
+        while (end < body.size() && func.getStmt(body[end]).isSetLabel())
+            ++end;
+        bool hasGoto = end < body.size() && func.getStmt(body[end]).isGoto();
+        IROperand target = hasGoto ? func.getStmt(body[end]).op1()
+                                   : func.getStmt(body[i]).op1();
+        for (size_t j = i; j < end; ++j) {
+            IROperand label = func.getStmt(body[j]).op1();
+            if (label != target)
+                aliases[label.getIndex()] = target;
+        }
+        i = end;
+    }
+
+    auto resolve = [&](IROperand label) {
+        IROperand res = label;
+        std::unordered_set<IROperand> visited{label};
+        while (IROperand alias = aliases[res.getIndex()]) {
+            res = alias;
+            // Jumps forming a loop are left alone.
+            if (!visited.insert(res).second)
+                return label;
+        }
+        return res;
+    };
+
+    bool changed = false;
+    for (IRStmtID id : body) {
+        if (IROperand *target = func.getStmt(id).getJumpTarget()) {
+            IROperand res = resolve(*target);
+            if (res != *target) {
+                *target = res;
+                changed = true;
+            }
+        }
+    }
+    return changed;
 }
 
-Ptr<DepNode> insertOrReplace(DepNodeMap &map, Ptr<IRVar> var, Ptr<IRStmt> stmt,
-                             DepNode::Type type)
+/// \brief Remove the jumps to the next statement, and invert a conditional
+/// jump over a GOTO.
+/// \return true if any jump has been changed.
+bool removeJumpsToNext(IRFunction &func)
 {
-    auto node = DepNode::make(var, stmt, type);
-    map.insert_or_assign(var.get(), node);
-    return node;
+    auto &body = func.body;
+    bool changed = false;
+    IRVec<IRStmtID> newBody;
+    newBody.reserve(body.size());
+    for (size_t i = 0; i < body.size(); ++i) {
+        IRStmtRef stmt = func.getStmt(body[i]);
+        if (IROperand *target = stmt.getJumpTarget();
+            target != nullptr && isLabelAt(func, i + 1, *target)) {
+            changed = true;
+            continue;
+        }
+        // IF a < b GOTO l1; GOTO l2; LABEL l1 => IF a >= b GOTO l2; LABEL l1
+        if (stmt.isBranchIf() && i + 1 < body.size() &&
+            func.getStmt(body[i + 1]).isGoto() &&
+            isLabelAt(func, i + 2, stmt.op3())) {
+            stmt.setBranchType(invertBranchType(stmt.getBranchType()));
+            stmt.op3() = func.getStmt(body[i + 1]).op1();
+            newBody.push_back(body[i]);
+            ++i;
+            changed = true;
+            continue;
+        }
+        newBody.push_back(body[i]);
+    }
+    body = std::move(newBody);
+    return changed;
 }
 
-void IROptimizer::examineStmt(DepKey &key, Ptr<IRFunction> func,
-                              Ptr<IRStmt> &stmt)
+/// \brief Remove the labels never jumped to, and the statements that follow a
+/// GOTO or RETURN without a label in between.
+/// \return true if any statement has been removed.
+bool removeDeadLabels(IRFunction &func)
+{
+    auto &body = func.body;
+    IRVec<bool> referenced(func.getNumLabels(), false);
+    for (IRStmtID id : body) {
+        if (IROperand *target = func.getStmt(id).getJumpTarget())
+            referenced[target->getIndex()] = true;
+    }
+
+    size_t oldSize = body.size();
+    bool isReachable = true;
+    std::erase_if(body, [&](IRStmtID id) {
+        IRStmtRef stmt = func.getStmt(id);
+        if (stmt.isSetLabel()) {
+            if (!referenced[stmt.op1().getIndex()])
+                return true;
+            isReachable = true;
+            return false;
+        }
+        if (!isReachable)
+            return true;
+        if (stmt.isGoto() || stmt.isReturn())
+            isReachable = false;
+        return false;
+    });
+    return body.size() != oldSize;
+}
+
+} // namespace
+
+void IROptimizer::simplifyJumps(Ptr<IRFunction> func)
+{
+    bool changed = true;
+    while (changed) {
+        changed = threadJumps(*func);
+        changed |= removeJumpsToNext(*func);
+        changed |= removeDeadLabels(*func);
+    }
+}
+
+//===----------------------------------------------------------------------===//
+//                   Sparse Conditional Constant Propagation
+//===----------------------------------------------------------------------===//
+
+namespace {
+
+struct LatticeValue {
+    enum class Kind {
+        Top,      ///< Not known yet
+        Constant, ///< Always `value`
+        Bottom,   ///< Not a constant
+    };
+
+    static LatticeValue makeConstant(ASTSIntType value_) noexcept
+    {
+        return {Kind::Constant, value_};
+    }
+
+    static LatticeValue makeBottom() noexcept { return {Kind::Bottom, 0}; }
+
+    bool isTop() const noexcept { return kind == Kind::Top; }
+
+    bool isConstant() const noexcept { return kind == Kind::Constant; }
+
+    bool isBottom() const noexcept { return kind == Kind::Bottom; }
+
+    bool operator==(const LatticeValue &other) const noexcept = default;
+
+    LatticeValue meet(const LatticeValue &other) const noexcept
+    {
+        if (isTop() || other.isBottom())
+            return other;
+        if (other.isTop() || isBottom() || value == other.value)
+            return *this;
+        return makeBottom();
+    }
+
+    Kind kind = Kind::Top;
+    ASTSIntType value = 0;
+};
+
+LatticeValue evaluateArithmetic(IRType irType, LatticeValue lhs,
+                                LatticeValue rhs) noexcept
 {
-    using Type = DepNode::Type;
-    auto &[allDepNodes, nodeMap, inputs, outputs] = key;
-    switch (stmt->getIRType()) {
-    case IRType::SetLabel:
-    case IRType::FuncDecl: {
-        // Don't care
+    if (irType == IRType::Mul &&
+        ((lhs.isConstant() && lhs.value == 0) ||
+         (rhs.isConstant() && rhs.value == 0)))
+        return LatticeValue::makeConstant(0);
+    if (lhs.isBottom() || rhs.isBottom())
+        return LatticeValue::makeBottom();
+    if (lhs.isTop() || rhs.isTop())
+        return {};
+
+    ASTSIntType res = 0;
+    switch (irType) {
+    case IRType::Plus: {
+        res = lhs.value + rhs.value;
         break;
     }
-    case IRType::Assign:
-    case IRType::AddrOf:
-    case IRType::Deref:
-    case IRType::CopyToAddr: {
-        auto rhs = findOrMake(nodeMap, stmt->op2, nullptr, Type::Mid);
-        auto lhs = insertOrReplace(nodeMap, stmt->op1, stmt, Type::Mid);
-        DepNode::connect(rhs, lhs);
-        allDepNodes.insert(allDepNodes.end(), {rhs, lhs});
-        // SPLC_LOG_DEBUG(nullptr, false)
-        //     << "inserted assignment"
-        //     << ", lhs: " << lhs->var->name << ", rhs: " << rhs->var->name;
+    case IRType::Minus: {
+        res = lhs.value - rhs.value;
+        break;
+    }
+    case IRType::Mul: {
+        res = lhs.value * rhs.value;
         break;
     }
-    case IRType::Plus:
-    case IRType::Minus:
-    case IRType::Mul:
     case IRType::Div: {
-        auto rhs1 = findOrMake(nodeMap, stmt->op2, nullptr, Type::Mid);
-        auto rhs2 = findOrMake(nodeMap, stmt->op3, nullptr, Type::Mid);
-        auto lhs = insertOrReplace(nodeMap, stmt->op1, stmt, Type::Mid);
-        DepNode::connect(rhs1, lhs);
-        DepNode::connect(rhs2, lhs);
-        allDepNodes.insert(allDepNodes.end(), {rhs1, rhs2, lhs});
-        // SPLC_LOG_DEBUG(nullptr, false)
-        //     << "inserted"
-        //     << ", lhs: " << lhs->var->name << ", rhs1: " << rhs1->var->name
-        //     << ", rhs2: " << rhs2->var->name;
+        // Division by zero traps at runtime, so it is left alone.
+        if (rhs.value == 0)
+            return LatticeValue::makeBottom();
+        res = lhs.value / rhs.value;
         break;
     }
-    case IRType::Goto: {
-        // Don't care
+    default:
+        splc_error();
+    }
+
+    // Operands are at most 32 bits wide. Results that overflow are left to the
+    // runtime as well.
+    if (res < std::numeric_limits<int32_t>::min() ||
+        res > std::numeric_limits<int32_t>::max())
+        return LatticeValue::makeBottom();
+    return LatticeValue::makeConstant(res);
+}
+
+bool evaluateBranch(IRBranchType branchType, ASTSIntType lhs,
+                    ASTSIntType rhs) noexcept
+{
+    switch (branchType) {
+    case IRBranchType::LT:
+        return lhs < rhs;
+    case IRBranchType::LE:
+        return lhs <= rhs;
+    case IRBranchType::GT:
+        return lhs > rhs;
+    case IRBranchType::GE:
+        return lhs >= rhs;
+    case IRBranchType::EQ:
+        return lhs == rhs;
+    case IRBranchType::NE:
+        return lhs != rhs;
+    case IRBranchType::None:
         break;
     }
-    case IRType::BranchIf: {
-        auto rhsPrev = findOrMake(nodeMap, stmt->op2, nullptr, Type::Mid);
-        auto lhsPrev = findOrMake(nodeMap, stmt->op1, nullptr, Type::Mid);
+    splc_unreachable();
+}
+
+///
+/// \brief Wegman-Zadeck SCCP over a function in SSA form.
+///
+/// Only the blocks reached through edges found executable are evaluated, so
+/// constants flowing into a branch decide which successors are visited at all.
+///
+class SCCPSolver {
+  public:
+    SCCPSolver(IRCFG &cfg_, const IRSSA &ssa_)
+        : cfg{cfg_}, func{*cfg_.getFunction()}, ssa{ssa_},
+          executableBlocks(cfg_.size(), false)
+    {
+    }
 
-        // change this
-        auto rhsBranch =
-            insertOrReplace(nodeMap, stmt->op2, stmt, Type::Output);
-        auto lhsBranch =
-            insertOrReplace(nodeMap, stmt->op1, stmt, Type::Output);
+    void solve();
 
-        DepNode::connect(lhsPrev, lhsBranch);
-        DepNode::connect(rhsPrev, rhsBranch);
+    /// \brief Fold constants and branches, then remove unreachable blocks and
+    /// the definitions no longer used.
+    void rewrite();
 
-        outputs.insert(outputs.end(), {lhsBranch, rhsBranch});
-        allDepNodes.insert(allDepNodes.end(),
-                           {lhsPrev, rhsPrev, lhsBranch, rhsBranch});
-        break;
+  private:
+    using StmtSite = IRPair<IRSB *, IRStmtID>;
+
+    LatticeValue getValue(IROperand op) const;
+
+    void lowerValue(IROperand var, LatticeValue val);
+
+    void visitEdge(IRSB *from, IRSB *to);
+
+    void visitStmt(IRSB *bb, IRStmtRef stmt);
+
+    bool isEdgeExecutable(const IRSB *from, const IRSB *to) const
+    {
+        return executableEdges.contains({from->id, to->id});
     }
-    case IRType::Return: {
-        auto lhs = findOrMake(nodeMap, stmt->op1, stmt, Type::Output);
-        allDepNodes.push_back(lhs);
-        outputs.push_back(lhs);
-        break;
+
+    void removeDeadConstants();
+
+    IRCFG &cfg;
+    IRFunction &func;
+    const IRSSA &ssa;
+
+    IRVec<LatticeValue> values;   ///< Indexed by variable
+    IRVec<IRVec<StmtSite>> uses;  ///< Indexed by variable
+    IRVec<bool> executableBlocks;
+    std::set<IRPair<size_t, size_t>> executableEdges;
+
+    IRVec<IRPair<IRSB *, IRSB *>> flowWorklist;
+    IRVec<StmtSite> ssaWorklist;
+};
+
+void SCCPSolver::solve()
+{
+    values.assign(func.getNumVariables(), LatticeValue{});
+    uses.assign(func.getNumVariables(), {});
+    for (auto &bb : cfg.getBlocks()) {
+        for (IRStmtID id : bb->stmts) {
+            func.getStmt(id).forEachUseOperand([&](IROperand &op) {
+                if (ssa.isVersion(op))
+                    uses[op.getIndex()].emplace_back(bb.get(), id);
+            });
+        }
+    }
+
+    flowWorklist.emplace_back(nullptr, cfg.getEntry());
+    while (!flowWorklist.empty() || !ssaWorklist.empty()) {
+        while (!flowWorklist.empty()) {
+            auto [from, to] = flowWorklist.back();
+            flowWorklist.pop_back();
+            visitEdge(from, to);
+        }
+        while (!ssaWorklist.empty()) {
+            auto [bb, id] = ssaWorklist.back();
+            ssaWorklist.pop_back();
+            if (executableBlocks[bb->id])
+                visitStmt(bb, func.getStmt(id));
+        }
     }
-    case IRType::Alloc: {
-        auto lhs1 = insertOrReplace(nodeMap, stmt->op1, stmt, Type::Output);
-        auto lhs2 = findOrMake(nodeMap, stmt->op2, nullptr, Type::Output);
-        allDepNodes.insert(allDepNodes.end(), {lhs1, lhs2});
-        outputs.insert(outputs.end(), {lhs1, lhs2});
+}
+
+LatticeValue SCCPSolver::getValue(IROperand op) const
+{
+    if (op.isConstant())
+        return LatticeValue::makeConstant(func.getConstantValue(op));
+    // Variables kept in memory and uses reached by no definition
+    if (!ssa.isVersion(op))
+        return LatticeValue::makeBottom();
+    return values[op.getIndex()];
+}
+
+void SCCPSolver::lowerValue(IROperand var, LatticeValue val)
+{
+    if (!ssa.isVersion(var))
+        return;
+
+    LatticeValue &cur = values[var.getIndex()];
+    LatticeValue res = cur.meet(val);
+    if (res == cur)
+        return;
+    cur = res;
+    auto &varUses = uses[var.getIndex()];
+    ssaWorklist.insert(ssaWorklist.end(), varUses.begin(), varUses.end());
+}
+
+void SCCPSolver::visitEdge(IRSB *from, IRSB *to)
+{
+    if (from != nullptr && !executableEdges.emplace(from->id, to->id).second)
+        return;
+
+    if (executableBlocks[to->id]) {
+        // Only the phi functions can observe the new edge.
+        for (size_t pos = to->getFirstNonLabel();
+             pos < to->stmts.size() && to->getStmt(pos).isPhi(); ++pos)
+            visitStmt(to, to->getStmt(pos));
+        return;
+    }
+
+    executableBlocks[to->id] = true;
+    for (size_t pos = 0; pos < to->stmts.size(); ++pos)
+        visitStmt(to, to->getStmt(pos));
+    if (!to->getTerminator()) {
+        if (IRSB *next = cfg.getLayoutSuccessor(to))
+            flowWorklist.emplace_back(to, next);
+    }
+}
+
+void SCCPSolver::visitStmt(IRSB *bb, IRStmtRef stmt)
+{
+    switch (stmt.getIRType()) {
+    case IRType::Phi: {
+        LatticeValue res;
+        for (auto &[val, pred] : stmt.getPhiArgs()) {
+            if (isEdgeExecutable(pred, bb))
+                res = res.meet(getValue(val));
+        }
+        lowerValue(stmt.op1(), res);
         break;
     }
-    case IRType::PopCallArg: {
-        auto node = findOrMake(nodeMap, stmt->op1, stmt, Type::Output);
-        allDepNodes.push_back(node);
-        outputs.push_back(node);
+    case IRType::Assign: {
+        lowerValue(stmt.op1(), getValue(stmt.op2()));
         break;
     }
-    case IRType::PushCallArg: {
-        auto lhs = findOrMake(nodeMap, stmt->op1, stmt, Type::Output);
-        allDepNodes.insert(allDepNodes.end(), {lhs});
-        outputs.insert(outputs.end(), {lhs});
+    case IRType::Plus:
+    case IRType::Minus:
+    case IRType::Mul:
+    case IRType::Div: {
+        lowerValue(stmt.op1(),
+                   evaluateArithmetic(stmt.getIRType(), getValue(stmt.op2()),
+                                      getValue(stmt.op3())));
         break;
     }
-    case IRType::InvokeFunc: {
-        // Don't care
+    case IRType::Goto: {
+        flowWorklist.emplace_back(bb, cfg.findBlock(stmt.op1()));
         break;
     }
-    case IRType::Read: {
-        auto lhs = insertOrReplace(nodeMap, stmt->op1, stmt, Type::Input);
-        allDepNodes.insert(allDepNodes.end(), {lhs});
-        inputs.insert(inputs.end(), {lhs});
+    case IRType::BranchIf: {
+        LatticeValue lhs = getValue(stmt.op1());
+        LatticeValue rhs = getValue(stmt.op2());
+        if (lhs.isTop() || rhs.isTop())
+            break;
+
+        IRSB *target = cfg.findBlock(stmt.op3());
+        IRSB *next = cfg.getLayoutSuccessor(bb);
+        bool isConstant = lhs.isConstant() && rhs.isConstant();
+        bool isTaken = isConstant && evaluateBranch(stmt.getBranchType(),
+                                                    lhs.value, rhs.value);
+        if (!isConstant || isTaken)
+            flowWorklist.emplace_back(bb, target);
+        if ((!isConstant || !isTaken) && next != nullptr)
+            flowWorklist.emplace_back(bb, next);
         break;
     }
-    case IRType::Write: {
-        auto lhs = findOrMake(nodeMap, stmt->op1, stmt, Type::Output);
-        allDepNodes.insert(allDepNodes.end(), {lhs});
-        outputs.insert(outputs.end(), {lhs});
+    default: {
+        if (IROperand *def = stmt.getDefOperand())
+            lowerValue(*def, LatticeValue::makeBottom());
         break;
     }
     }
 }
 
-void IROptimizer::examineStmt(DepKey &key, Ptr<IRFunction> func,
-                              decltype(func->body.begin()) it)
+void SCCPSolver::rewrite()
 {
-    examineStmt(key, func, *it);
-}
+    for (auto &bb : cfg.getBlocks()) {
+        if (!executableBlocks[bb->id])
+            continue;
 
-void IROptimizer::searchBranchIf(DepKey &key, Ptr<IRFunction> func,
-                                 decltype(func->body.begin()) it)
-{
-    auto &[allDepNodes, nodeMap, inputs, outputs] = key;
+        for (size_t pos = bb->getFirstNonLabel(); pos < bb->stmts.size();
+             ++pos) {
+            IRStmtRef stmt = bb->getStmt(pos);
+            // Incoming values of phi functions are left as is, such that
+            // the SSA form stays conventional.
+            if (stmt.isPhi())
+                continue;
+
+            if (IROperand *def = stmt.getDefOperand();
+                def != nullptr && !stmt.hasSideEffects()) {
+                LatticeValue val = getValue(*def);
+                if (val.isConstant() &&
+                    !(stmt.isAssign() && stmt.op2().isConstant())) {
+                    IROperand var = *def;
+                    cfg.replaceStmt(
+                        bb.get(), pos,
+                        func.createAssignStmt(var, func.getConstant(val.value)));
+                    continue;
+                }
+            }
+
+            stmt.forEachUseOperand([&](IROperand &op) {
+                LatticeValue val = getValue(op);
+                if (val.isConstant() && !op.isConstant())
+                    op = func.getConstant(val.value);
+            });
+
+            if (stmt.isBranchIf() && stmt.op1().isConstant() &&
+                stmt.op2().isConstant()) {
+                if (evaluateBranch(stmt.getBranchType(),
+                                   func.getConstantValue(stmt.op1()),
+                                   func.getConstantValue(stmt.op2()))) {
+                    IROperand target = stmt.op3();
+                    cfg.replaceStmt(bb.get(), pos,
+                                    func.createGotoStmt(target));
+                }
+                else {
+                    cfg.eraseStmt(bb.get(), pos);
+                }
+                break;
+            }
+        }
+    }
+
+    cfg.removeUnreachableBlocks();
+
+    // Drop the incoming values of the edges just removed.
+    for (auto &bb : cfg.getBlocks()) {
+        for (size_t pos = bb->getFirstNonLabel();
+             pos < bb->stmts.size() && bb->getStmt(pos).isPhi(); ++pos) {
+            std::erase_if(bb->getStmt(pos).getPhiArgs(), [&](const auto &arg) {
+                return std::find(bb->preds.begin(), bb->preds.end(),
+                                 arg.second) == bb->preds.end();
+            });
+        }
+    }
+
+    removeDeadConstants();
 }
 
-DepKey IROptimizer::buildDependency(Ptr<IRFunction> func)
+void SCCPSolver::removeDeadConstants()
 {
-    DepKey key;
+    constexpr IRStmtID noDef = ~IRStmtID{0};
+    IRVec<size_t> useCnts(func.getNumVariables(), 0);
+    IRVec<IRStmtID> defs(func.getNumVariables(), noDef);
+    for (auto &bb : cfg.getBlocks()) {
+        for (IRStmtID id : bb->stmts) {
+            IRStmtRef stmt = func.getStmt(id);
+            stmt.forEachUseOperand([&](IROperand &op) {
+                if (op.isVariable())
+                    ++useCnts[op.getIndex()];
+            });
+            if (IROperand *def = stmt.getDefOperand(); def && def->isVariable())
+                defs[def->getIndex()] = id;
+        }
+    }
+
+    // Definitions of constants are side-effect free, and their uses have been
+    // replaced, except those by phi functions.
+    IRVec<IRStmtID> worklist;
+    std::unordered_set<IRStmtID> deadStmts;
+    auto tryKill = [&](IROperand var) {
+        if (!var.isVariable())
+            return;
+        IRStmtID def = defs[var.getIndex()];
+        if (def == noDef || useCnts[var.getIndex()] != 0 ||
+            func.getStmt(def).hasSideEffects() || !getValue(var).isConstant())
+            return;
+        if (deadStmts.insert(def).second)
+            worklist.push_back(def);
+    };
+    for (uint32_t i = 0; i < defs.size(); ++i)
+        tryKill(IROperand{IROperand::Kind::Variable, i});
 
-    for (auto it = func->body.begin(); it != func->body.end(); ++it) {
-        examineStmt(key, func, it);
+    while (!worklist.empty()) {
+        IRStmtRef stmt = func.getStmt(worklist.back());
+        worklist.pop_back();
+        stmt.forEachUseOperand([&](IROperand &op) {
+            if (!op.isVariable())
+                return;
+            --useCnts[op.getIndex()];
+            tryKill(op);
+        });
     }
 
-    return key;
+    if (deadStmts.empty())
+        return;
+    for (auto &bb : cfg.getBlocks()) {
+        std::erase_if(bb->stmts,
+                      [&](IRStmtID id) { return deadStmts.contains(id); });
+    }
 }
 
-void recursiveColor(DepNode *node)
+} // namespace
+
+void IROptimizer::constantPropagate(Ptr<IRFunction> func)
 {
-    // SPLC_LOG_WARN(nullptr, false)
-    //     << "processing node parents: " << node->var->getName();
-    // for (auto parent : node->parents) {
-    //     SPLC_LOG_DEBUG(nullptr, false)
-    //         << "`-" << parent->var->getName() << ", " << parent->isMarked();
-    // }
-    // TODO: output
-    node->setMarked();
-    for (auto parent : node->parents) {
-        if (parent->isUnmarked()) {
-            recursiveColor(parent);
+    IRCFG cfg{func};
+    IRSSA ssa{cfg};
+    ssa.construct();
+
+    SCCPSolver solver{cfg, ssa};
+    solver.solve();
+    solver.rewrite();
+
+    ssa.destruct();
+    cfg.writeBack();
+}
+
+//===----------------------------------------------------------------------===//
+//                          Local Value Numbering
+//===----------------------------------------------------------------------===//
+
+namespace {
+
+///
+/// \brief Value numbering over each basic block, replacing recomputed
+/// expressions with copies of the variables already holding them.
+///
+/// Expressions are simplified algebraically before being looked up, and
+/// additions of constants are reassociated so that `(x + 1) + 2` becomes
+/// `x + 3`. Loads are numbered as well, until memory may be written; a store
+/// is forwarded to the loads of the same address that follow it. Variables
+/// living in memory are never numbered, as they may be written through
+/// pointers.
+///
+class ValueNumbering {
+  public:
+    ValueNumbering(IRCFG &cfg_) : cfg{cfg_}, func{*cfg_.getFunction()} {}
+
+    void run();
+
+  private:
+    using ValueID = uint32_t;
+    static constexpr ValueID noValue = ~ValueID{0};
+
+    struct Value {
+        bool isConstant = false;
+        ASTSIntType constant = 0;
+        /// `base + offset` if computed by adding a constant to `base`
+        ValueID base = noValue;
+        ASTSIntType offset = 0;
+        /// Variables holding this value, the first one being canonical
+        IRVec<IROperand> holders;
+    };
+
+    struct ExprKey {
+        IRType irType;
+        ValueID lhs;
+        ValueID rhs;
+
+        bool operator==(const ExprKey &other) const noexcept = default;
+    };
+
+    struct ExprKeyHash {
+        size_t operator()(const ExprKey &key) const noexcept
+        {
+            return (static_cast<size_t>(key.irType) << 58) ^
+                   (static_cast<size_t>(key.lhs) << 29) ^ key.rhs;
         }
+    };
+
+    void runOnBlock(IRSB *bb);
+
+    void visitArithmetic(IRSB *bb, size_t pos);
+
+    ///
+    /// \brief Replace the statement at `pos` of `bb` with `var := val`.
+    /// \return false, leaving the statement as is, if no variable holds `val`.
+    ///
+    bool replaceWithCopy(IRSB *bb, size_t pos, IROperand var, ValueID val);
+
+    ValueID getValue(IROperand op);
+
+    ValueID getConstantValue(ASTSIntType constant);
+
+    ValueID createValue();
+
+    /// \return the operand to use for `val`: a constant, the canonical holder,
+    /// or an empty operand if no variable holds it anymore.
+    IROperand getOperand(ValueID val);
+
+    /// \brief Record that `var` now holds `val`.
+    void define(IROperand var, ValueID val);
+
+    bool isInMemory(IROperand op) const noexcept
+    {
+        return op.isVariable() && inMemory[op.getIndex()];
     }
-    for (auto child : node->children) {
-        if (child->isUnmarked()) {
-            recursiveColor(child);
-        }
+
+    /// \brief Forget all loads, after memory may have been written.
+    void clobberMemory() noexcept { loadValues.clear(); }
+
+    IRCFG &cfg;
+    IRFunction &func;
+    IRVec<bool> inMemory;
+
+    // State of the current block
+    IRVec<Value> values;
+    IRVec<ValueID> varValues; ///< Indexed by variable
+    IRVec<uint32_t> touchedVars;
+    std::unordered_map<ASTSIntType, ValueID> constantValues;
+    std::unordered_map<ExprKey, ValueID, ExprKeyHash> exprValues;
+    std::unordered_map<ValueID, ValueID> loadValues; ///< Address to value
+};
+
+void ValueNumbering::run()
+{
+    inMemory = findInMemoryVariables(func);
+    varValues.assign(func.getNumVariables(), noValue);
+    for (auto &bb : cfg.getBlocks()) {
+        runOnBlock(bb.get());
+
+        for (uint32_t var : touchedVars)
+            varValues[var] = noValue;
+        touchedVars.clear();
+        values.clear();
+        constantValues.clear();
+        exprValues.clear();
+        loadValues.clear();
     }
 }
 
-void color(DepNodeList &inputs, DepNodeList &outputs)
+ValueNumbering::ValueID ValueNumbering::createValue()
 {
-    for (auto &output : outputs) {
-        recursiveColor(output.get());
-    }
+    values.emplace_back();
+    return static_cast<ValueID>(values.size() - 1);
+}
 
-    for (auto &input : inputs) {
-        input->setMarked(); // retain expected behavior
+ValueNumbering::ValueID ValueNumbering::getConstantValue(ASTSIntType constant)
+{
+    auto [it, inserted] = constantValues.try_emplace(constant, noValue);
+    if (inserted) {
+        it->second = createValue();
+        values.back().isConstant = true;
+        values.back().constant = constant;
     }
+    return it->second;
 }
 
-void IROptimizer::removeUnusedStmts(Ptr<IRFunction> func)
+ValueNumbering::ValueID ValueNumbering::getValue(IROperand op)
 {
-    // using Type = DepNode::Type;
+    if (op.isConstant())
+        return getConstantValue(func.getConstantValue(op));
+    // Each read of a variable in memory may see a different value.
+    if (isInMemory(op))
+        return createValue();
 
-    auto [depNodes, nodeMap, inputs, outputs] = buildDependency(func);
-    IRSet<IRVar *> usedVars;
-    for (auto &depNode : outputs) {
-        usedVars.insert(depNode->var);
+    ValueID &val = varValues[op.getIndex()];
+    if (val == noValue) {
+        // Defined before the block
+        val = createValue();
+        values[val].holders.push_back(op);
+        touchedVars.push_back(op.getIndex());
     }
+    return val;
+}
 
-    IRSet<IRStmt *> usedStmts;
+IROperand ValueNumbering::getOperand(ValueID val)
+{
+    const Value &value = values[val];
+    if (value.isConstant)
+        return func.getConstant(value.constant);
+    return value.holders.empty() ? IROperand{} : value.holders.front();
+}
 
-    // mark from output to input
-    color(inputs, outputs);
-    for (const auto &node : depNodes) {
-        if (node->isMarked() || usedVars.contains(node->var)) {
-            usedStmts.insert(node->getStmt());
-        }
+void ValueNumbering::define(IROperand var, ValueID val)
+{
+    if (isInMemory(var)) {
+        clobberMemory();
+        return;
     }
 
-    IRVec<Ptr<IRStmt>> newBody;
+    ValueID &oldVal = varValues[var.getIndex()];
+    if (oldVal == noValue)
+        touchedVars.push_back(var.getIndex());
+    else
+        std::erase(values[oldVal].holders, var);
+    oldVal = val;
+    values[val].holders.push_back(var);
+}
 
-    for (auto &stmt : func->body) {
-        switch (stmt->getIRType()) {
-        case IRType::SetLabel:
-        case IRType::FuncDecl: {
-            // Don't care
-            newBody.push_back(stmt);
+bool ValueNumbering::replaceWithCopy(IRSB *bb, size_t pos, IROperand var,
+                                     ValueID val)
+{
+    IROperand op = getOperand(val);
+    if (!op)
+        return false;
+    cfg.replaceStmt(bb, pos, func.createAssignStmt(var, op));
+    define(var, val);
+    return true;
+}
+
+void ValueNumbering::runOnBlock(IRSB *bb)
+{
+    for (size_t pos = bb->getFirstNonLabel(); pos < bb->stmts.size(); ++pos) {
+        IRStmtRef stmt = bb->getStmt(pos);
+
+        // Read operands through the canonical holders of their values, which
+        // turns the variables copied from into dead temporaries.
+        if (!stmt.isAddrOf()) {
+            stmt.forEachUseOperand([&](IROperand &op) {
+                if (!op.isVariable() || isInMemory(op))
+                    return;
+                if (IROperand canonical = getOperand(getValue(op)))
+                    op = canonical;
+            });
+        }
+
+        switch (stmt.getIRType()) {
+        case IRType::Assign: {
+            define(stmt.op1(), getValue(stmt.op2()));
             break;
         }
-        case IRType::Assign:
-        case IRType::AddrOf:
-        case IRType::Deref:
-        case IRType::CopyToAddr:
         case IRType::Plus:
         case IRType::Minus:
         case IRType::Mul:
         case IRType::Div: {
-            if (usedStmts.contains(stmt.get())) {
-                newBody.push_back(stmt);
-            }
+            visitArithmetic(bb, pos);
             break;
         }
-        case IRType::Goto:
-        case IRType::BranchIf:
-        case IRType::Return:
-        case IRType::Alloc:
-        case IRType::PopCallArg:
-        case IRType::PushCallArg:
-        case IRType::InvokeFunc:
-        case IRType::Read:
-        case IRType::Write: {
-            // Don't care
-            newBody.push_back(stmt);
+        case IRType::AddrOf: {
+            // The address of a variable is keyed by the variable itself.
+            ExprKey key{IRType::AddrOf, stmt.op2().getBits(), noValue};
+            auto [it, inserted] = exprValues.try_emplace(key, noValue);
+            if (!inserted && replaceWithCopy(bb, pos, stmt.op1(), it->second))
+                break;
+            it->second = createValue();
+            define(stmt.op1(), it->second);
             break;
         }
+        case IRType::Deref: {
+            ValueID addr = getValue(stmt.op2());
+            auto it = loadValues.find(addr);
+            if (it != loadValues.end() &&
+                replaceWithCopy(bb, pos, stmt.op1(), it->second))
+                break;
+            ValueID val = createValue();
+            define(stmt.op1(), val);
+            loadValues[addr] = val;
+            break;
         }
+        case IRType::CopyToAddr: {
+            // The store may write through any pointer.
+            ValueID addr = getValue(stmt.op1());
+            ValueID val = getValue(stmt.op2());
+            clobberMemory();
+            loadValues[addr] = val;
+            break;
+        }
+        case IRType::InvokeFunc: {
+            clobberMemory();
+            define(stmt.op1(), createValue());
+            break;
+        }
+        default: {
+            if (IROperand *def = stmt.getDefOperand())
+                define(*def, createValue());
+            break;
+        }
+        }
+    }
+}
+
+void ValueNumbering::visitArithmetic(IRSB *bb, size_t pos)
+{
+    IRStmtRef stmt = bb->getStmt(pos);
+    IRType irType = stmt.getIRType();
+    IROperand def = stmt.op1();
+    IROperand lhsOp = stmt.op2();
+    IROperand rhsOp = stmt.op3();
+    ValueID lhs = getValue(lhsOp);
+    ValueID rhs = getValue(rhsOp);
+
+    auto isConstant = [&](ValueID val, ASTSIntType constant) {
+        return values[val].isConstant && values[val].constant == constant;
+    };
+    auto replaceWith = [&](IRType newType, IROperand op2, IROperand op3) {
+        cfg.replaceStmt(bb, pos,
+                        func.createArithmeticStmt(newType, def, op2, op3));
+    };
+
+    // Constant folding
+    if (values[lhs].isConstant && values[rhs].isConstant) {
+        LatticeValue res = evaluateArithmetic(
+            irType, LatticeValue::makeConstant(values[lhs].constant),
+            LatticeValue::makeConstant(values[rhs].constant));
+        if (res.isConstant() &&
+            replaceWithCopy(bb, pos, def, getConstantValue(res.value)))
+            return;
+    }
+
+    // Algebraic identities
+    switch (irType) {
+    case IRType::Plus: {
+        if (isConstant(rhs, 0) && replaceWithCopy(bb, pos, def, lhs))
+            return;
+        if (isConstant(lhs, 0) && replaceWithCopy(bb, pos, def, rhs))
+            return;
+        break;
+    }
+    case IRType::Minus: {
+        if (isConstant(rhs, 0) && replaceWithCopy(bb, pos, def, lhs))
+            return;
+        if (lhs == rhs &&
+            replaceWithCopy(bb, pos, def, getConstantValue(0)))
+            return;
+        break;
+    }
+    case IRType::Mul: {
+        if ((isConstant(lhs, 0) || isConstant(rhs, 0)) &&
+            replaceWithCopy(bb, pos, def, getConstantValue(0)))
+            return;
+        if (isConstant(rhs, 1) && replaceWithCopy(bb, pos, def, lhs))
+            return;
+        if (isConstant(lhs, 1) && replaceWithCopy(bb, pos, def, rhs))
+            return;
+        // Strength reduction: SIR has no shifts, but `x * 2` is `x + x` and
+        // `x * -1` is `0 - x`.
+        if (isConstant(lhs, 2) || isConstant(lhs, -1)) {
+            std::swap(lhs, rhs);
+            std::swap(lhsOp, rhsOp);
+        }
+        if (isConstant(rhs, 2)) {
+            replaceWith(IRType::Plus, lhsOp, lhsOp);
+            irType = IRType::Plus;
+            rhs = lhs;
+        }
+        else if (isConstant(rhs, -1)) {
+            replaceWith(IRType::Minus, func.getConstant(0), lhsOp);
+            irType = IRType::Minus;
+            rhs = lhs;
+            lhs = getConstantValue(0);
+        }
+        break;
+    }
+    case IRType::Div: {
+        if (isConstant(rhs, 1) && replaceWithCopy(bb, pos, def, lhs))
+            return;
+        break;
+    }
+    default:
+        splc_unreachable();
+    }
+
+    // Additions of constants are keyed as `base + offset`, and chains of them
+    // are folded into a single addition to the first base still held.
+    std::optional<ASTSIntType> offset;
+    ValueID base = noValue;
+    bool reassociated = false;
+    if (irType == IRType::Plus && values[lhs].isConstant)
+        std::swap(lhs, rhs);
+    if ((irType == IRType::Plus || irType == IRType::Minus) &&
+        values[rhs].isConstant && !values[lhs].isConstant) {
+        base = lhs;
+        offset = irType == IRType::Plus ? values[rhs].constant
+                                        : -values[rhs].constant;
+        ValueID outerBase = values[base].base;
+        if (outerBase != noValue && getOperand(outerBase)) {
+            LatticeValue sum = evaluateArithmetic(
+                IRType::Plus, LatticeValue::makeConstant(values[base].offset),
+                LatticeValue::makeConstant(*offset));
+            if (sum.isConstant()) {
+                base = outerBase;
+                offset = sum.value;
+                reassociated = true;
+            }
+        }
+        if (*offset == 0 && replaceWithCopy(bb, pos, def, base))
+            return;
+        lhs = base;
+        rhs = getConstantValue(*offset);
+        irType = IRType::Plus;
+    }
+
+    // Commutative operations are keyed with their operands in order.
+    if ((irType == IRType::Plus || irType == IRType::Mul) && lhs > rhs)
+        std::swap(lhs, rhs);
+
+    ExprKey key{irType, lhs, rhs};
+    auto [it, inserted] = exprValues.try_emplace(key, noValue);
+    if (!inserted && replaceWithCopy(bb, pos, def, it->second))
+        return;
+
+    if (reassociated) {
+        IROperand baseOp = getOperand(base);
+        if (*offset < 0 && *offset != std::numeric_limits<int32_t>::min())
+            replaceWith(IRType::Minus, baseOp, func.getConstant(-*offset));
+        else
+            replaceWith(IRType::Plus, baseOp, func.getConstant(*offset));
+    }
+
+    ValueID val = createValue();
+    it->second = val;
+    if (offset) {
+        values[val].base = base;
+        values[val].offset = *offset;
+    }
+    define(def, val);
+}
+
+} // namespace
+
+void IROptimizer::optimizeArithmetic(Ptr<IRFunction> func)
+{
+    IRCFG cfg{func};
+    ValueNumbering{cfg}.run();
+    cfg.writeBack();
+}
+
+//===----------------------------------------------------------------------===//
+//                           Loop Optimizations
+//===----------------------------------------------------------------------===//
+
+namespace {
+
+///
+/// \brief Hoists the invariant computations of each loop into its preheader,
+/// and strength-reduces the multiplications of induction variables.
+///
+/// A basic induction variable `i` is only defined in the loop by `i := i + c`,
+/// directly or through a temporary. A multiplication `j := i * k` is then
+/// replaced by a copy of a new variable set to `i * k` in the preheader and
+/// stepped by `c * k` after each update of `i`. Additions of invariants to
+/// such variables, as in address computations `p := base + j`, are reduced
+/// the same way.
+///
+/// Loops are processed from the innermost, the loops being found again after
+/// each one so that the code hoisted into a preheader can leave the enclosing
+/// loops as well. Loops entered from more than one block are left alone.
+///
+class LoopOptimizer {
+  public:
+    LoopOptimizer(IRCFG &cfg_)
+        : cfg{cfg_}, func{*cfg_.getFunction()}, liveness{cfg_},
+          ivPrefix{func.internName("iv_")}
+    {
     }
 
-    func->body = newBody;
+    void run();
+
+  private:
+    /// Update of a basic induction variable
+    struct Induction {
+        IRSB *bb;
+        IRStmtID update;
+        ASTSIntType step;
+    };
+
+    /// Variable kept equal to `iv * factor` plus an invariant
+    struct Reduction {
+        IROperand var;
+        IROperand iv;
+        ASTSIntType factor;
+    };
+
+    void processLoop(const IRLoop &loop);
+
+    void countDefs(const IRLoop &loop);
+
+    bool isInvariant(IROperand op) const noexcept
+    {
+        return op.isConstant() ||
+               (op.isVariable() && !inMemory[op.getIndex()] &&
+                defCounts[op.getIndex()] == 0);
+    }
+
+    bool canHoist(const IRLoop &loop, IRSB *bb, IRStmtRef stmt);
+
+    /// \brief Move the invariant statements of `loop` into `hoisted`.
+    void hoistInvariants(const IRLoop &loop, IRVec<IRStmtID> &hoisted);
+
+    /// \brief Find the basic induction variables of `loop`.
+    void findInductions(const IRLoop &loop);
+
+    /// \return the step of `var` if `stmt` is `var := var + c`.
+    std::optional<ASTSIntType> getStep(IRStmtRef stmt, IROperand var);
+
+    ///
+    /// \brief Reduce the multiplications of induction variables in `loop`,
+    /// adding the initializations of the new variables to `inits`.
+    ///
+    void reduceInductions(const IRLoop &loop, IRVec<IRStmtID> &inits);
+
+    /// \return the block the loop is entered from, if it is unique.
+    IRSB *findEntering(const IRLoop &loop);
+
+    /// \return a block ending with a jump to the header of `loop`, created
+    /// on the edge from `entering` if needed.
+    IRSB *getPreheader(const IRLoop &loop, IRSB *entering);
+
+    IRCFG &cfg;
+    IRFunction &func;
+    IRLiveness liveness;
+    IRNameID ivPrefix;
+
+    IRVec<bool> inMemory;
+    IRVec<uint32_t> defCounts; ///< Definitions in the current loop
+    std::unordered_map<uint32_t, Induction> inductions;
+    /// New variables to step after the update of each induction variable
+    std::unordered_map<uint32_t, IRVec<Reduction>> steppedVars;
+};
+
+void LoopOptimizer::run()
+{
+    inMemory = findInMemoryVariables(func);
+
+    std::unordered_set<const IRSB *> processed;
+    IRLoopInfo loopInfo;
+    while (true) {
+        loopInfo.recalculate(cfg);
+        auto &loops = loopInfo.getLoops();
+        auto it = std::ranges::find_if(loops, [&](const IRLoop &loop) {
+            return !processed.contains(loop.header);
+        });
+        if (it == loops.end())
+            break;
+        processed.insert(it->header);
+        processLoop(*it);
+    }
 }
 
-void getInitialConstants(IRVec<DepNode *> &initials, DepNode *node)
+void LoopOptimizer::countDefs(const IRLoop &loop)
 {
-    if (node->children.empty()) {
-        initials.push_back(node);
+    defCounts.assign(func.getNumVariables(), 0);
+    for (IRSB *bb : loop.blocks) {
+        for (IRStmtID id : bb->stmts) {
+            if (IROperand *def = func.getStmt(id).getDefOperand();
+                def && def->isVariable())
+                ++defCounts[def->getIndex()];
+        }
     }
-    for (auto parent : node->parents) {
-        getInitialConstants(initials, parent);
+}
+
+IRSB *LoopOptimizer::findEntering(const IRLoop &loop)
+{
+    const IRDomTree &domTree = cfg.getDomTree();
+    IRSB *entering = nullptr;
+    for (IRSB *pred : loop.header->preds) {
+        if (loop.contains(pred) || !domTree.isReachable(pred))
+            continue;
+        if (entering != nullptr)
+            return nullptr;
+        entering = pred;
     }
+    return entering;
 }
 
-void constantPropagate(DepNode *node)
+IRSB *LoopOptimizer::getPreheader(const IRLoop &loop, IRSB *entering)
 {
-    // TODO
-    if (node->stmt == nullptr)
+    if (entering->succs.size() == 1)
+        return entering;
+    return cfg.splitEdge(entering, loop.header);
+}
+
+void LoopOptimizer::processLoop(const IRLoop &loop)
+{
+    IRSB *entering = findEntering(loop);
+    if (entering == nullptr)
         return;
-    switch (node->stmt->getIRType()) {
-    case IRType::SetLabel:
-    case IRType::FuncDecl: {
-        break;
+
+    liveness.recalculate();
+    countDefs(loop);
+
+    IRVec<IRStmtID> hoisted;
+    hoistInvariants(loop, hoisted);
+    reduceInductions(loop, hoisted);
+    if (hoisted.empty())
+        return;
+
+    // The edges may change from here on, so liveness is no longer valid.
+    IRSB *preheader = getPreheader(loop, entering);
+    for (IRStmtID id : hoisted) {
+        size_t pos = preheader->stmts.size();
+        if (preheader->getTerminator())
+            --pos;
+        cfg.insertStmt(preheader, pos, id);
     }
-    case IRType::Assign: {
-        splc_dbgassert(node->parents.size() == 1);
-        for (auto parent : node->parents) {
-            if (parent->stmt == nullptr)
+}
+
+bool LoopOptimizer::canHoist(const IRLoop &loop, IRSB *bb, IRStmtRef stmt)
+{
+    if (!stmt.isArithmetic() && !stmt.isAddrOf())
+        return false;
+    IROperand def = stmt.op1();
+    size_t idx = def.getIndex();
+    if (inMemory[idx] || defCounts[idx] != 1)
+        return false;
+
+    // The address of a variable never changes.
+    if (stmt.isArithmetic() &&
+        (!isInvariant(stmt.op2()) || !isInvariant(stmt.op3())))
+        return false;
+    // Hoisting must not make a division by zero happen.
+    if (stmt.getIRType() == IRType::Div &&
+        (!stmt.op3().isConstant() || func.getConstantValue(stmt.op3()) == 0))
+        return false;
+
+    // The value before the loop must not be read in it.
+    if (liveness.getLiveIn(loop.header).test(idx))
+        return false;
+
+    // After the loop, the value must either be dead or have been computed
+    // on every path leaving the loop.
+    const IRDomTree &domTree = cfg.getDomTree();
+    for (IRSB *exiting : loop.blocks) {
+        for (IRSB *succ : exiting->succs) {
+            if (loop.contains(succ) || !liveness.getLiveIn(succ).test(idx))
                 continue;
-            if (parent->stmt->isArithmetic()) {
-                SPLC_LOG_WARN(nullptr, false)
-                    << "converting to arithmetic: " << node->var->getName();
-                IRStmt::assignmentToArithmetic(node->stmt, parent->stmt);
-            }
-            else if (parent->stmt->isAssign()) {
-                SPLC_LOG_WARN(nullptr, false)
-                    << "concatenating assignments: " << node->var->getName();
-                IRStmt::concatAssign(node->stmt, parent->stmt);
+            if (!domTree.dominates(bb, exiting))
+                return false;
+        }
+    }
+    return true;
+}
+
+void LoopOptimizer::hoistInvariants(const IRLoop &loop,
+                                    IRVec<IRStmtID> &hoisted)
+{
+    // Hoisting a statement can make the statements reading its result
+    // invariant, which are thus always hoisted after it.
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (IRSB *bb : loop.blocks) {
+            for (size_t pos = bb->getFirstNonLabel(); pos < bb->stmts.size();) {
+                IRStmtRef stmt = bb->getStmt(pos);
+                if (!canHoist(loop, bb, stmt)) {
+                    ++pos;
+                    continue;
+                }
+                defCounts[stmt.op1().getIndex()] = 0;
+                hoisted.push_back(bb->stmts[pos]);
+                cfg.eraseStmt(bb, pos);
+                changed = true;
             }
         }
-        break;
     }
-    case IRType::Plus:
-    case IRType::Minus:
-    case IRType::Mul:
-    case IRType::Div: {
-        // const propagation
-        splc_dbgassert(node->parents.size() == 2);
-        SPLC_LOG_WARN(nullptr, false)
-            << "propagating: " << node->var->getName();
-        IRVar *v1 = node->stmt->op2.get();
-        IRVar *v2 = node->stmt->op3.get();
-        if (!(v1->isConst() && v2->isConst()))
-            break;
-        IRStmt::arithmeticToConstAssign(node->stmt, v1, v2);
-        break;
+}
+
+std::optional<ASTSIntType> LoopOptimizer::getStep(IRStmtRef stmt,
+                                                  IROperand var)
+{
+    if (stmt.getIRType() == IRType::Plus) {
+        if (stmt.op2() == var && stmt.op3().isConstant())
+            return func.getConstantValue(stmt.op3());
+        if (stmt.op3() == var && stmt.op2().isConstant())
+            return func.getConstantValue(stmt.op2());
     }
-    case IRType::AddrOf:
-    case IRType::Deref:
-    case IRType::CopyToAddr: {
-        // TODO
-        break;
+    else if (stmt.getIRType() == IRType::Minus) {
+        if (stmt.op2() == var && stmt.op3().isConstant())
+            return -func.getConstantValue(stmt.op3());
     }
-    case IRType::Goto:
-    case IRType::BranchIf:
-    case IRType::Return:
-    case IRType::Alloc:
-    case IRType::PopCallArg:
-    case IRType::PushCallArg:
-    case IRType::InvokeFunc:
-    case IRType::Read:
-    case IRType::Write: {
-        break;
-    } break;
+    return std::nullopt;
+}
+
+void LoopOptimizer::findInductions(const IRLoop &loop)
+{
+    inductions.clear();
+    for (IRSB *bb : loop.blocks) {
+        for (size_t pos = bb->getFirstNonLabel(); pos < bb->stmts.size();
+             ++pos) {
+            IRStmtRef stmt = bb->getStmt(pos);
+            IROperand *def = stmt.getDefOperand();
+            if (def == nullptr || inMemory[def->getIndex()] ||
+                defCounts[def->getIndex()] != 1)
+                continue;
+
+            std::optional<ASTSIntType> step = getStep(stmt, *def);
+            // `t := i + c; i := t`, as generated for `i = i + c`
+            IROperand tmp = stmt.op2();
+            if (!step && stmt.isAssign() && tmp.isVariable() &&
+                !inMemory[tmp.getIndex()] && defCounts[tmp.getIndex()] == 1) {
+                for (size_t prev = pos; prev-- > bb->getFirstNonLabel();) {
+                    IRStmtRef prevStmt = bb->getStmt(prev);
+                    if (IROperand *prevDef = prevStmt.getDefOperand();
+                        prevDef && *prevDef == tmp) {
+                        step = getStep(prevStmt, *def);
+                        break;
+                    }
+                }
+            }
+            if (step)
+                inductions[def->getIndex()] = {bb, bb->stmts[pos], *step};
+        }
     }
 }
 
-void IROptimizer::constantPropagate(Ptr<IRFunction> func)
+void LoopOptimizer::reduceInductions(const IRLoop &loop,
+                                     IRVec<IRStmtID> &inits)
 {
-    // TODO: basic const propagation
-    // using Type = DepNode::Type;
+    findInductions(loop);
+    if (inductions.empty())
+        return;
+
+    auto fitsInt32 = [](ASTSIntType val) {
+        return val >= std::numeric_limits<int32_t>::min() &&
+               val <= std::numeric_limits<int32_t>::max();
+    };
+    auto isCandidate = [&](IROperand def) {
+        return def.isVariable() && !inMemory[def.getIndex()] &&
+               defCounts[def.getIndex()] == 1 &&
+               !inductions.contains(def.getIndex());
+    };
+    auto createVar = [&](IROperand like) {
+        return func.createVariable(
+            ivPrefix, static_cast<uint32_t>(func.getNumVariables()),
+            func.getVariable(like).type);
+    };
 
-    auto [depNodes, nodeMap, inputs, outputs] = buildDependency(func);
+    steppedVars.clear();
+    for (IRSB *bb : loop.blocks) {
+        // Reductions computed in this block from the current value of their
+        // induction variable
+        std::unordered_map<uint32_t, Reduction> available;
+        for (size_t pos = bb->getFirstNonLabel(); pos < bb->stmts.size();
+             ++pos) {
+            IRStmtRef stmt = bb->getStmt(pos);
+            for (auto &[ivIdx, induction] : inductions) {
+                if (induction.update == bb->stmts[pos]) {
+                    std::erase_if(available, [&](const auto &entry) {
+                        return entry.second.iv.getIndex() == ivIdx;
+                    });
+                }
+            }
+            if (!stmt.isArithmetic() || !isCandidate(stmt.op1()))
+                continue;
 
-    // // traverse dependency graph for each constant variable
-    // IRVec<DepNode *> initials;
+            IROperand def = stmt.op1();
+            IROperand lhs = stmt.op2();
+            IROperand rhs = stmt.op3();
+            if (stmt.getIRType() == IRType::Mul) {
+                // j := i * k
+                if (lhs.isConstant())
+                    std::swap(lhs, rhs);
+                if (!lhs.isVariable() || !rhs.isConstant())
+                    continue;
+                auto it = inductions.find(lhs.getIndex());
+                if (it == inductions.end())
+                    continue;
+                ASTSIntType factor = func.getConstantValue(rhs);
+                if (!fitsInt32(factor * it->second.step))
+                    continue;
 
-    // for (auto &node : outputs) {
-    //     getInitialConstants(initials, node.get());
-    // }
+                IROperand var = createVar(def);
+                inits.push_back(
+                    func.createArithmeticStmt(IRType::Mul, var, lhs, rhs));
+                cfg.replaceStmt(bb, pos, func.createAssignStmt(def, var));
+                Reduction reduction{var, lhs, factor};
+                steppedVars[lhs.getIndex()].push_back(reduction);
+                available[def.getIndex()] = reduction;
+            }
+            else if (stmt.getIRType() == IRType::Plus) {
+                // p := base + j
+                if (!lhs.isVariable() || !available.contains(lhs.getIndex()))
+                    std::swap(lhs, rhs);
+                if (!lhs.isVariable() || !isInvariant(rhs))
+                    continue;
+                auto it = available.find(lhs.getIndex());
+                if (it == available.end())
+                    continue;
+
+                IROperand var = createVar(def);
+                inits.push_back(func.createArithmeticStmt(
+                    IRType::Plus, var, rhs, it->second.var));
+                cfg.replaceStmt(bb, pos, func.createAssignStmt(def, var));
+                Reduction reduction{var, it->second.iv, it->second.factor};
+                steppedVars[reduction.iv.getIndex()].push_back(reduction);
+                available[def.getIndex()] = reduction;
+            }
+        }
+    }
 
-    // for (auto node : initials) {
-    //     SPLC_LOG_WARN(nullptr, false) << "initials: " <<
-    //     node->var->getName();
-    // }
-    IRSet<DepNode *> visited;
-    for (auto &initial : depNodes) {
-        if (!visited.contains(initial.get())) {
-            SPLC_LOG_DEBUG(nullptr, false) << "depnode at " << initial.get();
-            SIR::constantPropagate(initial.get());
-            visited.insert(initial.get());
+    // Step the new variables right after their induction variable.
+    for (auto &[ivIdx, reductions] : steppedVars) {
+        const Induction &induction = inductions[ivIdx];
+        auto it = std::ranges::find(induction.bb->stmts, induction.update);
+        size_t pos = static_cast<size_t>(it - induction.bb->stmts.begin()) + 1;
+        for (auto &reduction : reductions) {
+            ASTSIntType delta = reduction.factor * induction.step;
+            cfg.insertStmt(induction.bb, pos++,
+                           func.createArithmeticStmt(IRType::Plus,
+                                                     reduction.var,
+                                                     reduction.var,
+                                                     func.getConstant(delta)));
         }
     }
 }
 
-void IROptimizer::optimizeArithmetic(Ptr<IRFunction> func)
+} // namespace
+
+void IROptimizer::optimizeLoops(Ptr<IRFunction> func)
 {
-    // TODO
+    IRCFG cfg{func};
+    LoopOptimizer{cfg}.run();
+    cfg.writeBack();
 }
 
 void IROptimizer::optimizeFunction(Ptr<IRFunction> func)
 {
-    // TODO:
-    constantPropagate(func);
-    // optimizeArithmetic(func);
-    removeUnusedStmts(func);
+    IRPassManager::createDefault().run(func);
 }
 
-void IROptimizer::optimizeProgram(Ptr<IRProgram> prog)
+void IROptimizer::optimizeProgram(Ptr<IRProgram> prog, unsigned numThreads)
 {
-    // TODO:
-    for (auto &func : prog->funcMap) {
-        optimizeFunction(func.second);
-    }
+    IRPassManager pm = IRPassManager::createDefault();
+    pm.setNumThreads(numThreads);
+    pm.run(*prog);
 }
 
 } // namespace splc::SIR
\ No newline at end of file
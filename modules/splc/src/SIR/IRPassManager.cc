@@ -0,0 +1,224 @@
+#include "SIR/IRPassManager.hh"
+#include "SIR/IRInliner.hh"
+#include "SIR/IROptimizer.hh"
+
+#include <atomic>
+#include <iomanip>
+#include <thread>
+
+namespace splc::SIR {
+
+namespace {
+
+/// \return a hash of the statements in the body of `func`, used to detect
+/// whether a round of the pipeline has changed it.
+size_t hashBody(IRFunction &func) noexcept
+{
+    size_t seed = func.body.size();
+    auto combine = [&](size_t val) {
+        seed ^= val + 0x9e3779b97f4a7c15ULL + (seed << 6) + (seed >> 2);
+    };
+    for (IRStmtID id : func.body) {
+        IRStmtRef stmt = func.getStmt(id);
+        combine(static_cast<size_t>(stmt.getIRType()) << 8 |
+                static_cast<size_t>(stmt.getBranchType()));
+        combine(stmt.op1().getBits());
+        combine(stmt.op2().getBits());
+        combine(stmt.op3().getBits());
+    }
+    return seed;
+}
+
+} // namespace
+
+IRPassManager &IRPassManager::addPass(IRIDType name, PassFn fn)
+{
+    splc_assert(!hasPass(name)) << "SIR pass registered twice: " << name;
+    passes.push_back(Pass{std::move(name), std::move(fn), nullptr});
+    stats.emplace_back();
+    return *this;
+}
+
+IRPassManager &IRPassManager::addProgramPass(IRIDType name, ProgramPassFn fn)
+{
+    splc_assert(!hasPass(name)) << "SIR pass registered twice: " << name;
+    passes.push_back(Pass{std::move(name), nullptr, std::move(fn)});
+    stats.emplace_back();
+    return *this;
+}
+
+bool IRPassManager::hasPass(StrRef name) const noexcept
+{
+    return std::ranges::any_of(
+        passes, [&](const Pass &pass) { return pass.name == name; });
+}
+
+bool IRPassManager::setEnabled(StrRef name, bool enabled)
+{
+    for (auto &pass : passes) {
+        if (pass.name == name) {
+            pass.enabled = enabled;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool IRPassManager::isEnabled(StrRef name) const noexcept
+{
+    return std::ranges::any_of(passes, [&](const Pass &pass) {
+        return pass.name == name && pass.enabled;
+    });
+}
+
+void IRPassManager::run(IRProgram &program)
+{
+    using Clock = std::chrono::steady_clock;
+
+    auto countStmts = [&]() {
+        long long numStmts = 0;
+        for (auto &[name, func] : program.funcMap)
+            numStmts += static_cast<long long>(func->body.size());
+        return numStmts;
+    };
+    for (size_t i = 0; i < passes.size(); ++i) {
+        if (!passes[i].programFn || !passes[i].enabled)
+            continue;
+
+        long long numBefore = countStmts();
+        auto start = Clock::now();
+        passes[i].programFn(program);
+        auto end = Clock::now();
+
+        ++stats[i].numRuns;
+        stats[i].time += end - start;
+        stats[i].stmtDelta += countStmts() - numBefore;
+    }
+
+    IRVec<Ptr<IRFunction>> funcs;
+    funcs.reserve(program.funcMap.size());
+    for (auto &[name, func] : program.funcMap)
+        funcs.push_back(func);
+
+    unsigned workerCnt = std::min<size_t>(numThreads, funcs.size());
+    if (workerCnt <= 1) {
+        IRVec<PassStats> localStats(passes.size());
+        for (auto &func : funcs)
+            runOnFunction(func, localStats);
+        mergeStats(localStats);
+        return;
+    }
+
+    // Each worker keeps its own statistics, merged once all have finished.
+    IRVec<IRVec<PassStats>> workerStats(workerCnt,
+                                        IRVec<PassStats>(passes.size()));
+    std::atomic<size_t> nextFunc = 0;
+    std::vector<std::thread> workers;
+    workers.reserve(workerCnt);
+    for (unsigned w = 0; w < workerCnt; ++w) {
+        workers.emplace_back([&, w]() {
+            for (size_t i = nextFunc++; i < funcs.size(); i = nextFunc++)
+                runOnFunction(funcs[i], workerStats[w]);
+        });
+    }
+    for (auto &t : workers) {
+        t.join();
+    }
+
+    for (auto &localStats : workerStats)
+        mergeStats(localStats);
+}
+
+void IRPassManager::run(Ptr<IRFunction> func)
+{
+    IRVec<PassStats> localStats(passes.size());
+    runOnFunction(func, localStats);
+    mergeStats(localStats);
+}
+
+void IRPassManager::runOnFunction(const Ptr<IRFunction> &func,
+                                  IRVec<PassStats> &localStats) const
+{
+    using Clock = std::chrono::steady_clock;
+
+    size_t numIterations = fixpoint ? maxIterations : 1;
+    size_t hash = fixpoint ? hashBody(*func) : 0;
+    for (size_t iter = 0; iter < numIterations; ++iter) {
+        for (size_t i = 0; i < passes.size(); ++i) {
+            if (passes[i].programFn || !passes[i].enabled)
+                continue;
+
+            size_t numBefore = func->body.size();
+            auto start = Clock::now();
+            passes[i].fn(func);
+            auto end = Clock::now();
+
+            PassStats &passStats = localStats[i];
+            ++passStats.numRuns;
+            passStats.time += end - start;
+            passStats.stmtDelta += static_cast<long long>(func->body.size()) -
+                                   static_cast<long long>(numBefore);
+        }
+
+        if (fixpoint) {
+            size_t newHash = hashBody(*func);
+            if (newHash == hash)
+                break;
+            hash = newHash;
+        }
+    }
+
+    func->compact();
+}
+
+void IRPassManager::mergeStats(const IRVec<PassStats> &localStats) noexcept
+{
+    for (size_t i = 0; i < stats.size(); ++i) {
+        stats[i].numRuns += localStats[i].numRuns;
+        stats[i].time += localStats[i].time;
+        stats[i].stmtDelta += localStats[i].stmtDelta;
+    }
+}
+
+void IRPassManager::clearStats() noexcept
+{
+    std::ranges::fill(stats, PassStats{});
+}
+
+void IRPassManager::printStats(std::ostream &os) const
+{
+    using std::chrono::duration;
+
+    size_t nameWidth = 4;
+    for (auto &pass : passes)
+        nameWidth = std::max(nameWidth, pass.name.size());
+
+    os << std::left << std::setw(static_cast<int>(nameWidth)) << "pass"
+       << std::right << std::setw(8) << "runs" << std::setw(12) << "time (ms)"
+       << std::setw(10) << "stmts" << "\n";
+    for (size_t i = 0; i < passes.size(); ++i) {
+        const PassStats &passStats = stats[i];
+        double ms = duration<double, std::milli>(passStats.time).count();
+        os << std::left << std::setw(static_cast<int>(nameWidth))
+           << passes[i].name << std::right << std::setw(8) << passStats.numRuns
+           << std::setw(12) << std::fixed << std::setprecision(3) << ms
+           << std::setw(10) << std::showpos << passStats.stmtDelta
+           << std::noshowpos << (passes[i].enabled ? "" : "  (disabled)")
+           << "\n";
+    }
+}
+
+IRPassManager IRPassManager::createDefault()
+{
+    IRPassManager pm;
+    pm.addProgramPass("inline",
+                      [](IRProgram &program) { IRInliner{program}.run(); });
+    pm.addPass("constprop", &IROptimizer::constantPropagate);
+    pm.addPass("lvn", &IROptimizer::optimizeArithmetic);
+    pm.addPass("loops", &IROptimizer::optimizeLoops);
+    pm.addPass("dce", &IROptimizer::removeUnusedStmts);
+    pm.addPass("simplify-jumps", &IROptimizer::simplifyJumps);
+    return pm;
+}
+
+} // namespace splc::SIR
@@ -0,0 +1,195 @@
+#include "SIR/IRSSA.hh"
+
+#include <algorithm>
+
+namespace splc::SIR {
+
+namespace {
+
+constexpr size_t npos = static_cast<size_t>(-1);
+constexpr IRNameID noName = ~IRNameID{0};
+
+struct VarInfo {
+    IRVec<IRSB *> defBlocks;
+    size_t lastDefBlock = npos;
+    bool isGlobal = false; ///< Used in a block before being defined there
+    bool isInMemory = false;
+    IRNameID versionPrefix = noName; ///< Interned on the first definition
+    IRVec<IROperand> versions;       ///< Stack of reaching definitions
+};
+
+} // namespace
+
+void IRSSA::construct()
+{
+    cfg.removeUnreachableBlocks();
+    const IRDomTree &domTree = cfg.getDomTree();
+    auto &blocks = cfg.getBlocks();
+    IRFunction &func = *cfg.getFunction();
+
+    // Collect where the variables are defined and whether they are live
+    // across blocks. Variables are indexed as in the table of the function.
+    numOrigVars = func.getNumVariables();
+    origins.clear();
+    IRVec<VarInfo> vars(numOrigVars);
+    auto findVar = [&](IROperand var) -> size_t {
+        return var.isVariable() ? var.getIndex() : npos;
+    };
+
+    for (auto &bb : blocks) {
+        for (IRStmtID id : bb->stmts) {
+            IRStmtRef stmt = func.getStmt(id);
+            if (stmt.isAddrOf()) {
+                if (size_t i = findVar(stmt.op2()); i != npos)
+                    vars[i].isInMemory = true;
+            }
+            else if (stmt.isAlloc()) {
+                if (size_t i = findVar(stmt.op1()); i != npos)
+                    vars[i].isInMemory = true;
+            }
+            stmt.forEachUseOperand([&](IROperand &op) {
+                if (size_t i = findVar(op);
+                    i != npos && vars[i].lastDefBlock != bb->id)
+                    vars[i].isGlobal = true;
+            });
+            if (IROperand *def = stmt.getDefOperand()) {
+                if (size_t i = findVar(*def);
+                    i != npos && vars[i].lastDefBlock != bb->id) {
+                    vars[i].defBlocks.push_back(bb.get());
+                    vars[i].lastDefBlock = bb->id;
+                }
+            }
+        }
+    }
+
+    // Place phi functions on the iterated dominance frontiers.
+    IRVec<size_t> hasPhi(blocks.size(), npos);
+    IRVec<size_t> hasWork(blocks.size(), npos);
+    IRVec<IRSB *> worklist;
+    for (size_t i = 0; i < vars.size(); ++i) {
+        VarInfo &info = vars[i];
+        if (!info.isGlobal || info.isInMemory)
+            continue;
+
+        worklist = info.defBlocks;
+        for (IRSB *bb : worklist)
+            hasWork[bb->id] = i;
+        while (!worklist.empty()) {
+            IRSB *bb = worklist.back();
+            worklist.pop_back();
+            for (IRSB *join : domTree.getFrontier(bb)) {
+                if (hasPhi[join->id] == i)
+                    continue;
+                hasPhi[join->id] = i;
+                IROperand var{IROperand::Kind::Variable,
+                              static_cast<uint32_t>(i)};
+                cfg.insertStmt(join, join->getFirstNonLabel(),
+                               func.createPhiStmt(var));
+                if (hasWork[join->id] != i) {
+                    hasWork[join->id] = i;
+                    worklist.push_back(join);
+                }
+            }
+        }
+    }
+
+    // Rename along the dominator tree. Each definition pushes a new version,
+    // which is popped when the walk leaves the block.
+    auto findPromoted = [&](IROperand var) -> size_t {
+        size_t i = findVar(var);
+        if (i == npos || i >= numOrigVars || vars[i].isInMemory)
+            return npos;
+        return i;
+    };
+    auto getReaching = [&](size_t i) -> IROperand {
+        auto &versions = vars[i].versions;
+        return versions.empty()
+                   ? IROperand{IROperand::Kind::Variable,
+                               static_cast<uint32_t>(i)}
+                   : versions.back();
+    };
+
+    uint32_t versionCnt = 0;
+    IRVec<size_t> defLog;
+    IRVec<size_t> defLogMark(blocks.size(), 0);
+    IRVec<IRPair<IRSB *, bool>> stack;
+    stack.emplace_back(cfg.getEntry(), false);
+    while (!stack.empty()) {
+        auto [bb, isLeaving] = stack.back();
+        stack.pop_back();
+        if (isLeaving) {
+            while (defLog.size() > defLogMark[bb->id]) {
+                vars[defLog.back()].versions.pop_back();
+                defLog.pop_back();
+            }
+            continue;
+        }
+        defLogMark[bb->id] = defLog.size();
+        stack.emplace_back(bb, true);
+
+        for (IRStmtID id : bb->stmts) {
+            IRStmtRef stmt = func.getStmt(id);
+            if (!stmt.isPhi()) {
+                stmt.forEachUseOperand([&](IROperand &op) {
+                    if (size_t i = findPromoted(op); i != npos)
+                        op = getReaching(i);
+                });
+            }
+            IROperand *def = stmt.getDefOperand();
+            if (def == nullptr)
+                continue;
+            if (size_t i = findPromoted(*def); i != npos) {
+                VarInfo &info = vars[i];
+                if (info.versionPrefix == noName)
+                    info.versionPrefix =
+                        func.internName(func.getOperandName(*def) + ".");
+                IROperand version =
+                    func.createVariable(info.versionPrefix, ++versionCnt,
+                                        func.getVariable(*def).type);
+                origins.push_back(*def);
+                *def = version;
+                info.versions.push_back(version);
+                defLog.push_back(i);
+            }
+        }
+
+        for (IRSB *succ : bb->succs) {
+            for (size_t pos = succ->getFirstNonLabel();
+                 pos < succ->stmts.size() && succ->getStmt(pos).isPhi();
+                 ++pos) {
+                IRStmtRef phi = succ->getStmt(pos);
+                size_t i = findPromoted(getOrigin(phi.op1()));
+                phi.getPhiArgs().emplace_back(getReaching(i), bb);
+            }
+        }
+
+        auto &children = domTree.getChildren(bb);
+        for (auto it = children.rbegin(); it != children.rend(); ++it)
+            stack.emplace_back(*it, false);
+    }
+}
+
+void IRSSA::destruct()
+{
+    IRFunction &func = *cfg.getFunction();
+    auto restore = [&](IROperand &op) { op = getOrigin(op); };
+
+    // Neither phi functions nor self-assignments are terminators, so the
+    // edges are not affected.
+    for (auto &bb : cfg.getBlocks()) {
+        std::erase_if(bb->stmts, [&](IRStmtID id) {
+            IRStmtRef stmt = func.getStmt(id);
+            if (stmt.isPhi())
+                return true;
+            restore(stmt.op1());
+            restore(stmt.op2());
+            restore(stmt.op3());
+            return stmt.isAssign() && stmt.op1() == stmt.op2();
+        });
+    }
+    func.clearPhiArgs();
+    func.truncateVariables(numOrigVars);
+    origins.clear();
+}
+
+} // namespace splc::SIR
@@ -0,0 +1,408 @@
+#include "SIR/IRSerializer.hh"
+#include "Translation/SourceBuffer.hh"
+
+#include <cstring>
+#include <string>
+#include <unordered_map>
+
+namespace splc::SIR {
+
+namespace {
+
+constexpr unsigned kindBits = 3;
+constexpr unsigned numOpsShift = 5;
+
+//===----------------------------------------------------------------------===//
+//                                Writer
+//===----------------------------------------------------------------------===//
+
+void writeVarint(std::string &out, uint64_t value)
+{
+    while (value >= 0x80) {
+        out.push_back(static_cast<char>(value | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<char>(value));
+}
+
+uint64_t encodeSymbolNumber(uint32_t number) noexcept
+{
+    return number == IRSymbol::noNumber ? 0 : uint64_t{number} + 1;
+}
+
+void writeOperand(std::string &out, IROperand op)
+{
+    writeVarint(out, uint64_t{op.getIndex()} << kindBits |
+                         static_cast<uint64_t>(op.getKind()));
+}
+
+class ProgramWriter {
+  public:
+    explicit ProgramWriter(const IRProgram &program_) : program{program_} {}
+
+    void write(std::ostream &os)
+    {
+        // Build the sections first, so that the string table is complete.
+        IRVec<std::string> sections;
+        sections.reserve(program.funcMap.size());
+        for (auto &[name, func] : program.funcMap)
+            sections.push_back(writeFunction(*func));
+
+        std::string out{IRSerializer::magic, sizeof(IRSerializer::magic)};
+        writeVarint(out, IRSerializer::formatVersion);
+        writeVarint(out, strings.size());
+        for (StrRef str : strings) {
+            writeVarint(out, str.size());
+            out.append(str);
+        }
+        writeVarint(out, sections.size());
+        for (auto &section : sections) {
+            writeVarint(out, section.size());
+            out.append(section);
+        }
+        os.write(out.data(), static_cast<std::streamsize>(out.size()));
+    }
+
+  private:
+    uint32_t getStringID(StrRef str)
+    {
+        auto [it, inserted] = stringIDs.try_emplace(
+            str, static_cast<uint32_t>(strings.size()));
+        if (inserted)
+            strings.push_back(str);
+        return it->second;
+    }
+
+    std::string writeFunction(IRFunction &func)
+    {
+        std::string out;
+        writeVarint(out, getStringID(func.name));
+
+        writeVarint(out, func.getNumNames());
+        for (IRNameID id = 0; id < func.getNumNames(); ++id)
+            writeVarint(out, getStringID(func.getNameString(id)));
+
+        writeVarint(out, func.getNumVariables());
+        for (uint32_t i = 0; i < func.getNumVariables(); ++i) {
+            const IRSymbol &sym =
+                func.getVariable({IROperand::Kind::Variable, i});
+            writeVarint(out, sym.prefix);
+            writeVarint(out, encodeSymbolNumber(sym.number));
+        }
+        writeVarint(out, func.getNumLabels());
+        for (uint32_t i = 0; i < func.getNumLabels(); ++i) {
+            const IRSymbol &sym = func.getLabel({IROperand::Kind::Label, i});
+            writeVarint(out, sym.prefix);
+            writeVarint(out, encodeSymbolNumber(sym.number));
+        }
+
+        writeVarint(out, func.getNumConstants());
+        for (uint32_t i = 0; i < func.getNumConstants(); ++i) {
+            auto value = static_cast<uint64_t>(
+                func.getConstantValue({IROperand::Kind::Constant, i}));
+            writeVarint(out, value << 1 ^ (value >> 63 ? ~uint64_t{0} : 0));
+        }
+
+        writeVarint(out, func.paramList.size());
+        for (IROperand param : func.paramList)
+            writeOperand(out, param);
+
+        writeVarint(out, func.body.size());
+        for (IRStmtID id : func.body) {
+            IRStmtRef stmt = func.getStmt(id);
+            splc_assert(!stmt.isPhi())
+                << "cannot serialize function " << func.name << " in SSA form";
+
+            IROperand ops[] = {stmt.op1(), stmt.op2(), stmt.op3()};
+            unsigned numOps = 3;
+            while (numOps > 0 && !ops[numOps - 1])
+                --numOps;
+            out.push_back(static_cast<char>(
+                static_cast<unsigned>(stmt.getIRType()) |
+                numOps << numOpsShift));
+            if (stmt.isBranchIf())
+                out.push_back(static_cast<char>(stmt.getBranchType()));
+            for (unsigned i = 0; i < numOps; ++i)
+                writeOperand(out, ops[i]);
+        }
+        return out;
+    }
+
+    const IRProgram &program;
+    IRVec<StrRef> strings;
+    std::unordered_map<StrRef, uint32_t> stringIDs;
+};
+
+//===----------------------------------------------------------------------===//
+//                                Reader
+//===----------------------------------------------------------------------===//
+
+/// \return the number of operands of a statement of type `irType`.
+unsigned getNumOperands(IRType irType) noexcept
+{
+    switch (irType) {
+    case IRType::SetLabel:
+    case IRType::Goto:
+    case IRType::Return:
+    case IRType::PopCallArg:
+    case IRType::PushCallArg:
+    case IRType::Read:
+    case IRType::Write:
+        return 1;
+    case IRType::Assign:
+    case IRType::AddrOf:
+    case IRType::Deref:
+    case IRType::CopyToAddr:
+    case IRType::Alloc:
+    case IRType::InvokeFunc:
+        return 2;
+    case IRType::Plus:
+    case IRType::Minus:
+    case IRType::Mul:
+    case IRType::Div:
+    case IRType::BranchIf:
+        return 3;
+    default:
+        return 0;
+    }
+}
+
+///
+/// \return true if operand `i` of a statement of type `irType` can be `op`:
+/// labels and functions only appear where they are expected, and variables
+/// are defined.
+///
+bool isValidOperand(IRType irType, unsigned i, IROperand op) noexcept
+{
+    bool isLabelPos = irType == IRType::SetLabel || irType == IRType::Goto ||
+                      (irType == IRType::BranchIf && i == 2);
+    if (isLabelPos)
+        return op.isLabel();
+    if (irType == IRType::InvokeFunc && i == 1)
+        return op.isFunction();
+
+    bool isDefPos = i == 0 && irType != IRType::Return &&
+                    irType != IRType::PushCallArg &&
+                    irType != IRType::Write && irType != IRType::CopyToAddr;
+    if (isDefPos || (irType == IRType::AddrOf && i == 1))
+        return op.isVariable();
+    return op.isVariable() || op.isConstant();
+}
+
+///
+/// \brief Reads a program from memory. Every read is bounds-checked: the first
+/// malformed field sets `failed` and makes the following reads return 0.
+///
+class ProgramReader {
+  public:
+    explicit ProgramReader(StrRef data)
+        : cur{data.data()}, end{data.data() + data.size()}
+    {
+    }
+
+    Ptr<IRProgram> read()
+    {
+        if (static_cast<size_t>(end - cur) < sizeof(IRSerializer::magic) ||
+            std::memcmp(cur, IRSerializer::magic,
+                        sizeof(IRSerializer::magic)) != 0)
+            return nullptr;
+        cur += sizeof(IRSerializer::magic);
+        if (readVarint() != IRSerializer::formatVersion)
+            return nullptr;
+
+        size_t numStrings = readCount();
+        strings.reserve(numStrings);
+        for (size_t i = 0; i < numStrings && !failed; ++i) {
+            size_t length = readCount();
+            strings.push_back(StrRef{cur, length});
+            cur += length;
+        }
+
+        IRMap<IRIDType, Ptr<IRFunction>> funcMap;
+        size_t numFunctions = readCount();
+        for (size_t i = 0; i < numFunctions && !failed; ++i) {
+            size_t size = readCount();
+            const char *sectionEnd = cur + size;
+            Ptr<IRFunction> func = readFunction();
+            check(cur == sectionEnd);
+            if (!failed)
+                check(funcMap.emplace(func->name, func).second);
+        }
+        check(cur == end);
+        return failed ? nullptr : IRProgram::make(std::move(funcMap));
+    }
+
+  private:
+    void check(bool cond) noexcept { failed = failed || !cond; }
+
+    uint64_t readVarint() noexcept
+    {
+        uint64_t value = 0;
+        for (unsigned shift = 0; !failed; shift += 7) {
+            check(cur != end && shift < 64);
+            if (failed)
+                break;
+            auto byte = static_cast<uint8_t>(*cur++);
+            value |= uint64_t{byte & 0x7fU} << shift;
+            if (!(byte & 0x80))
+                return value;
+        }
+        return 0;
+    }
+
+    /// \return a varint that counts bytes or entries, which cannot exceed
+    /// the remaining input.
+    size_t readCount() noexcept
+    {
+        uint64_t count = readVarint();
+        check(count <= static_cast<uint64_t>(end - cur));
+        return failed ? 0 : static_cast<size_t>(count);
+    }
+
+    uint8_t readByte() noexcept
+    {
+        check(cur != end);
+        return failed ? 0 : static_cast<uint8_t>(*cur++);
+    }
+
+    StrRef readString() noexcept
+    {
+        uint64_t id = readVarint();
+        check(id < strings.size());
+        return failed ? StrRef{} : strings[id];
+    }
+
+    uint32_t readSymbolNumber() noexcept
+    {
+        uint64_t number = readVarint();
+        check(number <= IRSymbol::noNumber);
+        return number == 0 ? IRSymbol::noNumber
+                           : static_cast<uint32_t>(number - 1);
+    }
+
+    IROperand readOperand(const IRFunction &func) noexcept
+    {
+        uint64_t bits = readVarint();
+        auto kind = static_cast<IROperand::Kind>(bits & ((1U << kindBits) - 1));
+        uint64_t index = bits >> kindBits;
+        switch (kind) {
+        case IROperand::Kind::None: {
+            check(index == 0);
+            break;
+        }
+        case IROperand::Kind::Variable: {
+            check(index < func.getNumVariables());
+            break;
+        }
+        case IROperand::Kind::Constant: {
+            check(index < func.getNumConstants());
+            break;
+        }
+        case IROperand::Kind::Label: {
+            check(index < func.getNumLabels());
+            break;
+        }
+        case IROperand::Kind::Function: {
+            check(index < func.getNumNames());
+            break;
+        }
+        default: {
+            check(false);
+            break;
+        }
+        }
+        return failed ? IROperand{}
+                      : IROperand{kind, static_cast<uint32_t>(index)};
+    }
+
+    Ptr<IRFunction> readFunction()
+    {
+        Ptr<IRFunction> func =
+            IRFunction::create(IRIDType{readString()}, nullptr);
+
+        // Names, variables, labels and constants are recreated in order, so
+        // that the operands read afterwards keep their indices.
+        size_t numNames = readCount();
+        for (size_t i = 0; i < numNames && !failed; ++i)
+            check(func->internName(readString()) == i);
+
+        size_t numVars = readCount();
+        for (size_t i = 0; i < numVars && !failed; ++i) {
+            uint64_t prefix = readVarint();
+            check(prefix < numNames);
+            func->createVariable(static_cast<IRNameID>(prefix),
+                                 readSymbolNumber(), nullptr);
+        }
+        size_t numLabels = readCount();
+        for (size_t i = 0; i < numLabels && !failed; ++i) {
+            uint64_t prefix = readVarint();
+            check(prefix < numNames);
+            func->createLabel(static_cast<IRNameID>(prefix),
+                              readSymbolNumber());
+        }
+
+        size_t numConstants = readCount();
+        for (size_t i = 0; i < numConstants && !failed; ++i) {
+            uint64_t value = readVarint();
+            auto constant = static_cast<ASTSIntType>(
+                value >> 1 ^ (value & 1 ? ~uint64_t{0} : 0));
+            check(func->getConstant(constant).getIndex() == i);
+        }
+
+        size_t numParams = readCount();
+        for (size_t i = 0; i < numParams && !failed; ++i)
+            func->paramList.push_back(readOperand(*func));
+
+        size_t numStmts = readCount();
+        func->body.reserve(numStmts);
+        for (size_t i = 0; i < numStmts && !failed; ++i) {
+            uint8_t header = readByte();
+            auto irType = static_cast<IRType>(header & ((1U << numOpsShift) - 1));
+            unsigned numOps = header >> numOpsShift;
+            check(irType < IRType::Phi && irType != IRType::FuncDecl &&
+                  numOps == getNumOperands(irType));
+
+            auto branchType = IRBranchType::None;
+            if (irType == IRType::BranchIf) {
+                branchType = static_cast<IRBranchType>(readByte());
+                check(branchType <= IRBranchType::NE);
+            }
+            IROperand ops[3];
+            for (unsigned j = 0; j < numOps && !failed; ++j) {
+                ops[j] = readOperand(*func);
+                check(isValidOperand(irType, j, ops[j]));
+            }
+            if (!failed)
+                func->body.push_back(func->createStmt(irType, ops[0], ops[1],
+                                                      ops[2], branchType));
+        }
+        return func;
+    }
+
+    const char *cur;
+    const char *end;
+    bool failed = false;
+    IRVec<StrRef> strings; ///< Views into the input
+};
+
+} // namespace
+
+void IRSerializer::writeProgram(std::ostream &os, const IRProgram &program)
+{
+    ProgramWriter{program}.write(os);
+}
+
+Ptr<IRProgram> IRSerializer::readProgram(StrRef data)
+{
+    return ProgramReader{data}.read();
+}
+
+Ptr<IRProgram> IRSerializer::readFile(StrRef fileName)
+{
+    Ptr<SourceBuffer> buffer = SourceBuffer::openFile(fileName);
+    if (!buffer)
+        return nullptr;
+    return readProgram(buffer->getContent());
+}
+
+} // namespace splc::SIR
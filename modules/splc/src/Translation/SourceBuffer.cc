@@ -0,0 +1,62 @@
+#include "Translation/SourceBuffer.hh"
+
+#include <fstream>
+#include <iterator>
+
+#if __has_include(<sys/mman.h>)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define SPLC_HAS_MMAP 1
+#endif
+
+namespace splc {
+
+SourceBuffer::~SourceBuffer() noexcept
+{
+#ifdef SPLC_HAS_MMAP
+    if (mapped) {
+        munmap(const_cast<char *>(data), size);
+    }
+#endif
+}
+
+Ptr<SourceBuffer> SourceBuffer::openFile(std::string_view fileName_)
+{
+    Ptr<SourceBuffer> buffer{new SourceBuffer{fileName_}};
+
+#ifdef SPLC_HAS_MMAP
+    int fd = open(buffer->name.c_str(), O_RDONLY);
+    if (fd < 0)
+        return nullptr;
+
+    struct stat st;
+    if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+        void *p = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ,
+                       MAP_PRIVATE, fd, 0);
+        if (p != MAP_FAILED) {
+            // The whole file is lexed sequentially exactly once.
+            madvise(p, static_cast<size_t>(st.st_size), MADV_SEQUENTIAL);
+            close(fd);
+            buffer->data = static_cast<const char *>(p);
+            buffer->size = static_cast<size_t>(st.st_size);
+            buffer->mapped = true;
+            return buffer;
+        }
+    }
+    close(fd);
+#endif
+
+    // Fall back to reading the file into a single buffer.
+    std::ifstream ifs{buffer->name, std::ios::binary};
+    if (!ifs)
+        return nullptr;
+    buffer->ownedContent.assign(std::istreambuf_iterator<char>{ifs},
+                                std::istreambuf_iterator<char>{});
+    buffer->data = buffer->ownedContent.data();
+    buffer->size = buffer->ownedContent.size();
+    return buffer;
+}
+
+} // namespace splc
@@ -0,0 +1,276 @@
+#include "Translation/SourceCache.hh"
+#include "Core/System.hh"
+
+#include <cctype>
+#include <filesystem>
+
+namespace splc {
+
+namespace {
+
+///
+/// \brief Minimal cursor over source text that understands just enough of the
+/// language (comments, literals, line continuations) to find preprocessor
+/// directives.
+///
+class DirectiveCursor {
+  public:
+    DirectiveCursor(std::string_view text_) : text{text_} {}
+
+    bool atEnd() const noexcept { return pos >= text.size(); }
+
+    /// Skip whitespace and comments. Return true if a newline was skipped.
+    bool skipSpaceAndComments() noexcept
+    {
+        bool newline = false;
+        while (!atEnd()) {
+            char c = text[pos];
+            if (c == '\n') {
+                newline = true;
+                ++pos;
+            }
+            else if (std::isspace(static_cast<unsigned char>(c))) {
+                ++pos;
+            }
+            else if (c == '\\' && isNewlineAt(pos + 1)) {
+                pos = skipNewlineAt(pos + 1);
+            }
+            else if (text.substr(pos, 2) == "//") {
+                while (!atEnd() && text[pos] != '\n') {
+                    if (text[pos] == '\\' && isNewlineAt(pos + 1))
+                        pos = skipNewlineAt(pos + 1);
+                    else
+                        ++pos;
+                }
+            }
+            else if (text.substr(pos, 2) == "/*") {
+                size_t end = text.find("*/", pos + 2);
+                pos = end == std::string_view::npos ? text.size() : end + 2;
+            }
+            else {
+                break;
+            }
+        }
+        return newline;
+    }
+
+    /// Skip horizontal whitespace and block comments on the current line.
+    void skipHorizontalSpace() noexcept
+    {
+        while (!atEnd()) {
+            char c = text[pos];
+            if (c == ' ' || c == '\t' || c == '\r' || c == '\f' || c == '\v')
+                ++pos;
+            else if (c == '\\' && isNewlineAt(pos + 1))
+                pos = skipNewlineAt(pos + 1);
+            else if (text.substr(pos, 2) == "/*") {
+                size_t end = text.find("*/", pos + 2);
+                pos = end == std::string_view::npos ? text.size() : end + 2;
+            }
+            else
+                break;
+        }
+    }
+
+    std::string_view readIdentifier() noexcept
+    {
+        size_t start = pos;
+        while (!atEnd() && (std::isalnum(static_cast<unsigned char>(
+                                text[pos])) ||
+                            text[pos] == '_'))
+            ++pos;
+        return text.substr(start, pos - start);
+    }
+
+    /// Skip a string or character literal starting at the cursor.
+    void skipLiteral() noexcept
+    {
+        char quote = text[pos++];
+        while (!atEnd() && text[pos] != quote && text[pos] != '\n') {
+            pos += text[pos] == '\\' ? 2 : 1;
+        }
+        if (!atEnd() && text[pos] == quote)
+            ++pos;
+    }
+
+    /// Skip to the beginning of the next logical line.
+    void skipLine() noexcept
+    {
+        while (!atEnd() && text[pos] != '\n') {
+            if (text[pos] == '\\' && isNewlineAt(pos + 1))
+                pos = skipNewlineAt(pos + 1);
+            else if (text.substr(pos, 2) == "/*") {
+                size_t end = text.find("*/", pos + 2);
+                pos = end == std::string_view::npos ? text.size() : end + 2;
+            }
+            else
+                ++pos;
+        }
+    }
+
+    ///
+    /// \brief Read the directive at the cursor, which must point at `#`.
+    /// \return the name of the directive, with the cursor placed after it.
+    ///
+    std::string_view readDirective() noexcept
+    {
+        ++pos; // '#'
+        skipHorizontalSpace();
+        return readIdentifier();
+    }
+
+    char peek() const noexcept { return atEnd() ? '\0' : text[pos]; }
+
+    void advance() noexcept { ++pos; }
+
+  private:
+    bool isNewlineAt(size_t p) const noexcept
+    {
+        return (p < text.size() && text[p] == '\n') ||
+               (p + 1 < text.size() && text[p] == '\r' && text[p + 1] == '\n');
+    }
+
+    size_t skipNewlineAt(size_t p) const noexcept
+    {
+        return text[p] == '\r' ? p + 2 : p + 1;
+    }
+
+    std::string_view text;
+    size_t pos = 0;
+};
+
+} // namespace
+
+SourceCache &SourceCache::getInstance()
+{
+    static SourceCache cache;
+    return cache;
+}
+
+Ptr<const SourceCacheEntry> SourceCache::get(std::string_view fileName_)
+{
+    std::error_code ec;
+    std::string canonicalPath =
+        std::filesystem::weakly_canonical(std::filesystem::path{fileName_}, ec)
+            .string();
+    if (ec)
+        canonicalPath = std::string{fileName_};
+
+    {
+        std::lock_guard<std::mutex> lockGuard{cacheMutex};
+        if (auto it = entries.find(canonicalPath); it != entries.end())
+            return it->second;
+    }
+
+    // Load outside the lock. If another thread wins the race, its entry is
+    // kept and this one is dropped.
+    Ptr<const SourceBuffer> buffer = SourceBuffer::openFile(canonicalPath);
+    if (!buffer)
+        return nullptr;
+
+    auto entry = makeSharedPtr<SourceCacheEntry>();
+    entry->canonicalPath = canonicalPath;
+    entry->buffer = buffer;
+    detectMultipleInclusionGuard(buffer->getContent(), *entry);
+
+    std::lock_guard<std::mutex> lockGuard{cacheMutex};
+    auto [it, inserted] = entries.emplace(canonicalPath, entry);
+    if (inserted) {
+        cachedSize += buffer->getContent().size();
+        if (cachedSize > SPLC_SOURCE_CACHE_SIZE)
+            evictUnused(it->second.get());
+    }
+    return it->second;
+}
+
+void SourceCache::evictUnused(const SourceCacheEntry *keep_)
+{
+    // An entry nobody else holds can no longer hand out its buffer, so
+    // both counts only change under the lock.
+    for (auto it = entries.begin();
+         it != entries.end() && cachedSize > SPLC_SOURCE_CACHE_SIZE;) {
+        const Ptr<const SourceCacheEntry> &entry = it->second;
+        if (entry.get() != keep_ && entry.use_count() == 1 &&
+            entry->buffer.use_count() == 1) {
+            cachedSize -= entry->buffer->getContent().size();
+            it = entries.erase(it);
+        }
+        else {
+            ++it;
+        }
+    }
+}
+
+void SourceCache::detectMultipleInclusionGuard(std::string_view content,
+                                               SourceCacheEntry &entry)
+{
+    entry.guardMacro.clear();
+    entry.pragmaOnce = false;
+
+    DirectiveCursor cursor{content};
+    cursor.skipSpaceAndComments();
+    if (cursor.peek() != '#')
+        return;
+
+    // `#pragma once` or `#ifndef X`
+    std::string_view directive = cursor.readDirective();
+    cursor.skipHorizontalSpace();
+    if (directive == "pragma") {
+        entry.pragmaOnce = cursor.readIdentifier() == "once";
+        return;
+    }
+    if (directive != "ifndef")
+        return;
+    std::string_view guard = cursor.readIdentifier();
+    if (guard.empty())
+        return;
+    cursor.skipLine();
+
+    // `#define X`
+    cursor.skipSpaceAndComments();
+    if (cursor.peek() != '#' || cursor.readDirective() != "define")
+        return;
+    cursor.skipHorizontalSpace();
+    if (cursor.readIdentifier() != guard)
+        return;
+    cursor.skipLine();
+
+    // The matching `#endif` must be the last thing in the file, and the guard
+    // must not have an `#else` branch.
+    int depth = 1;
+    bool atLineStart = true;
+    while (!cursor.atEnd()) {
+        if (cursor.skipSpaceAndComments())
+            atLineStart = true;
+        if (cursor.atEnd())
+            break;
+
+        char c = cursor.peek();
+        if (c == '#' && atLineStart) {
+            std::string_view dir = cursor.readDirective();
+            if (dir == "if" || dir == "ifdef" || dir == "ifndef") {
+                ++depth;
+            }
+            else if ((dir == "else" || dir == "elif") && depth == 1) {
+                return;
+            }
+            else if (dir == "endif" && --depth == 0) {
+                cursor.skipLine();
+                cursor.skipSpaceAndComments();
+                if (cursor.atEnd())
+                    entry.guardMacro = guard;
+                return;
+            }
+            cursor.skipLine();
+        }
+        else if (c == '"' || c == '\'') {
+            cursor.skipLiteral();
+        }
+        else {
+            cursor.advance();
+        }
+        atLineStart = false;
+    }
+}
+
+} // namespace splc
@@ -69,20 +69,12 @@ void TranslationManager::tryUnregisterSymbol(SymEntryType symEntTy,
 }
 
 Ptr<TranslationContext>
-TranslationManager::pushTransFileContext(const Location *intrLoc_,
-                                         std::string_view fileName_)
+TranslationManager::pushTransFileContext(
+    const Location *intrLoc_, std::string_view fileName_,
+    const std::function<bool(std::string_view)> &isMacroDefined)
 {
     Ptr<TranslationContext> context =
-        tunit->transCtxMgr.pushContext(intrLoc_, fileName_);
-    return context;
-}
-
-Ptr<TranslationContext>
-TranslationManager::pushTransMacroVarContext(const Location *intrLoc_,
-                                             std::string_view macroVarName_)
-{
-    Ptr<TranslationContext> context =
-        tunit->transCtxMgr.pushMacroVarContext(intrLoc_, macroVarName_);
+        tunit->transCtxMgr.pushContext(intrLoc_, fileName_, isMacroDefined);
     return context;
 }
 
@@ -93,34 +85,6 @@ bool TranslationManager::isContextExistInStack(
     return tunit->transCtxMgr.isContextExistInStack(type_, contextName_);
 }
 
-/// \brief Get macro var context from the context manager.
-MacroVarConstEntry TranslationManager::getTransMacroVarContext(
-    std::string_view macroVarName_) const
-{
-    auto ent = tunit->transCtxMgr.getMacroVarContext(macroVarName_);
-    return ent;
-}
-
-/// \brief Register a macro variable definition.
-Ptr<TranslationContext>
-TranslationManager::registerTransMacroVarContext(const Location *regLocation,
-                                                 std::string_view macroVarName_,
-                                                 std::string_view content_)
-{
-    auto context = tunit->transCtxMgr.registerMacroVarContext(
-        regLocation, macroVarName_, content_);
-    return context;
-}
-
-/// \brief Unregister a macro variable definition.
-Ptr<TranslationContext> TranslationManager::unregisterTransMacroVarContext(
-    const Location *unRegLoc, std::string_view macroVarName_)
-{
-    auto context =
-        tunit->transCtxMgr.unregisterMacroVarContext(unRegLoc, macroVarName_);
-    return context;
-}
-
 Ptr<TranslationUnit> TranslationManager::getTransUnit() const noexcept
 {
     return tunit;
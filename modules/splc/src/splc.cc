@@ -2,18 +2,28 @@
 #include "AST/ASTContext.hh"
 #include "AST/ASTProcess.hh"
 #include "AST/DerivedAST.hh"
+#include "CodeGen/CompileCache.hh"
 #include "CodeGen/ObjBuilder.hh"
 #include "Core/Utils/CommandLineParser.hh"
 #include "IO/Driver.hh"
 #include "SIR/IRBuilder.hh"
+#include "SIR/IRMIPSBackend.hh"
 #include "SIR/IROptimizer.hh"
+#include "SIR/IRPassManager.hh"
+#include "SIR/IRSerializer.hh"
 #include <algorithm>
+#include <atomic>
 #include <cassert>
 #include <cstdlib>
 #include <cstring>
+#include <filesystem>
+#include <fstream>
 #include <iostream>
 #include <iterator>
+#include <optional>
+#include <sstream>
 #include <string_view>
+#include <thread>
 
 using namespace splc;
 using namespace std::string_view_literals;
@@ -22,15 +32,56 @@ using CS = utils::logging::ControlSeq;
 
 static bool writeAssembly = false;
 static bool writeMIPSTarget = false; ///< If true, write MIPS instead
+static bool writeSIRText = false;    ///< If true, write optimized SIR instead
+static unsigned numJobs = 1;         ///< Number of files compiled in parallel
+static unsigned optLevel = 0;        ///< Optimization level, 0 to 3
+static bool preprocessOnly = false;  ///< If true, only run the preprocessor
+static bool runProgram = false;      ///< If true, run the program in the JIT
+static bool linkTimeOpt = false;     ///< If true, link all files into one
+static std::string outputFile;       ///< Output of `-E`, or LTO output base
+static std::optional<CompileCache> compileCache; ///< Set if caching is on
+static std::vector<std::string> sirDisabledPasses; ///< SIR passes not to run
+static bool sirFixpoint = false;   ///< Repeat the SIR pipeline to a fixpoint
+static bool sirTimePasses = false; ///< Report statistics of SIR passes
+static std::string sirBinaryFile;  ///< Binary SIR output, if not empty
 std::vector<std::string> sourceFiles;
 
-bool parseArgs(const int argc, const char *const argv[])
+/// What the driver does after the command line has been parsed
+enum class ArgsStatus {
+    Proceed,  ///< Process the source files
+    HelpOnly, ///< Help has been printed, nothing else to do
+    Invalid,  ///< Conflicting options, errors have been reported
+};
+
+ArgsStatus parseArgs(const int argc, const char *const argv[])
 {
     CommandLineParser parser{"splc"};
 
     parser.addSeqDirArgName("SOURCE_FILE");
     parser.addPositionalArg("genasm", CommandLineParser::ArgOption::NoOption);
     parser.addPositionalArg("target", CommandLineParser::ArgOption::WithOption);
+    parser.addPositionalArg("j", CommandLineParser::ArgOption::WithOption);
+    parser.addPositionalArg("E", CommandLineParser::ArgOption::NoOption);
+    // Arguments after the source file to run are passed on to the program.
+    parser.addPositionalArg("run", CommandLineParser::ArgOption::StopAtDirArg);
+    parser.addPositionalArg("lto", CommandLineParser::ArgOption::NoOption);
+    parser.addPositionalArg("O0", CommandLineParser::ArgOption::NoOption);
+    parser.addPositionalArg("O1", CommandLineParser::ArgOption::NoOption);
+    parser.addPositionalArg("O2", CommandLineParser::ArgOption::NoOption);
+    parser.addPositionalArg("O3", CommandLineParser::ArgOption::NoOption);
+    parser.addPositionalArg("o", CommandLineParser::ArgOption::WithOption);
+    parser.addPositionalArg("cache", CommandLineParser::ArgOption::NoOption);
+    parser.addPositionalArg("cache-dir",
+                            CommandLineParser::ArgOption::WithOption);
+    parser.addPositionalArg("sir", CommandLineParser::ArgOption::NoOption);
+    parser.addPositionalArg("sir-disable-pass",
+                            CommandLineParser::ArgOption::WithOption);
+    parser.addPositionalArg("sir-fixpoint",
+                            CommandLineParser::ArgOption::NoOption);
+    parser.addPositionalArg("sir-time-passes",
+                            CommandLineParser::ArgOption::NoOption);
+    parser.addPositionalArg("sir-binary",
+                            CommandLineParser::ArgOption::WithOption);
 
     parser.parseArgs(argc, argv);
 
@@ -53,86 +104,482 @@ bool parseArgs(const int argc, const char *const argv[])
         }
         SPLC_LOG_DEBUG(nullptr, false) << "writing MIPS instead";
     }
+    if (auto ivec = parser.get<int>(
+            "j", [](const std::string &s) { return std::atoi(s.c_str()); })) {
+        if ((*ivec)[0] > 0) {
+            numJobs = static_cast<unsigned>((*ivec)[0]);
+        }
+        else {
+            SPLC_LOG_ERROR(nullptr, false)
+                << "invalid number of jobs, falling back to "
+                << CS::BrightCyan << numJobs << CS::Reset;
+        }
+    }
+    for (unsigned level = 0; level <= 3; ++level) {
+        if (parser.isArgPresent("O" + std::to_string(level))) {
+            optLevel = level;
+        }
+    }
+    if (auto ivec = parser.get("E")) {
+        preprocessOnly = true;
+    }
+    if (auto ivec = parser.get("run")) {
+        runProgram = true;
+    }
+    if (auto ivec = parser.get("lto")) {
+        linkTimeOpt = true;
+    }
+    if (auto ivec = parser.get<std::string>("o")) {
+        outputFile = (*ivec)[0];
+    }
+    if (auto ivec = parser.get<std::string>("cache-dir")) {
+        compileCache.emplace((*ivec)[0]);
+    }
+    else if (auto ivec = parser.get("cache")) {
+        compileCache.emplace(CompileCache::getDefaultDirectory());
+    }
+    if (compileCache) {
+        SPLC_LOG_DEBUG(nullptr, false)
+            << "using compile cache at "
+            << compileCache->getDirectory().string();
+    }
+    if (auto ivec = parser.get<std::string>("sir-disable-pass")) {
+        sirDisabledPasses = *ivec;
+    }
+    if (auto ivec = parser.get("sir")) {
+        writeSIRText = true;
+    }
+    if ((writeSIRText || writeMIPSTarget) && linkTimeOpt) {
+        // SIR and MIPS output never go through LLVM.
+        SPLC_LOG_ERROR(nullptr, false)
+            << "--lto cannot be used with --sir or --target mips";
+        return ArgsStatus::Invalid;
+    }
+    if (auto ivec = parser.get("sir-fixpoint")) {
+        sirFixpoint = true;
+    }
+    if (auto ivec = parser.get("sir-time-passes")) {
+        sirTimePasses = true;
+    }
+    if (auto ivec = parser.get<std::string>("sir-binary")) {
+        sirBinaryFile = (*ivec)[0];
+    }
     if (auto ivec = parser.getDirectArgVec(); !ivec.empty()) {
         sourceFiles = ivec;
     }
+    if (!sirBinaryFile.empty() && sourceFiles.size() > 1) {
+        // Every file would write the same output.
+        SPLC_LOG_ERROR(nullptr, false)
+            << "--sir-binary cannot be used with more than one source file";
+        return ArgsStatus::Invalid;
+    }
+    if (!writeSIRText && !writeMIPSTarget &&
+        (!sirDisabledPasses.empty() || sirFixpoint || sirTimePasses ||
+         !sirBinaryFile.empty())) {
+        SPLC_LOG_WARN(nullptr, false)
+            << "SIR options have no effect without --sir or --target mips";
+    }
+    if (compileCache && (sirTimePasses || !sirBinaryFile.empty())) {
+        // A cache hit would skip the pipeline and its side outputs.
+        SPLC_LOG_WARN(nullptr, false)
+            << "compile cache disabled by --sir-time-passes or --sir-binary";
+        compileCache.reset();
+    }
 
-    return parser.isHelpParsed();
+    return parser.isHelpParsed() ? ArgsStatus::HelpOnly : ArgsStatus::Proceed;
 }
 
-void writeSIR(SPLCContext &C, Ptr<AST> root)
+/// Write `program` to `<path>.ir`, or to `<path>.asm` as MIPS assembly for
+/// the MIPS target.
+/// \return false if the output cannot be written.
+bool writeSIRProgram(std::string_view path, Ptr<SIR::IRProgram> program)
+{
+    std::string outPath =
+        std::string{path} + (writeMIPSTarget ? ".asm" : ".ir");
+    std::ofstream of{outPath};
+    if (!of) {
+        SPLC_LOG_ERROR(nullptr, false)
+            << "cannot open " << CS::BrightRed << outPath << CS::Reset;
+        return false;
+    }
+    // The MIPS target is translated from SIR directly, without LLVM.
+    if (writeMIPSTarget) {
+        SIR::IRMIPSBackend::writeProgram(of, program);
+    }
+    else {
+        SIR::IRProgram::writeProgram(of, program);
+    }
+    of.flush();
+    return static_cast<bool>(of);
+}
+
+/// Translate `root` to SIR, optimize it, and write it out with
+/// `writeSIRProgram`.
+/// \return false if an output cannot be written.
+bool writeSIR(std::string_view path, SPLCContext &C, Ptr<AST> root)
 {
     using SIR::IRBuilder;
-    using SIR::IROptimizer;
+    using SIR::IRPassManager;
     using SIR::IRProgram;
     IRBuilder builder{C};
 
     Ptr<IRProgram> program = builder.makeProgram(root);
 
-    // Disable
-    // IROptimizer::optimizeProgram(program);
+    IRPassManager pm = IRPassManager::createDefault();
+    for (auto &name : sirDisabledPasses) {
+        if (!pm.setEnabled(name, false)) {
+            SPLC_LOG_WARN(nullptr, false)
+                << "unknown SIR pass " << CS::BrightRed << name << CS::Reset;
+        }
+    }
+    pm.setFixpoint(sirFixpoint);
+    pm.setNumThreads(sourceFiles.size() == 1 ? numJobs : 1);
+    pm.run(*program);
+    if (sirTimePasses) {
+        pm.printStats(std::cerr);
+    }
+    if (!sirBinaryFile.empty()) {
+        std::ofstream ofs{sirBinaryFile, std::ios::binary};
+        if (ofs) {
+            SIR::IRSerializer::writeProgram(ofs, *program);
+            ofs.flush();
+        }
+        if (!ofs) {
+            SPLC_LOG_ERROR(nullptr, false)
+                << "cannot write " << CS::BrightRed << sirBinaryFile
+                << CS::Reset;
+            return false;
+        }
+    }
 
-    IRProgram::writeProgram(std::cout, program);
+    return writeSIRProgram(path, program);
 }
 
-void testObjBuilder(std::string_view path, Ptr<TranslationUnit> tunit)
+/// Read the binary SIR in `path`, as written by `--sir-binary`, and write it
+/// out with `writeSIRProgram`. The pipeline is not run again.
+bool readSIRBinary(std::string_view path)
 {
-    ObjBuilder builder;
+    Ptr<SIR::IRProgram> program = SIR::IRSerializer::readFile(path);
+    if (!program) {
+        SPLC_LOG_ERROR(nullptr, false)
+            << "cannot read binary SIR from " << CS::BrightRed << path
+            << CS::Reset;
+        return false;
+    }
+    return writeSIRProgram(path, program);
+}
 
-    std::ofstream of{std::string{path} + ".ll"};
+llvm::OptimizationLevel getOptimizationLevel()
+{
+    switch (optLevel) {
+    case 1:
+        return llvm::OptimizationLevel::O1;
+    case 2:
+        return llvm::OptimizationLevel::O2;
+    case 3:
+        return llvm::OptimizationLevel::O3;
+    default:
+        return llvm::OptimizationLevel::O0;
+    }
+}
+
+/// Target triple the outputs are generated for.
+std::string getTargetTriple()
+{
+    return writeMIPSTarget ? "mips" : llvm::sys::getDefaultTargetTriple();
+}
+
+/// Generate the outputs of `path` from `tunit`.
+/// \return false if code generation or writing any output fails.
+bool testObjBuilder(std::string_view path, Ptr<TranslationUnit> tunit)
+{
+    ObjBuilder builder{getTargetTriple()};
 
     builder.generateModule(*tunit);
-    // builder.optimizeModule();
+    if (!builder.isGenerationSuccess())
+        return false;
+
+    if (linkTimeOpt) {
+        // Code generation is deferred to `linkFiles`.
+        builder.optimizeModuleForLTO(getOptimizationLevel(), true);
+        return builder.writeModuleAsBitcode(std::string{path} + ".bc");
+    }
+
+    std::ofstream of{std::string{path} + ".ll"};
+    if (optLevel > 0) {
+        // Files compiled in parallel already occupy the requested threads.
+        unsigned numThreads = sourceFiles.size() == 1 ? numJobs : 1;
+        builder.optimizeModule(getOptimizationLevel(), numThreads);
+    }
     builder.writeModuleAsLLVMIR(of);
     of.flush();
 
     if (writeAssembly) {
-        if (writeMIPSTarget) {
-            builder.writeModuleAsAsm(std::string{path} + ".asm", "mips");
+        return builder.writeModuleAsAsm(std::string{path} + ".asm");
+    }
+    return builder.writeModuleAsObj(std::string{path} + ".o");
+}
+
+/// Files written by `testObjBuilder` for `path`.
+std::vector<CompileCacheOutput> getOutputs(std::string_view path)
+{
+    std::string base{path};
+    if (writeMIPSTarget)
+        return {{"asm", base + ".asm"}};
+    if (writeSIRText)
+        return {{"ir", base + ".ir"}};
+    if (linkTimeOpt)
+        return {{"bc", base + ".bc"}};
+    if (writeAssembly)
+        return {{"ll", base + ".ll"}, {"asm", base + ".asm"}};
+    return {{"ll", base + ".ll"}, {"o", base + ".o"}};
+}
+
+/// Compute the compile cache key of `path` from its preprocessed tokens and
+/// every option that affects the outputs.
+std::string computeCacheKey(std::string_view path)
+{
+    CompileCache::KeyBuilder keyBuilder;
+    {
+        // Diagnostics are reported when the file is actually compiled.
+        std::ostringstream discarded;
+        utils::logging::LogStreamRedirect redirect{discarded};
+
+        UniquePtr<SPLCContext> context = makeUniquePtr<SPLCContext>();
+        IO::Driver driver{*context};
+        driver.preprocess(path, keyBuilder.getStream());
+    }
+    keyBuilder.addField("version", __SPLC_VERSION__);
+    keyBuilder.addField("triple", getTargetTriple());
+    keyBuilder.addField("output", writeSIRText    ? "sir"
+                                  : writeAssembly ? "asm"
+                                                  : "obj");
+    keyBuilder.addField("opt", std::to_string(optLevel));
+    keyBuilder.addField("lto", linkTimeOpt ? "1" : "0");
+    if (writeSIRText || writeMIPSTarget) {
+        std::vector<std::string> disabled = sirDisabledPasses;
+        std::sort(disabled.begin(), disabled.end());
+        std::string passes;
+        for (auto &name : disabled)
+            passes.append(name).push_back(',');
+        keyBuilder.addField("sir-disable-pass", passes);
+        keyBuilder.addField("sir-fixpoint", sirFixpoint ? "1" : "0");
+    }
+    return keyBuilder.finalize();
+}
+
+/// Compile a single source file. Every file owns its `SPLCContext`, so that
+/// multiple files can be compiled concurrently without sharing any state.
+bool compileFile(std::string_view path)
+{
+    // Binary SIR is written out again as text or MIPS assembly.
+    if (path.ends_with(".sirb"))
+        return readSIRBinary(path);
+
+    try {
+        std::vector<CompileCacheOutput> outputs = getOutputs(path);
+        std::string cacheKey;
+        if (compileCache) {
+            cacheKey = computeCacheKey(path);
+            if (compileCache->retrieve(cacheKey, outputs)) {
+                SPLC_LOG_DEBUG(nullptr, false)
+                    << "compile cache hit for " << path;
+                return true;
+            }
         }
-        else {
-            builder.writeModuleAsAsm(std::string{path} + ".asm");
+        // Stale outputs, e.g., the bitcode picked up by `linkFiles`, must not
+        // be mistaken for the results of this compilation.
+        std::error_code ec;
+        for (auto &output : outputs)
+            std::filesystem::remove(output.path, ec);
+
+        UniquePtr<SPLCContext> context = makeUniquePtr<SPLCContext>();
+        IO::Driver driver{*context};
+
+        auto tunit = driver.parse(path);
+
+        auto root = tunit->getRootNode();
+        if (root) {
+            SPLC_LOG_DEBUG(nullptr, false) << "\n"
+                                           << splc::treePrintTransform(*root);
+            SPLC_LOG_DEBUG(nullptr, false) << "\n" << *root->getASTContext();
         }
+
+        bool generated = writeSIRText || writeMIPSTarget
+                             ? writeSIR(path, tunit->getContext(), root)
+                             : testObjBuilder(path, tunit);
+        if (!generated) {
+            SPLC_LOG_ERROR(nullptr, false) << "failed to generate " << path;
+            return false;
+        }
+
+        if (compileCache)
+            compileCache->store(cacheKey, outputs);
     }
-    else {
-        if (writeMIPSTarget) {
-            builder.writeModuleAsObj(std::string{path} + ".o", "mips");
+    catch (const std::exception &e) {
+        SPLC_LOG_FATAL_ERROR(nullptr, false)
+            << "failed to compile " << path << ": " << e.what();
+        return false;
+    }
+    return true;
+}
+
+/// Compile `path` and run it in the JIT with `args`.
+/// \return the exit code of the program.
+int runFile(std::string_view path, const std::vector<std::string> &args)
+{
+    try {
+        UniquePtr<SPLCContext> context = makeUniquePtr<SPLCContext>();
+        IO::Driver driver{*context};
+
+        auto tunit = driver.parse(path);
+
+        // The JIT generates code for this process.
+        ObjBuilder builder{llvm::sys::getProcessTriple()};
+        builder.generateModule(*tunit);
+        if (optLevel > 0) {
+            builder.optimizeModule(getOptimizationLevel(), numJobs);
         }
-        else {
-            builder.writeModuleAsObj(std::string{path} + ".o");
+        return builder.runModuleInJIT(path, args);
+    }
+    catch (const std::exception &e) {
+        SPLC_LOG_FATAL_ERROR(nullptr, false)
+            << "failed to run " << path << ": " << e.what();
+        return EXIT_FAILURE;
+    }
+}
+
+/// Preprocess a single source file, writing the expanded tokens to `os`.
+bool preprocessFile(std::string_view path, std::ostream &os)
+{
+    try {
+        UniquePtr<SPLCContext> context = makeUniquePtr<SPLCContext>();
+        IO::Driver driver{*context};
+        driver.preprocess(path, os);
+    }
+    catch (const std::exception &e) {
+        SPLC_LOG_FATAL_ERROR(nullptr, false)
+            << "failed to preprocess " << path << ": " << e.what();
+        return false;
+    }
+    return true;
+}
+
+/// Compile all source files, in parallel if requested.
+bool compileFiles()
+{
+    if (sourceFiles.size() == 1 || numJobs == 1) {
+        bool success = true;
+        for (auto &file : sourceFiles) {
+            success &= compileFile(file);
         }
+        return success;
     }
+
+    // Diagnostics of each file are buffered and written in the order of
+    // input files once all workers have finished.
+    std::vector<std::ostringstream> diagnostics(sourceFiles.size());
+    std::vector<char> results(sourceFiles.size(), false);
+    std::atomic<size_t> nextFile = 0;
+
+    auto worker = [&]() {
+        for (size_t i = nextFile++; i < sourceFiles.size(); i = nextFile++) {
+            utils::logging::LogStreamRedirect redirect{diagnostics[i]};
+            results[i] = compileFile(sourceFiles[i]);
+        }
+    };
+
+    unsigned workerCnt = std::min<size_t>(numJobs, sourceFiles.size());
+    std::vector<std::thread> workers;
+    workers.reserve(workerCnt);
+    for (unsigned i = 0; i < workerCnt; ++i) {
+        workers.emplace_back(worker);
+    }
+    for (auto &t : workers) {
+        t.join();
+    }
+
+    for (auto &diag : diagnostics) {
+        std::cerr << diag.str();
+    }
+    std::cerr.flush();
+
+    return std::all_of(results.begin(), results.end(),
+                       [](char r) { return r; });
+}
+
+/// Link the bitcode of all source files into one program, optimize it as a
+/// whole, and write it to a single output.
+bool linkFiles()
+{
+    std::vector<std::string> bitcodeFiles;
+    bitcodeFiles.reserve(sourceFiles.size());
+    for (auto &file : sourceFiles) {
+        bitcodeFiles.push_back(file + ".bc");
+    }
+
+    ObjBuilder builder{getTargetTriple()};
+    if (!builder.linkBitcodeFiles(bitcodeFiles))
+        return false;
+    builder.optimizeModuleForLTO(getOptimizationLevel(), false);
+
+    std::string base = outputFile.empty() ? "a" : outputFile;
+    std::ofstream of{base + ".ll"};
+    builder.writeModuleAsLLVMIR(of);
+    of.flush();
+
+    if (writeAssembly)
+        return builder.writeModuleAsAsm(base + ".asm");
+    return builder.writeModuleAsObj(base + ".o");
 }
 
 int main(const int argc, const char *const argv[])
 {
-    bool helpOnly = parseArgs(argc, argv);
+    ArgsStatus status = parseArgs(argc, argv);
 
-    if (helpOnly) {
+    if (status == ArgsStatus::HelpOnly) {
         return (EXIT_SUCCESS);
     }
+    if (status == ArgsStatus::Invalid) {
+        return (EXIT_FAILURE);
+    }
 
     if (sourceFiles.empty()) {{
         SPLC_LOG_FATAL_ERROR(nullptr, false) << "no input files";
         return (EXIT_FAILURE);}
     }
 
-    UniquePtr<SPLCContext> context = makeUniquePtr<SPLCContext>();
-    IO::Driver driver{*context};
-
-    // TODO(future): just parse the first file first
-
-    auto tunit = driver.parse(sourceFiles[0]);
+    if (preprocessOnly) {
+        // Files are preprocessed one after another, so that the output is
+        // streamed in input order.
+        std::ofstream of;
+        if (!outputFile.empty()) {
+            of.open(outputFile);
+            if (!of) {
+                SPLC_LOG_FATAL_ERROR(nullptr, false)
+                    << "cannot open output file " << outputFile;
+                return (EXIT_FAILURE);
+            }
+        }
+        std::ostream &os = outputFile.empty() ? std::cout : of;
 
-    auto root = tunit->getRootNode();
-    if (root) {
-        SPLC_LOG_DEBUG(nullptr, false) << "\n"
-                                       << splc::treePrintTransform(*root);
-        SPLC_LOG_DEBUG(nullptr, false) << "\n" << *root->getASTContext();
+        bool success = true;
+        for (auto &file : sourceFiles) {
+            success &= preprocessFile(file, os);
+        }
+        return success ? EXIT_SUCCESS : EXIT_FAILURE;
     }
 
-    // writeSIR(tunit->getContext(), root); // Don't write it right now
-    testObjBuilder(sourceFiles[0], tunit);
+    if (runProgram) {
+        // Operands after the source file are passed on to the program.
+        std::vector<std::string> args{sourceFiles.begin() + 1,
+                                      sourceFiles.end()};
+        return runFile(sourceFiles.front(), args);
+    }
 
-    return (EXIT_SUCCESS);
+    bool success = compileFiles();
+    if (success && linkTimeOpt) {
+        success = linkFiles();
+    }
+    return success ? EXIT_SUCCESS : EXIT_FAILURE;
 }
\ No newline at end of file
@@ -0,0 +1,73 @@
+process_directory() {
+    local input_directory="$1"
+
+    # Check if the input directory exists
+    if [ ! -d "$input_directory" ]; then
+        echo "Directory '$input_directory' does not exist."
+        return 1
+    fi
+
+    local failed=0
+
+    # Link the .spl files of each subdirectory with --lto, then check the
+    # linked LLVM IR against expected.check: every "CHECK: <regex>" line must
+    # match and no "CHECK-NOT: <regex>" line may match
+    for dir in "$input_directory"/*/; do
+        dir="${dir%/}"
+        if [ -f "$dir/expected.check" ]; then
+            printf '\x1b[33m'
+            echo ================ "$dir" =================
+            printf '\x1b[0m'
+            output="$dir/tmp_a"
+
+            rm -f "$output.ll" "$output.o"
+            if ! bin/splc --lto -O2 -o "$output" "$dir"/*.spl || [ ! -f "$output.ll" ]; then
+                printf '\x1b[31m'
+                echo "==>Failed to link $dir"
+                printf '\x1b[0m'
+                failed=1
+                continue
+            fi
+
+            local mismatch=0
+            while IFS= read -r line; do
+                case "$line" in
+                "CHECK: "*)
+                    if ! grep -Eq -- "${line#CHECK: }" "$output.ll"; then
+                        echo "not found: ${line#CHECK: }"
+                        mismatch=1
+                    fi
+                    ;;
+                "CHECK-NOT: "*)
+                    if grep -Eq -- "${line#CHECK-NOT: }" "$output.ll"; then
+                        echo "unexpectedly found: ${line#CHECK-NOT: }"
+                        mismatch=1
+                    fi
+                    ;;
+                esac
+            done < "$dir/expected.check"
+
+            if [ $mismatch -eq 0 ]; then
+                printf '\x1b[32m'
+                echo "==>Passed."
+                printf '\x1b[0m'
+            else
+                printf '\x1b[31m'
+                echo "==>Difference found. Please check output files. "
+                printf '\x1b[0m'
+                failed=1
+            fi
+            echo
+        fi
+    done
+    return $failed
+}
+
+# Check if an argument (directory path) is provided
+if [ $# -eq 0 ]; then
+    echo "Usage: $0 <directory_path>"
+    exit 1
+fi
+
+# Call the function with the provided directory path
+process_directory "$1"
@@ -0,0 +1,57 @@
+process_directory() {
+    local input_directory="$1"
+
+    # Check if the input directory exists
+    if [ ! -d "$input_directory" ]; then
+        echo "Directory '$input_directory' does not exist."
+        return 1
+    fi
+
+    local failed=0
+
+    # Compile each .spl file to MIPS, then run the generated .asm in SPIM,
+    # feeding it the .in file if present
+    for file in "$input_directory"/*.spl; do
+        if [ -f "$file" ]; then
+            printf '\x1b[33m'
+            echo ================ "$file" =================
+            printf '\x1b[0m'
+            filename=$(basename "$file" .spl)
+            input="$input_directory/$filename.in"
+            [ -f "$input" ] || input=/dev/null
+
+            rm -f "$file.asm"
+            if ! bin/splc --target mips "$file" || [ ! -f "$file.asm" ]; then
+                printf '\x1b[31m'
+                echo "==>Failed to generate $file.asm"
+                printf '\x1b[0m'
+                failed=1
+                continue
+            fi
+
+            spim -quiet -file "$file.asm" < "$input" > "$input_directory/tmp_$filename.out" 2>&1
+
+            if diff "$input_directory/$filename.out" "$input_directory/tmp_$filename.out"; then
+                printf '\x1b[32m'
+                echo "==>Passed."
+                printf '\x1b[0m'
+            else
+                printf '\x1b[31m'
+                echo "==>Difference found. Please check output files. "
+                printf '\x1b[0m'
+                failed=1
+            fi
+            echo
+        fi
+    done
+    return $failed
+}
+
+# Check if an argument (directory path) is provided
+if [ $# -eq 0 ]; then
+    echo "Usage: $0 <directory_path>"
+    exit 1
+fi
+
+# Call the function with the provided directory path
+process_directory "$1"
@@ -0,0 +1,61 @@
+process_directory() {
+    local input_directory="$1"
+
+    # Check if the input directory exists
+    if [ ! -d "$input_directory" ]; then
+        echo "Directory '$input_directory' does not exist."
+        return 1
+    fi
+
+    local failed=0
+
+    # Compile each .spl file with -O3, then look for every extended regular
+    # expression of the .check file in the optimized LLVM IR
+    for file in "$input_directory"/*.spl; do
+        if [ -f "$file" ]; then
+            printf '\x1b[33m'
+            echo ================ "$file" =================
+            printf '\x1b[0m'
+            filename=$(basename "$file" .spl)
+
+            rm -f "$file.ll"
+            if ! bin/splc -O3 "$file" || [ ! -f "$file.ll" ]; then
+                printf '\x1b[31m'
+                echo "==>Failed to generate $file.ll"
+                printf '\x1b[0m'
+                failed=1
+                continue
+            fi
+
+            local missing=0
+            while IFS= read -r pattern; do
+                if [ -n "$pattern" ] && ! grep -Eq -- "$pattern" "$file.ll"; then
+                    echo "not found: $pattern"
+                    missing=1
+                fi
+            done < "$input_directory/$filename.check"
+
+            if [ $missing -eq 0 ]; then
+                printf '\x1b[32m'
+                echo "==>Passed."
+                printf '\x1b[0m'
+            else
+                printf '\x1b[31m'
+                echo "==>Difference found. Please check output files. "
+                printf '\x1b[0m'
+                failed=1
+            fi
+            echo
+        fi
+    done
+    return $failed
+}
+
+# Check if an argument (directory path) is provided
+if [ $# -eq 0 ]; then
+    echo "Usage: $0 <directory_path>"
+    exit 1
+fi
+
+# Call the function with the provided directory path
+process_directory "$1"
@@ -0,0 +1,48 @@
+process_directory() {
+    local input_directory="$1"
+
+    # Check if the input directory exists
+    if [ ! -d "$input_directory" ]; then
+        echo "Directory '$input_directory' does not exist."
+        return 1
+    fi
+
+    local failed=0
+    local splc
+    splc=$(realpath bin/splc)
+
+    # Preprocess each .c file that has an expected .out file. splc runs from
+    # the input directory, so that line markers name the file alone.
+    for file in "$input_directory"/*.c; do
+        filename=$(basename "$file" .c)
+        if [ -f "$file" ] && [ -f "$input_directory/$filename.out" ]; then
+            printf '\x1b[33m'
+            echo ================ "$file" =================
+            printf '\x1b[0m'
+
+            (cd "$input_directory" && "$splc" -E "$filename.c") > "$input_directory/tmp_$filename.out" 2>&1
+
+            if diff "$input_directory/$filename.out" "$input_directory/tmp_$filename.out"; then
+                printf '\x1b[32m'
+                echo "==>Passed."
+                printf '\x1b[0m'
+            else
+                printf '\x1b[31m'
+                echo "==>Difference found. Please check output files. "
+                printf '\x1b[0m'
+                failed=1
+            fi
+            echo
+        fi
+    done
+    return $failed
+}
+
+# Check if an argument (directory path) is provided
+if [ $# -eq 0 ]; then
+    echo "Usage: $0 <directory_path>"
+    exit 1
+fi
+
+# Call the function with the provided directory path
+process_directory "$1"
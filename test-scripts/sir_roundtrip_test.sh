@@ -0,0 +1,50 @@
+process_directory() {
+    local input_directory="$1"
+
+    # Check if the input directory exists
+    if [ ! -d "$input_directory" ]; then
+        echo "Directory '$input_directory' does not exist."
+        return 1
+    fi
+
+    local failed=0
+
+    # Write the optimized SIR of each .spl file both as text and as binary,
+    # read the binary back, and compare its text with the original
+    for file in "$input_directory"/*.spl; do
+        if [ -f "$file" ]; then
+            printf '\x1b[33m'
+            echo ================ "$file" =================
+            printf '\x1b[0m'
+            filename=$(basename "$file" .spl)
+            binary="$input_directory/tmp_$filename.sirb"
+
+            rm -f "$file.ir" "$binary" "$binary.ir"
+            bin/splc --sir --sir-binary "$binary" "$file" &&
+                bin/splc "$binary"
+
+            if [ -f "$file.ir" ] && [ -f "$binary.ir" ] &&
+                diff "$file.ir" "$binary.ir"; then
+                printf '\x1b[32m'
+                echo "==>Passed."
+                printf '\x1b[0m'
+            else
+                printf '\x1b[31m'
+                echo "==>Round trip failed. Please check output files. "
+                printf '\x1b[0m'
+                failed=1
+            fi
+            echo
+        fi
+    done
+    return $failed
+}
+
+# Check if an argument (directory path) is provided
+if [ $# -eq 0 ]; then
+    echo "Usage: $0 <directory_path>"
+    exit 1
+fi
+
+# Call the function with the provided directory path
+process_directory "$1"
@@ -0,0 +1,4 @@
+#ifndef GUARD_IFNDEF_H
+#define GUARD_IFNDEF_H
+int ifndef_value = 1;
+#endif
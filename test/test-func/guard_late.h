@@ -0,0 +1,6 @@
+#ifndef GUARD_LATE_H
+#define GUARD_LATE_H
+#endif
+/* Not guarded: the #endif above is not the last directive */
+#define LATE_VALUE 4
+int late = LATE_VALUE;
@@ -0,0 +1,4 @@
+#ifndef GUARD_PREDEF_H
+#define GUARD_PREDEF_H
+int predef_value = 3;
+#endif
@@ -0,0 +1,14 @@
+/* Multiple inclusion guards detected by SourceCache */
+#include "guard_ifndef.h"
+#include "guard_ifndef.h"
+#include "guard_once.h"
+#include "guard_once.h"
+#define GUARD_PREDEF_H
+#include "guard_predef.h"
+#include "guard_late.h"
+#include "guard_late.h"
+
+int main()
+{
+    return ifndef_value + once_value + late;
+}
@@ -0,0 +1,25 @@
+/* Line markers in the preprocessed output */
+#include "line_marker.h"
+#define ADD(a, b) (a + b)
+
+int main()
+{
+    int a = ADD(1,
+                2);
+    int b = ADD(a,
+                inc(a));
+
+
+    int c = b;
+
+
+
+
+
+
+
+
+
+
+    return a + b + c;
+}
@@ -0,0 +1,4 @@
+int inc(int x)
+{
+    return x + 1;
+}
@@ -0,0 +1,23 @@
+#define SQ(x) ((x) * (x))
+#define ADD(a, b) (a + b)
+#define ZERO() 0
+#define ONE 1
+#define TWICE(f, v) f(f(v))
+#define SELF(x) SELF(x + 1)
+#define APPLY(m, v) m(v)
+#define SUM3(a, b, c) \
+    ((a) + \
+     (b) + (c))
+
+int main()
+{
+    int a = SQ(3);
+    int b = ADD(a, ONE);
+    int c = ZERO() + ZERO ( );
+    int d = TWICE(SQ, b);
+    int e = SELF(c);
+    int f = APPLY(SQ, 4);
+    int g = SUM3((a, b), c, SQ(ADD(1, 2)));
+    int ZERO = 5;
+    return SQ(a + 1) - ADD((a), (b, c));
+}